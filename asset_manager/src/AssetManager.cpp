@@ -96,6 +96,7 @@ namespace AssetSystem
 			itr->second.RefCount--;
 			if (itr->second.RefCount == 0)
 			{
+				// the value tree goes with the record, a tree that was read hands its arena chunks back in one piece
 				OpenedAssets.erase(itr);
 			}
 		}
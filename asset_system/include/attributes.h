@@ -34,6 +34,46 @@ namespace AttributeTypes
         DEFINE_ATTRIBUTE(NoSerializationAttribute)
     };
 
+    // saves the type with the binary TypeIO backend instead of JSON, reading detects the format
+    class BinarySerializationAttribute : public Attribute
+    {
+    public:
+        DEFINE_ATTRIBUTE(BinarySerializationAttribute)
+    };
+
+    // numeric list written to JSON as one base64 string of its raw little endian elements
+    class PackedListAttribute : public Attribute
+    {
+    public:
+        DEFINE_ATTRIBUTE(PackedListAttribute)
+    };
+
+    // numeric list the binary backend may store compressed, only when the writer has CompressLists on, which no
+    // save path does yet. Float32 lists are kept exact unless Bits is set, then they are quantized to Bits over
+    // their own range and come back within half a step, so lists sharing a value may round it differently.
+    // UInt8 lists are predicted from the byte Stride before and run length encoded losslessly.
+    // Other element types and JSON files are written as before
+    class CompressedListAttribute : public Attribute
+    {
+    public:
+        DEFINE_ATTRIBUTE(CompressedListAttribute);
+
+        CompressedListAttribute(int bits = 0, int stride = 1) : Bits(bits), Stride(stride) {}
+
+        int Bits = 0;
+        int Stride = 1;
+    };
+
+    // type list whose elements stay in a binary file until they are first accessed, JSON files still load them all.
+    // the file stays mapped and must not be changed in place until every element has been read.
+    // reading an element, even through a const accessor, fills the list and allocates from the asset's arena
+    // without a lock, so the asset must only be used from one thread while anything is still pending
+    class LazyLoadAttribute : public Attribute
+    {
+    public:
+        DEFINE_ATTRIBUTE(LazyLoadAttribute)
+    };
+
 
     class CustomEditorAttribute : public Attribute
     {
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
 
 namespace Types
 {
@@ -23,8 +25,137 @@ namespace Types
         static Element Field(int index) { return Element{ ElementType::Field, index }; }
         static Element Index(int index) { return Element{ ElementType::Index, index }; }
 
-        std::vector<Element> Elements;
+        static_assert(std::is_trivially_copyable_v<Element>, "elements are moved around as raw bytes");
 
+        // the vector subset paths use, kept inline up to InlineCount elements so common depths never allocate
+        class ElementList
+        {
+        public:
+            static constexpr size_t InlineCount = 8;
+
+            ElementList() = default;
+            ElementList(const ElementList& other) { insert(end(), other.begin(), other.end()); }
+            ElementList(ElementList&& other) noexcept { MoveFrom(other); }
+            ~ElementList() { FreeHeap(); }
+
+            ElementList& operator = (const ElementList& other)
+            {
+                if (this != &other)
+                {
+                    clear();
+                    insert(end(), other.begin(), other.end());
+                }
+                return *this;
+            }
+
+            ElementList& operator = (ElementList&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    FreeHeap();
+                    MoveFrom(other);
+                }
+                return *this;
+            }
+
+            size_t size() const { return Count; }
+            bool empty() const { return Count == 0; }
+            void clear() { Count = 0; }
+
+            Element* begin() { return GetData(); }
+            Element* end() { return GetData() + Count; }
+            const Element* begin() const { return GetData(); }
+            const Element* end() const { return GetData() + Count; }
+
+            Element& operator[] (size_t index) { return GetData()[index]; }
+            const Element& operator[] (size_t index) const { return GetData()[index]; }
+
+            Element& back() { return GetData()[Count - 1]; }
+            const Element& back() const { return GetData()[Count - 1]; }
+
+            void push_back(const Element& element)
+            {
+                Reserve(Count + 1);
+                GetData()[Count++] = element;
+            }
+
+            void pop_back() { Count--; }
+
+            void insert(const Element* at, const Element* first, const Element* last)
+            {
+                size_t offset = size_t(at - begin());
+                size_t count = size_t(last - first);
+                if (count == 0)
+                    return;
+
+                // the source can be this list, copy it out before growing or shifting moves it
+                if (first >= begin() && first < end())
+                {
+                    ElementList copy;
+                    copy.Reserve(count);
+                    memcpy(copy.GetData(), first, count * sizeof(Element));
+                    copy.Count = count;
+
+                    insert(begin() + offset, copy.GetData(), copy.GetData() + count);
+                    return;
+                }
+
+                Reserve(Count + count);
+                Element* data = GetData();
+                memmove(data + offset + count, data + offset, (Count - offset) * sizeof(Element));
+                memcpy(data + offset, first, count * sizeof(Element));
+                Count += count;
+            }
+
+        private:
+            Element* Heap = nullptr;
+            size_t Count = 0;
+            size_t Capacity = InlineCount;
+            alignas(Element) unsigned char InlineStorage[InlineCount * sizeof(Element)];
+
+            Element* GetData() { return Heap ? Heap : reinterpret_cast<Element*>(InlineStorage); }
+            const Element* GetData() const { return Heap ? Heap : reinterpret_cast<const Element*>(InlineStorage); }
+
+            void Reserve(size_t count)
+            {
+                if (count <= Capacity)
+                    return;
+
+                size_t capacity = std::max(count, Capacity * 2);
+                Element* heap = new Element[capacity];
+                memcpy(heap, GetData(), Count * sizeof(Element));
+
+                delete[] Heap;
+                Heap = heap;
+                Capacity = capacity;
+            }
+
+            void FreeHeap()
+            {
+                delete[] Heap;
+                Heap = nullptr;
+                Capacity = InlineCount;
+            }
+
+            void MoveFrom(ElementList& other)
+            {
+                Count = other.Count;
+                if (other.Heap)
+                {
+                    Heap = other.Heap;
+                    Capacity = other.Capacity;
+                    other.Heap = nullptr;
+                    other.Capacity = InlineCount;
+                }
+                else
+                {
+                    memcpy(InlineStorage, other.InlineStorage, Count * sizeof(Element));
+                }
+                other.Count = 0;
+            }
+        };
+
+        ElementList Elements;
 
         void PushFront(const FieldPath& path)
         {
@@ -36,10 +167,26 @@ namespace Types
             Elements.insert(Elements.end(), path.Elements.begin(), path.Elements.end());
         }
 
+        // appends the elements of path last to first, for paths that are built back to front and turned around once
+        void PushBackReversed(const FieldPath& path)
+        {
+            for (size_t i = path.Elements.size(); i > 0; i--)
+                Elements.push_back(path.Elements[i - 1]);
+        }
+
+        void Reverse()
+        {
+            std::reverse(Elements.begin(), Elements.end());
+        }
+
         FieldPath() = default;
 
-        FieldPath(const FieldPath& path) { Elements = path.Elements; }
-        FieldPath(const FieldPath& path, const Element& element) noexcept { Elements = path.Elements; Elements.push_back(element); }
+        FieldPath(const FieldPath& path) = default;
+        FieldPath(FieldPath&& path) noexcept = default;
+        FieldPath& operator = (const FieldPath& path) = default;
+        FieldPath& operator = (FieldPath&& path) noexcept = default;
+
+        FieldPath(const FieldPath& path, const Element& element) noexcept : Elements(path.Elements) { Elements.push_back(element); }
         FieldPath(const Element& element) { Elements.push_back(element); }
         FieldPath(ElementType elementType, int index) { Elements.push_back(Element{ elementType, index }); }
 
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact encodings for lists with the CompressedListAttribute, written by the binary TypeIO backend.
+// Both end in a Rans block, the stages before it only turn the values into small, repetitive bytes.
+namespace ListCodec
+{
+	// the largest list a damaged file can make a decoder allocate
+	constexpr uint32_t MaxCount = 1u << 26;
+
+	// predicted from the left, upper and upper left neighbours when the count is a square grid and from the
+	// previous value otherwise. 0 bits keeps the exact floats, more quantizes to that many bits over the range
+	// of the values. false for values that are not finite, those lists have to be stored raw
+	bool EncodeFloats(const std::vector<float>& values, int bits, std::vector<uint8_t>& out);
+	bool DecodeFloats(const uint8_t* data, size_t size, std::vector<float>& values);
+
+	// each byte is predicted from the one stride before it, so interleaved channels match their own kind,
+	// and the runs of unchanged bytes are run length encoded
+	void EncodeBytes(const std::vector<uint8_t>& values, int stride, std::vector<uint8_t>& out);
+	bool DecodeBytes(const uint8_t* data, size_t size, std::vector<uint8_t>& values);
+}
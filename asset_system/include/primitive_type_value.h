@@ -58,6 +58,14 @@ namespace Types
 
         Events::EventSource<ValueChangedEvent> OnValueChanged;
 
+        bool HasValueChangedListeners() const
+        {
+            if (!OnValueChanged.IsEmpty() && !ValueChangedEvent::IsSuppressed())
+                return true;
+
+            return ParentValue && ParentValue->HasValueChangedListeners();
+        }
+
         void CallValueChanged(ValueChangedEvent& eventRecord)
         {
             eventRecord.Value = ParentValue;
@@ -91,6 +99,12 @@ namespace Types
             if (index >= Values.size())
                 return false;
 
+            if (!HasValueChangedListeners())
+            {
+                Values[index] = newValue;
+                return true;
+            }
+
             ValueChangedEvent eventRecord;
             eventRecord.RecordType = ValueChangedEvent::ValueRecordType::PrimitiveChanged;
             eventRecord.Path = SubPath + FieldPath::Index(int(index));
@@ -114,13 +128,18 @@ namespace Types
 
         inline void Clear() override
         {
-            Values.clear();
+            if (!HasValueChangedListeners())
+            {
+                Values.clear();
+                return;
+            }
 
             ValueChangedEvent eventRecord;
             eventRecord.Path = SubPath;
             eventRecord.RecordType = ValueChangedEvent::ValueRecordType::PrimitiveListCleared;
             eventRecord.Record = std::make_shared<PrimitiveListClearedRecord<T>>();
-            eventRecord.GetRecordAs<PrimitiveListClearedRecord<T>>()->OldValues = Values;
+            eventRecord.GetRecordAs<PrimitiveListClearedRecord<T>>()->OldValues = std::move(Values);
+            Values.clear();
 
             CallValueChanged(eventRecord);
         }
@@ -133,8 +152,11 @@ namespace Types
         {
             Values.resize(Values.size() + 1);
 
+            if (!HasValueChangedListeners())
+                return Values.size() - 1;
+
             ValueChangedEvent eventRecord;
-            eventRecord.Path = SubPath + FieldPath::Index(int(Values.size()));
+            eventRecord.Path = SubPath + FieldPath::Index(int(Values.size() - 1));
             eventRecord.RecordType = ValueChangedEvent::ValueRecordType::PrimitiveListItemAdded;
             eventRecord.Record = std::make_shared<PrimitiveListItemAddedRecord<T>>();
             eventRecord.GetRecordAs<PrimitiveListItemAddedRecord<T>>()->NewValue = Values[Values.size() - 1];
@@ -149,6 +171,12 @@ namespace Types
             if (index >= Values.size())
                 return;
 
+            if (!HasValueChangedListeners())
+            {
+                Values.erase(Values.begin() + index);
+                return;
+            }
+
             ValueChangedEvent eventRecord;
             eventRecord.Path = SubPath + FieldPath::Index(int(index));
             eventRecord.RecordType = ValueChangedEvent::ValueRecordType::PrimitiveListItemRemoved;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Types
+{
+    // Bump allocator for the nodes of one value tree, usually everything a reader loads for an asset.
+    // Nodes are not freed one at a time, the chunks go back in one piece once the owner has let go
+    // and the last node from them is destroyed. Nodes that outlive the tree, like the old value in a
+    // change record, keep the chunks alive until they are gone too.
+    class TypeArena
+    {
+    public:
+        struct Releaser
+        {
+            void operator()(TypeArena* arena) const { arena->Release(); }
+        };
+
+        using Ptr = std::unique_ptr<TypeArena, Releaser>;
+
+        static Ptr Create() { return Ptr(new TypeArena()); }
+
+        // nodes created on this thread come from the arena until the scope ends, a null arena means the heap
+        class Scope
+        {
+        public:
+            Scope(TypeArena* arena);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator = (const Scope&) = delete;
+
+        private:
+            TypeArena* Previous = nullptr;
+        };
+
+        // from the arena of the current scope, or the heap outside of one
+        static void* Allocate(size_t size);
+        static void Free(void* pointer, size_t size);
+
+        size_t GetReservedBytes() const { return ReservedBytes; }
+
+    private:
+        static constexpr size_t FirstChunkSize = 16 * 1024;
+        static constexpr size_t MaxChunkSize = 1024 * 1024;
+
+        std::vector<void*> Chunks;
+        uint8_t* Cursor = nullptr;
+        uint8_t* ChunkEnd = nullptr;
+        size_t NextChunkSize = FirstChunkSize;
+        size_t ReservedBytes = 0;
+
+        // one for the owner and one for every live node
+        std::atomic<size_t> References = 1;
+
+        TypeArena() = default;
+        ~TypeArena();
+
+        void* Bump(size_t size);
+        void Release();
+    };
+}
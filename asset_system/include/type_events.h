@@ -91,6 +91,19 @@ namespace Types
     class ValueChangedEvent
     {
     public:
+        // changes made on this thread while one is alive are not sent, readers fill in whole trees under one
+        class SuppressScope
+        {
+        public:
+            SuppressScope();
+            ~SuppressScope();
+
+            SuppressScope(const SuppressScope&) = delete;
+            SuppressScope& operator = (const SuppressScope&) = delete;
+        };
+
+        static bool IsSuppressed();
+
         TypeValue* Value = nullptr;
         FieldPath Path;
 
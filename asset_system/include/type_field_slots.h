@@ -0,0 +1,97 @@
+#pragma once
+
+#include "type_field_value.h"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace Types
+{
+    // The field storage of a TypeValue, one slot per field of its type in a single block.
+    // A set slot overrides the field default. Small plain primitives are stored in the slot itself,
+    // everything else is a FieldValue owned by the slot.
+    class FieldSlots
+    {
+    public:
+        static constexpr size_t InlineSize = 16;
+
+        template<class T>
+        static constexpr bool IsInline = std::is_trivially_copyable_v<T> && sizeof(T) <= InlineSize && alignof(T) <= alignof(uint64_t);
+
+        FieldSlots() = default;
+        ~FieldSlots() { Reset(0); }
+
+        FieldSlots(const FieldSlots&) = delete;
+        FieldSlots& operator = (const FieldSlots&) = delete;
+
+        // unsets every field and makes room for count
+        void Reset(int count);
+
+        int GetCount() const { return Count; }
+        bool IsEmpty() const { return SetCount == 0; }
+
+        bool IsSet(int index) const
+        {
+            return index >= 0 && index < Count && (GetBits(index)[SetBits] & GetMask(index)) != 0;
+        }
+
+        void Unset(int index);
+
+        // null when the field is not set or is stored inline
+        FieldValue* GetValue(int index) const
+        {
+            if (!IsSet(index) || !(GetBits(index)[OwnedBits] & GetMask(index)))
+                return nullptr;
+
+            return Block[GetSlot(index)].Value;
+        }
+
+        FieldValue* SetValue(int index, std::unique_ptr<FieldValue> value);
+
+        template<class T>
+        const T* GetInline(int index) const
+        {
+            static_assert(IsInline<T>, "only small plain primitives are stored in their slot");
+
+            if (!IsSet(index))
+                return nullptr;
+
+            return std::launder(reinterpret_cast<const T*>(Block[GetSlot(index)].Inline));
+        }
+
+        template<class T>
+        T& SetInline(int index, const T& value)
+        {
+            static_assert(IsInline<T>, "only small plain primitives are stored in their slot");
+
+            Unset(index);
+            GetBits(index)[SetBits] |= GetMask(index);
+            SetCount++;
+
+            return *new (Block[GetSlot(index)].Inline) T(value);
+        }
+
+    private:
+        // the first slots hold the set and owned bits, 64 fields to a slot
+        union Slot
+        {
+            FieldValue* Value;
+            uint64_t Bits[2];
+            alignas(uint64_t) unsigned char Inline[InlineSize];
+        };
+
+        static constexpr int SetBits = 0;
+        static constexpr int OwnedBits = 1;
+
+        Slot* Block = nullptr;
+        int Count = 0;
+        int BitSlots = 0;
+        int SetCount = 0;
+
+        static uint64_t GetMask(int index) { return uint64_t(1) << (index & 63); }
+        uint64_t* GetBits(int index) const { return Block[index >> 6].Bits; }
+        int GetSlot(int index) const { return BitSlots + index; }
+    };
+}
@@ -2,6 +2,7 @@
 
 #include "type_database.h"
 #include "type_events.h"
+#include "type_arena.h"
 #include "field_path.h"
 #include "Events.h"
 #include <map>
@@ -12,6 +13,9 @@ namespace Types
 {
     class FieldValue
     {
+        // lazily read list elements are loaded detached and attached to the list owner afterwards
+        friend class TypeListValue;
+
     protected:
         TypeValue* ParentValue = nullptr;
         FieldPath SubPath;
@@ -24,6 +28,10 @@ namespace Types
         }
         virtual ~FieldValue() = default;
 
+        // value nodes come from the arena of the tree being read, the virtual destructor gives delete the real size
+        static void* operator new(size_t size) { return TypeArena::Allocate(size); }
+        static void operator delete(void* pointer, size_t size) { TypeArena::Free(pointer, size); }
+
         template<typename T>
         inline T* GetAs()
         {
@@ -3,12 +3,15 @@
 #include "type_database.h"
 #include "type_values.h"
 
-#include "rapidjson/document.h"
-
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace Types;
 
+class MappedFile;
+
 namespace TypeIO
 {
 	constexpr char Version[] = "Version";
@@ -17,38 +20,153 @@ namespace TypeIO
 	constexpr char Fields[] = "Fields";
 	constexpr char ValueName[] = "Value";
 
-	class TypeReader
+	// binary files start with these bytes, everything else is read as JSON
+	constexpr char BinaryMagic[4] = { 'T', 'I', 'O', 'B' };
+	constexpr uint32_t BinaryVersion = 3;
+
+	// how a primitive list is stored, since version 3 every list starts with one of these
+	enum class ListEncoding : uint8_t
 	{
-	protected:
-		rapidjson::Document* RootDocument = nullptr;
+		Raw,
+		Floats,
+		Bytes,
+	};
 
-		bool AddPrimtiveField(TypeValue* destinationValue, int fieldIndex, PrimitiveFieldInfo* fieldInfo, rapidjson::Value& jsonValue);
-		bool AddPrimtiveListField(TypeValue* destinationValue, int fieldIndex, PrimitiveFieldInfo* fieldInfo, rapidjson::Value& jsonValue);
-		bool AddEnumerationeField(TypeValue* destinationValue, int fieldIndex, EnumerationFieldInfo* fieldInfo, rapidjson::Value& jsonValue);
-		bool ReadTypeValue(TypeValue* destinationValue, rapidjson::Value& jsonValue);
-		bool ReadTypeListValue(TypeListValue& listValue, rapidjson::Value& jsonValue);
+	// what the CompressedListAttribute lists of one read or write came to
+	struct ListCodecStats
+	{
+		size_t Lists = 0;
+		size_t RawBytes = 0;
+		size_t EncodedBytes = 0;
+		double DecodeMS = 0;
+
+		double GetRatio() const { return EncodedBytes ? double(RawBytes) / double(EncodedBytes) : 1.0; }
+
+		// megabytes of values per second
+		double GetDecodeSpeed() const { return DecodeMS > 0 ? RawBytes / (1024.0 * 1024.0) / (DecodeMS / 1000.0) : 0; }
+	};
 
+	// JSON is streamed through rapidjson's SAX reader and decoded straight into the destination value,
+	// no document is built. Objects must name their type before their fields, as TypeWriter writes them.
+	class TypeReader
+	{
 	public:
+		// parse straight from a memory mapping of the file, buffered reads are the fallback when it can not be mapped
+		bool MapFile = true;
+
+		// leave the elements of LazyLoadAttribute lists in binary files until they are accessed
+		bool DeferLazyLists = true;
+
+		// give the value a new arena for everything read into it, released in one piece with the tree
+		bool UseArena = true;
+
+		// compressed lists decoded by the last read, deferred elements decode later and are not counted
+		ListCodecStats Stats;
+
 		bool Read(TypeValue* value, const std::string& fileName);
 
+	protected:
+		void ReportStats(const ListCodecStats& stats, const std::string& fileName);
 	};
 
+	// Writes straight to the file through rapidjson's writers, no document is built
 	class TypeWriter
 	{
-	protected:
-		rapidjson::Document* RootDocument = nullptr;
+	public:
+		// no indentation or line breaks, for files nobody reads by hand
+		bool Compact = false;
+
+		bool Write(TypeValue* value, const std::string& fileName);
+	};
 
-		rapidjson::Value WriteTypeValue(const TypeValue* value);
-		rapidjson::Value WriteTypeListValue(const TypeListValue* value);
+	// Binary backend, written when an asset type has the BinarySerializationAttribute and read by TypeReader on sight.
+	// A schema of type and field names comes first and values refer to it by index, so fields still match by name
+	// and fields that have since been removed are skipped. Every field is length prefixed, primitive lists are raw
+	// little endian arrays in the byte order of the host. Since version 2 type lists start with a table of element
+	// offsets, which is what lets LazyLoadAttribute lists be skipped and read one element at a time later.
+	class BinaryTypeWriter
+	{
+	protected:
+		std::vector<uint8_t> Body;
 
-		rapidjson::Value WritePrimitiveField(const FieldInfo* fieldInfo, const FieldValue* value);
+		std::vector<const TypeInfo*> SchemaTypes;
+		std::unordered_map<const TypeInfo*, uint32_t> SchemaIndexes;
 
-		rapidjson::Value WriteEnumerationField(const FieldInfo* fieldInfo, const FieldValue* value);
+		uint32_t GetSchemaIndex(const TypeInfo* type);
 
-		bool SetPrimitiveFieldJson(PrimitiveType primType, const FieldValue* value, rapidjson::Value& fieldType, rapidjson::Value& fieldValue);
-		bool SetPrimitiveFieldListJson(PrimitiveType primType, const FieldValue* value, rapidjson::Value& fieldType, rapidjson::Value& fieldValue);
+		bool WritePrimitiveField(PrimitiveType primType, const TypeValue* owner, int index);
+		bool WritePrimitiveListField(PrimitiveType primType, const FieldValue* value);
+		bool WriteCompressedListField(const FieldInfo* fieldInfo, PrimitiveType primType, const FieldValue* value);
+		bool WriteEnumerationField(const FieldInfo* fieldInfo, const FieldValue* value);
+		void WriteTypeValue(const TypeValue* value);
+		void WriteTypeListValue(const TypeListValue* value);
 
 	public:
+		// code CompressedListAttribute lists through ListCodec. Off by default and no save path turns it on yet:
+		// a raw list is read straight out of the mapping far faster than any of them decode, and the codecs
+		// decode slower than JSON parses. Only for files where size matters more than load time
+		bool CompressLists = false;
+
+		ListCodecStats Stats;
+
 		bool Write(TypeValue* value, const std::string& fileName);
 	};
+
+	class BinaryTypeReader
+	{
+		friend class BinaryListSource;
+
+	protected:
+		struct SchemaType
+		{
+			TypeInfo* Type = nullptr;
+
+			// field index in the file to the current field index, -1 for fields the type no longer has
+			std::vector<int> FieldIndexes;
+		};
+		std::vector<SchemaType> Schema;
+
+		uint32_t FileVersion = 0;
+
+		// set when reading from a mapping that deferred lists can keep alive
+		std::shared_ptr<const MappedFile> File;
+
+		const uint8_t* Cursor = nullptr;
+		const uint8_t* End = nullptr;
+
+		bool ReadBytes(void* data, size_t size);
+
+		template<class T>
+		bool ReadRaw(T& value) { return ReadBytes(&value, sizeof(T)); }
+
+		bool ReadString(std::string& value);
+
+		bool ReadSchema();
+
+		template<class T>
+		bool ReadPrimitive(TypeValue* destinationValue, int fieldIndex);
+
+		template<class T>
+		bool ReadPrimitiveList(TypeValue* destinationValue, int fieldIndex, uint32_t count);
+
+		bool ReadPrimitiveField(TypeValue* destinationValue, int fieldIndex, PrimitiveType primType);
+		bool ReadPrimitiveListField(TypeValue* destinationValue, int fieldIndex, PrimitiveType primType);
+		bool ReadCompressedListField(TypeValue* destinationValue, int fieldIndex, PrimitiveType primType, ListEncoding encoding);
+		bool ReadEnumerationField(TypeValue* destinationValue, int fieldIndex, EnumerationFieldInfo* fieldInfo);
+		bool ReadTypeValue(TypeValue* destinationValue);
+		bool ReadTypeListValue(TypeListValue& listValue, bool defer);
+
+	public:
+		bool DeferLazyLists = true;
+		bool UseArena = true;
+
+		ListCodecStats Stats;
+
+		static bool IsBinaryData(const uint8_t* data, size_t size);
+
+		// lists are only deferred when reading from a shared mapping, raw data is always read in full
+		bool Read(TypeValue* value, const uint8_t* data, size_t size);
+		bool Read(TypeValue* value, std::shared_ptr<const MappedFile> file);
+		bool Read(TypeValue* value, const std::string& fileName);
+	};
 }
\ No newline at end of file
@@ -3,10 +3,10 @@
 #include "type_database.h"
 #include "type_events.h"
 #include "type_field_value.h"
+#include "type_field_slots.h"
 #include "primitive_type_value.h"
 #include "field_path.h"
 #include "Events.h"
-#include <map>
 #include <vector>
 #include <iterator>
 
@@ -14,13 +14,33 @@ namespace Types
 {
 	class TypeListValue;
 
-	using TypeValueFieldMap = std::map<int, std::unique_ptr<FieldValue>>;
 	class TypeValue : public FieldValue
 	{
 	protected:
 		const TypeInfo* Type = nullptr;
 
-		TypeValueFieldMap Values;
+		// set on the root of a tree that was read, declared first so the fields are gone before it is released
+		TypeArena::Ptr Arena;
+
+		FieldSlots Values;
+
+		template<typename T>
+		inline void SetFieldPrimitiveStorage(int fieldIndex, const T& value)
+		{
+			if constexpr (FieldSlots::IsInline<T>)
+			{
+				Values.SetInline(fieldIndex, value);
+			}
+			else
+			{
+				auto* fieldValue = static_cast<PrimitiveFieldValue<T>*>(Values.GetValue(fieldIndex));
+				if (!fieldValue)
+					fieldValue = static_cast<PrimitiveFieldValue<T>*>(Values.SetValue(fieldIndex, std::make_unique<PrimitiveFieldValue<T>>(this, FieldPath(FieldPath::Field(fieldIndex)))));
+
+				fieldValue->SetValue(value);
+			}
+		}
+
 	public:
 		size_t ID = 0;
 		void* UserData = nullptr;
@@ -35,21 +55,34 @@ namespace Types
 		const TypeValue* GetParent() const override;
 		void CallValueChanged(ValueChangedEvent& eventRecord);
 
+		// false when a change here would reach nobody, so there is no need to build its record
+		bool HasValueChangedListeners() const;
+
 		void SetType(const TypeInfo* type);
 
 		const TypeInfo* GetType() const { return Type; }
-		const TypeValueFieldMap& GetTypeFieldValues() const { return Values; }
 
-		bool FieldIsDefault(int fieldIndex) const;
+		TypeArena* GetArena() const { return Arena.get(); }
+		void SetArena(TypeArena::Ptr arena) { Arena = std::move(arena); }
+
+		bool FieldIsDefault(int fieldIndex) const { return !Values.IsSet(fieldIndex); }
+
+		// the value of a set field that is not stored inline, null otherwise
+		FieldValue* GetFieldValue(int fieldIndex) { return Values.GetValue(fieldIndex); }
+		const FieldValue* GetFieldValue(int fieldIndex) const { return Values.GetValue(fieldIndex); }
 
 		template<typename T>
-		inline const T& GetFieldPrimitiveValue(int fieldIndex)
+		inline const T& GetFieldPrimitiveValue(int fieldIndex) const
 		{
-			auto itr = Values.find(fieldIndex);
-			if (itr != Values.end())
+			if constexpr (FieldSlots::IsInline<T>)
+			{
+				if (const T* value = Values.GetInline<T>(fieldIndex))
+					return *value;
+			}
+			else
 			{
-				PrimitiveFieldValue<T>* valueItr = reinterpret_cast<PrimitiveFieldValue<T>*>(itr->second.get());
-				return valueItr->GetValue();
+				if (const FieldValue* value = Values.GetValue(fieldIndex))
+					return static_cast<const PrimitiveFieldValue<T>*>(value)->GetValue();
 			}
 
 			const PrimitiveTypeFieldInfo<T>* fieldPtr = Type->GetField<PrimitiveTypeFieldInfo<T>>(fieldIndex);
@@ -59,20 +92,17 @@ namespace Types
 		template<typename T>
 		inline void SetFieldPrimitiveValue(int fieldIndex, const T& value)
 		{
-			auto itr = Values.find(fieldIndex);
-			if (itr == Values.end())
+			if (!HasValueChangedListeners())
 			{
-				FieldPath path(FieldPath::Field(fieldIndex));
-				itr = Values.insert_or_assign(fieldIndex, std::move(std::make_unique<PrimitiveFieldValue<T>>(this, path))).first;
+				SetFieldPrimitiveStorage(fieldIndex, value);
+				return;
 			}
 
-			PrimitiveFieldValue<T>* valueItr = reinterpret_cast<PrimitiveFieldValue<T>*>(itr->second.get());
-
 			ValueChangedEvent eventRecord;
 			eventRecord.Record = std::make_shared<PrimitiveValueChangedRecord<T>>();
-			eventRecord.GetRecordAs<PrimitiveValueChangedRecord<T>>()->OldValue = valueItr->GetValue();
+			eventRecord.GetRecordAs<PrimitiveValueChangedRecord<T>>()->OldValue = GetFieldPrimitiveValue<T>(fieldIndex);
 			eventRecord.GetRecordAs<PrimitiveValueChangedRecord<T>>()->NewValue = value;
-			valueItr->SetValue(value);
+			SetFieldPrimitiveStorage(fieldIndex, value);
 
 			eventRecord.Path.Elements.push_back(FieldPath::Field(fieldIndex));
 			CallValueChanged(eventRecord);
@@ -81,12 +111,8 @@ namespace Types
 		template<typename T>
 		inline T GetFieldEnumerationValue(int fieldIndex)
 		{
-			auto itr = Values.find(fieldIndex);
-			if (itr != Values.end())
-			{
-				EnumerationFieldValue* valueItr = reinterpret_cast<EnumerationFieldValue*>(itr->second.get());
-				return valueItr->GetValueAs<T>();
-			}
+			if (const FieldValue* value = Values.GetValue(fieldIndex))
+				return static_cast<const EnumerationFieldValue*>(value)->GetValueAs<T>();
 
 			const EnumerationFieldInfo* fieldPtr = Type->GetField<EnumerationFieldInfo>(fieldIndex);
 			return T(fieldPtr->DefaultValue);
@@ -95,11 +121,15 @@ namespace Types
 		template<typename T>
 		inline void SetFieldEnumerationValue(int fieldIndex, const T& value)
 		{
-			auto itr = Values.find(fieldIndex);
-			if (itr == Values.end())
-				itr = Values.insert_or_assign(fieldIndex, std::move(std::make_unique<EnumerationFieldValue>(this, SubPath + FieldPath::Field(fieldIndex)))).first;
+			auto* valueItr = static_cast<EnumerationFieldValue*>(Values.GetValue(fieldIndex));
+			if (!valueItr)
+				valueItr = static_cast<EnumerationFieldValue*>(Values.SetValue(fieldIndex, std::make_unique<EnumerationFieldValue>(this, SubPath + FieldPath::Field(fieldIndex))));
 
-			EnumerationFieldValue* valueItr = reinterpret_cast<EnumerationFieldValue*>(itr->second.get());
+			if (!HasValueChangedListeners())
+			{
+				valueItr->SetValueAs(value);
+				return;
+			}
 
 			ValueChangedEvent eventRecord;
 			eventRecord.RecordType = ValueChangedEvent::ValueRecordType::EnumerationChanged;
@@ -112,11 +142,15 @@ namespace Types
 
 		inline void SetFieldEnumerationValueInt(int fieldIndex, const int32_t& value)
 		{
-			auto itr = Values.find(fieldIndex);
-			if (itr == Values.end())
-				itr = Values.insert_or_assign(fieldIndex, std::move(std::make_unique<EnumerationFieldValue>(this, SubPath + FieldPath::Field(fieldIndex)))).first;
+			auto* valueItr = static_cast<EnumerationFieldValue*>(Values.GetValue(fieldIndex));
+			if (!valueItr)
+				valueItr = static_cast<EnumerationFieldValue*>(Values.SetValue(fieldIndex, std::make_unique<EnumerationFieldValue>(this, SubPath + FieldPath::Field(fieldIndex))));
 
-			EnumerationFieldValue* valueItr = reinterpret_cast<EnumerationFieldValue*>(itr->second.get());
+			if (!HasValueChangedListeners())
+			{
+				valueItr->SetValue(value);
+				return;
+			}
 
 			ValueChangedEvent eventRecord;
 			eventRecord.RecordType = ValueChangedEvent::ValueRecordType::EnumerationChanged;
@@ -137,16 +171,7 @@ namespace Types
 		template<typename T>
 		PrimitiveListFieldValue<T>& GetPrimitiveListFieldValue(int fieldIndex)
 		{
-			auto itr = Values.find(fieldIndex);
-			if (itr == Values.end())
-			{
-				const PrimitiveFieldInfo* fieldPtr = Type->GetField<PrimitiveFieldInfo>(fieldIndex);
-
-				auto value = ListFieldValue::Create(fieldPtr->GetPrimitiveType(), this, SubPath + FieldPath::Field(fieldIndex));
-				itr = Values.insert_or_assign(fieldIndex, std::move(value)).first;
-			}
-
-			return *(PrimitiveListFieldValue<T>*)itr->second.get();
+			return static_cast<PrimitiveListFieldValue<T>&>(GetPrimitiveListFieldValue(fieldIndex));
 		}
 
 		ListFieldValue& GetPrimitiveListFieldValue(int fieldIndex);
@@ -155,16 +180,7 @@ namespace Types
 		template<typename T>
 		void PushBackPrimitiveListFieldValue(int fieldIndex, T value)
 		{
-			auto itr = Values.find(fieldIndex);
-			if (itr == Values.end())
-			{
-				const PrimitiveFieldInfo* fieldPtr = Type->GetField<PrimitiveFieldInfo>(fieldIndex);
-
-				auto value = ListFieldValue::Create(fieldPtr->GetPrimitiveType(), this, SubPath + FieldPath::Field(fieldIndex));
-				itr = Values.insert_or_assign(fieldIndex, std::move(value)).first;
-			}
-
-			auto* list = (PrimitiveListFieldValue<T>*)itr->second;
+			auto* list = &GetPrimitiveListFieldValue<T>(fieldIndex);
 			list->push_back(value);
 
 			// add event
@@ -179,7 +195,7 @@ namespace Types
 
 		TypeListValue& GetTypeListFieldValue(int fieldIndex);
 
-		bool IsDefault() const { return Values.empty(); }
+		bool IsDefault() const { return Values.IsEmpty(); }
 
 		template<class T>
 		void SetPrimtiveFieldFromPath(const FieldPath& path, const T& value, int pathIndex = 0)
@@ -234,11 +250,31 @@ namespace Types
 
 	using TypeValueList = std::vector<TypeValue::Ptr>;
 
+	// Where the elements of a lazily read list come from, the list keeps it until every element has been loaded
+	class TypeListSource
+	{
+	public:
+		virtual ~TypeListSource() = default;
+
+		virtual bool LoadElement(size_t sourceIndex, TypeValue* value) = 0;
+	};
+
 	class TypeListValue : public ListFieldValue
 	{
 	protected:
 		const TypeInfo* Type = nullptr;
+
+		// pending elements are null until first accessed, SourceIndexes says where to read each one from
 		TypeValueList Values;
+		std::unique_ptr<TypeListSource> Source;
+		std::vector<size_t> SourceIndexes;
+		size_t PendingCount = 0;
+		bool LoadFailed = false;
+
+		void LoadElement(size_t index);
+		void EraseSourceIndex(size_t index);
+		void ReleaseSource();
+
 	public:
 		TypeListValue(TypeValue* parentValue = nullptr, const FieldPath& path = FieldPath()) : ListFieldValue(parentValue, path) {}
 		TypeListValue(const TypeInfo* t, TypeValue* parentValue = nullptr, const FieldPath& path = FieldPath()) : ListFieldValue(parentValue, path) { Type = t; }
@@ -247,38 +283,69 @@ namespace Types
 
 		const TypeInfo* GetType() const { return Type; }
 
-		TypeValueList& GetValues() { return Values; }
-		const TypeValueList& GetValues() const { return Values; }
+		// replaces the contents with count pending elements that the source reads when they are first accessed
+		void SetSource(std::unique_ptr<TypeListSource> source, size_t count);
 
-		typename std::vector<TypeValue::Ptr>::iterator begin() { return Values.begin(); }
-		typename std::vector<TypeValue::Ptr>::const_iterator begin() const { return Values.cbegin(); }
+		bool IsLoaded(size_t index) const { return Values[index] != nullptr; }
+		size_t GetPendingCount() const { return PendingCount; }
+
+		// true once an element could not be read from the source, it was given its default values instead
+		bool HasLoadFailed() const { return LoadFailed; }
+
+		// the const accessors still read pending elements, so a lazy list must only be used from one thread
+		void LoadAll() const;
+
+		// anything that hands out the whole list loads the whole list
+		TypeValueList& GetValues() { LoadAll(); return Values; }
+		const TypeValueList& GetValues() const { LoadAll(); return Values; }
+
+		typename std::vector<TypeValue::Ptr>::iterator begin() { LoadAll(); return Values.begin(); }
+		typename std::vector<TypeValue::Ptr>::const_iterator begin() const { LoadAll(); return Values.cbegin(); }
 
 		typename std::vector<TypeValue::Ptr>::iterator end() { return Values.end(); }
 		typename std::vector<TypeValue::Ptr>::const_iterator end() const { return Values.cend(); }
 
-		TypeValue& operator[] (size_t index) { return *Values[index].get(); }
+		TypeValue& operator[] (size_t index) { return Get(index); }
 
-		const TypeValue& operator[] (size_t index) const { return *Values[index].get(); }
+		const TypeValue& operator[] (size_t index) const { return Get(index); }
+
+		TypeValue& Get(size_t index)
+		{
+			if (!Values[index])
+				LoadElement(index);
+
+			return *Values[index].get();
+		}
 
-		const TypeValue& Get(size_t index) const { return *Values[index].get(); }
+		const TypeValue& Get(size_t index) const { return const_cast<TypeListValue*>(this)->Get(index); }
 
 		typename std::vector<TypeValue::Ptr>::iterator Erase(typename std::vector<TypeValue::Ptr>::iterator at) 
 		{ 
-			return Values.erase(at);
+			size_t index = size_t(at - Values.begin());
+			EraseSourceIndex(index);
+
+			return Values.erase(Values.begin() + index);
 		}
 
 		void Clear() override 
 		{ 
-			Values.clear(); 
+			PendingCount = 0;
+			ReleaseSource();
+
+			if (!HasValueChangedListeners())
+			{
+				Values.clear();
+				return;
+			}
 
             ValueChangedEvent eventRecord;
             eventRecord.Path = SubPath;
             eventRecord.RecordType = ValueChangedEvent::ValueRecordType::TypeListCleared;
             eventRecord.Record = std::make_shared<TypeListClearedRecord>();
             eventRecord.GetRecordAs<TypeListClearedRecord>()->OldValues = std::move(Values);
+			Values.clear();
 
             CallValueChanged(eventRecord);
-			Values.clear();
 		}
 
 		bool IsEmpty() const override { return Values.empty(); }
@@ -295,6 +362,15 @@ namespace Types
 
 		void Delete(size_t index) override
 		{
+			Get(index);
+			EraseSourceIndex(index);
+
+			if (!HasValueChangedListeners())
+			{
+				Values.erase(Values.begin() + index);
+				return;
+			}
+
             ValueChangedEvent eventRecord;
             eventRecord.Path = SubPath + FieldPath::Index(int(index));
             eventRecord.RecordType = ValueChangedEvent::ValueRecordType::TypeListItemRemoved;
@@ -306,10 +382,15 @@ namespace Types
 
 		TypeValue* PushBack(const TypeInfo* type)
 		{
-			FieldPath childPath = SubPath + FieldPath::Index(int(Values.size()) - 1);
+			FieldPath childPath = SubPath + FieldPath::Index(int(Values.size()));
 			auto value = std::make_unique<TypeValue>(type, ParentValue, childPath);
 			TypeValue* ret = value.get();
 			Values.emplace_back(std::move(value));
+			if (Source)
+				SourceIndexes.push_back(0);
+
+			if (!HasValueChangedListeners())
+				return ret;
 
             ValueChangedEvent eventRecord;
             eventRecord.Path = SubPath + FieldPath::Index(int(Values.size()-1));
@@ -328,6 +409,14 @@ namespace Types
 
         Events::EventSource<ValueChangedEvent> OnValueChanged;
 
+        bool HasValueChangedListeners() const
+        {
+            if (!OnValueChanged.IsEmpty() && !ValueChangedEvent::IsSuppressed())
+                return true;
+
+            return ParentValue && ParentValue->HasValueChangedListeners();
+        }
+
         void CallValueChanged(ValueChangedEvent& eventRecord)
         {
             eventRecord.Value = ParentValue;
@@ -44,6 +44,12 @@ namespace Types
 
 		bool Write(const std::string& fileName)
 		{
+			if (TypePtr && TypePtr->HasAttribute<AttributeTypes::BinarySerializationAttribute>())
+			{
+				TypeIO::BinaryTypeWriter writer;
+				return writer.Write(ValuePtr, fileName);
+			}
+
 			TypeIO::TypeWriter writer;
 			return writer.Write(ValuePtr, fileName);
 		}
@@ -138,6 +144,8 @@ public : \
 
 		size_t Size() const { return ValueList.Size(); }
 
+		bool IsLoaded(size_t index) const { return ValueList.IsLoaded(index); }
+
 		T PushBack()
 		{
 			return T(ValueList.PushBack(ValueList.GetType()));
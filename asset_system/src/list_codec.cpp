@@ -0,0 +1,349 @@
+#include "list_codec.h"
+
+#include "Rans.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//--------------------------------------------------------------
+//   Byte helpers
+//--------------------------------------------------------------
+
+template<class T>
+static void AppendRaw(std::vector<uint8_t>& out, T value)
+{
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T));
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<class T>
+static bool ReadRaw(const uint8_t*& data, const uint8_t* end, T& value)
+{
+	if (size_t(end - data) < sizeof(T))
+		return false;
+
+	memcpy(&value, data, sizeof(T));
+	data += sizeof(T);
+	return true;
+}
+
+// small magnitudes of either sign end up as small unsigned numbers, and those as single bytes
+static void AppendResidual(std::vector<uint8_t>& out, int32_t residual)
+{
+	uint32_t value = (uint32_t(residual) << 1) ^ uint32_t(residual >> 31);
+	while (value >= 0x80)
+	{
+		out.push_back(uint8_t(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(uint8_t(value));
+}
+
+static bool ReadResidual(const uint8_t*& data, const uint8_t* end, int32_t& residual)
+{
+	uint32_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (data == end)
+			return false;
+
+		uint8_t byte = *data++;
+		value |= uint32_t(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			residual = int32_t(value >> 1) ^ -int32_t(value & 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+// width of the square grid the values form, 0 when they do not
+static uint32_t GetGridWidth(size_t count)
+{
+	uint32_t width = uint32_t(std::lround(std::sqrt(double(count))));
+	return width > 1 && size_t(width) * width == count ? width : 0;
+}
+
+// works on quantized heights and on the ordered bits of exact floats alike, the wrap around of the
+// unsigned sums cancels out again when the residual is added back
+static uint32_t Predict(const uint32_t* values, size_t index, uint32_t width)
+{
+	if (index == 0)
+		return 0;
+
+	if (width == 0)
+		return values[index - 1];
+
+	size_t x = index % width;
+	size_t y = index / width;
+	if (y == 0)
+		return values[index - 1];
+	if (x == 0)
+		return values[index - width];
+
+	// the plane through the three neighbours, exact on slopes
+	return values[index - 1] + values[index - width] - values[index - width - 1];
+}
+
+// float bits as an unsigned number that grows with the value, so close floats are close numbers
+static uint32_t ToOrderedBits(float value)
+{
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(float));
+	return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+static float FromOrderedBits(uint32_t bits)
+{
+	bits = bits & 0x80000000u ? bits & 0x7FFFFFFFu : ~bits;
+
+	float value = 0;
+	memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+// what a list decodes through on the way to its values, kept so a file of many lists does not allocate for each
+static thread_local std::vector<uint8_t> DecodeBytesScratch;
+static thread_local std::vector<uint32_t> DecodeCodedScratch;
+
+//--------------------------------------------------------------
+//   Floats
+//--------------------------------------------------------------
+
+bool ListCodec::EncodeFloats(const std::vector<float>& values, int bits, std::vector<uint8_t>& out)
+{
+	bits = std::clamp(bits, 0, 24);
+
+	float minValue = values.empty() ? 0.0f : values[0];
+	float maxValue = minValue;
+	for (float value : values)
+	{
+		if (!std::isfinite(value))
+			return false;
+
+		minValue = std::min(minValue, value);
+		maxValue = std::max(maxValue, value);
+	}
+
+	uint32_t width = GetGridWidth(values.size());
+
+	AppendRaw(out, uint32_t(values.size()));
+	AppendRaw(out, uint8_t(bits));
+	AppendRaw(out, width);
+
+	std::vector<uint32_t> coded(values.size());
+	if (bits == 0)
+	{
+		for (size_t i = 0; i < values.size(); i++)
+			coded[i] = ToOrderedBits(values[i]);
+	}
+	else
+	{
+		AppendRaw(out, minValue);
+		AppendRaw(out, maxValue);
+
+		int32_t maxQuantized = (1 << bits) - 1;
+		double range = double(maxValue) - double(minValue);
+		double scale = range > 0 ? maxQuantized / range : 0;
+
+		for (size_t i = 0; i < values.size(); i++)
+			coded[i] = uint32_t(std::clamp(int32_t(std::lround((double(values[i]) - minValue) * scale)), 0, maxQuantized));
+	}
+
+	std::vector<uint8_t> residuals;
+	residuals.reserve(values.size() * 2);
+	for (size_t i = 0; i < values.size(); i++)
+		AppendResidual(residuals, int32_t(coded[i] - Predict(coded.data(), i, width)));
+
+	Rans::Encode(residuals.data(), residuals.size(), out);
+	return true;
+}
+
+bool ListCodec::DecodeFloats(const uint8_t* data, size_t size, std::vector<float>& values)
+{
+	const uint8_t* end = data + size;
+
+	uint32_t count = 0;
+	uint8_t bits = 0;
+	uint32_t width = 0;
+	if (!ReadRaw(data, end, count) || !ReadRaw(data, end, bits) || !ReadRaw(data, end, width))
+		return false;
+
+	if (count > MaxCount || bits > 24 || width != GetGridWidth(count))
+		return false;
+
+	float minValue = 0;
+	float maxValue = 0;
+	if (bits > 0 && (!ReadRaw(data, end, minValue) || !ReadRaw(data, end, maxValue)))
+		return false;
+
+	// a residual is at most 5 bytes
+	std::vector<uint8_t>& residuals = DecodeBytesScratch;
+	if (!Rans::Decode(data, size_t(end - data), size_t(count) * 5, residuals))
+		return false;
+
+	std::vector<uint32_t>& codedValues = DecodeCodedScratch;
+	codedValues.resize(count);
+	uint32_t* coded = codedValues.data();
+
+	uint32_t maxCoded = bits > 0 ? (1u << bits) - 1 : UINT32_MAX;
+	const uint8_t* residual = residuals.data();
+	const uint8_t* residualEnd = residual + residuals.size();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		int32_t delta = 0;
+		if (!ReadResidual(residual, residualEnd, delta))
+			return false;
+
+		uint32_t value = Predict(coded, i, width) + uint32_t(delta);
+		if (value > maxCoded)
+			return false;
+
+		coded[i] = value;
+	}
+
+	if (residual != residualEnd)
+		return false;
+
+	values.resize(count);
+	if (bits == 0)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			values[i] = FromOrderedBits(coded[i]);
+	}
+	else
+	{
+		double range = double(maxValue) - double(minValue);
+		double step = range > 0 ? range / ((1u << bits) - 1) : 0;
+		for (uint32_t i = 0; i < count; i++)
+			values[i] = float(minValue + coded[i] * step);
+	}
+
+	return true;
+}
+
+//--------------------------------------------------------------
+//   Bytes
+//--------------------------------------------------------------
+
+// control bytes below this start a literal span of control + 1 bytes, the rest a run of control - RunControl + MinRun
+static constexpr uint8_t RunControl = 128;
+static constexpr size_t MinRun = 3;
+static constexpr size_t MaxRun = 255 - RunControl + MinRun;
+static constexpr size_t MaxLiterals = RunControl;
+
+void ListCodec::EncodeBytes(const std::vector<uint8_t>& values, int stride, std::vector<uint8_t>& out)
+{
+	stride = std::clamp(stride, 1, 255);
+
+	AppendRaw(out, uint32_t(values.size()));
+	AppendRaw(out, uint8_t(stride));
+
+	std::vector<uint8_t> deltas(values.size());
+	for (size_t i = 0; i < values.size(); i++)
+		deltas[i] = uint8_t(values[i] - (i >= size_t(stride) ? values[i - stride] : 0));
+
+	std::vector<uint8_t> tokens;
+	tokens.reserve(values.size() / 4 + 16);
+
+	size_t i = 0;
+	size_t literalStart = 0;
+	auto flushLiterals = [&](size_t literalEnd)
+	{
+		while (literalStart < literalEnd)
+		{
+			size_t length = std::min(literalEnd - literalStart, MaxLiterals);
+			tokens.push_back(uint8_t(length - 1));
+			tokens.insert(tokens.end(), deltas.begin() + literalStart, deltas.begin() + literalStart + length);
+			literalStart += length;
+		}
+	};
+
+	while (i < deltas.size())
+	{
+		size_t run = 1;
+		while (i + run < deltas.size() && run < MaxRun && deltas[i + run] == deltas[i])
+			run++;
+
+		if (run < MinRun)
+		{
+			i += run;
+			continue;
+		}
+
+		flushLiterals(i);
+		tokens.push_back(uint8_t(RunControl + run - MinRun));
+		tokens.push_back(deltas[i]);
+		i += run;
+		literalStart = i;
+	}
+	flushLiterals(deltas.size());
+
+	Rans::Encode(tokens.data(), tokens.size(), out);
+}
+
+bool ListCodec::DecodeBytes(const uint8_t* data, size_t size, std::vector<uint8_t>& values)
+{
+	const uint8_t* end = data + size;
+
+	uint32_t count = 0;
+	uint8_t stride = 0;
+	if (!ReadRaw(data, end, count) || !ReadRaw(data, end, stride))
+		return false;
+
+	if (count > MaxCount || stride == 0)
+		return false;
+
+	// every literal span adds one control byte
+	std::vector<uint8_t>& tokens = DecodeBytesScratch;
+	if (!Rans::Decode(data, size_t(end - data), size_t(count) + count / MaxLiterals + 1, tokens))
+		return false;
+
+	values.resize(count);
+
+	const uint8_t* token = tokens.data();
+	const uint8_t* tokenEnd = token + tokens.size();
+	size_t i = 0;
+	while (token < tokenEnd)
+	{
+		uint8_t control = *token++;
+		if (control < RunControl)
+		{
+			size_t length = size_t(control) + 1;
+			if (size_t(tokenEnd - token) < length || count - i < length)
+				return false;
+
+			memcpy(values.data() + i, token, length);
+			token += length;
+			i += length;
+		}
+		else
+		{
+			size_t length = size_t(control) - RunControl + MinRun;
+			if (token == tokenEnd || count - i < length)
+				return false;
+
+			memset(values.data() + i, *token++, length);
+			i += length;
+		}
+	}
+
+	if (i != count)
+		return false;
+
+	// one running sum per channel, summing through the array would wait on the store of the byte before
+	for (size_t channel = 0; channel < stride; channel++)
+	{
+		uint8_t sum = 0;
+		for (size_t v = channel; v < count; v += stride)
+		{
+			sum = uint8_t(sum + values[v]);
+			values[v] = sum;
+		}
+	}
+
+	return true;
+}
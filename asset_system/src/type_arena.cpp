@@ -0,0 +1,162 @@
+#include "type_arena.h"
+
+#include "MemoryStats.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+
+using namespace Types;
+
+namespace
+{
+    constexpr size_t AlignSize(size_t size)
+    {
+        return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    }
+
+    thread_local TypeArena* CurrentArena = nullptr;
+
+    // nodes carry no header, freeing finds the arena a node came from by the chunk it is in.
+    // anything outside the span of every chunk so far is a heap node and skips the lock
+    struct ChunkRange
+    {
+        uintptr_t End = 0;
+        TypeArena* Arena = nullptr;
+    };
+
+    struct ChunkMap
+    {
+        std::shared_mutex Lock;
+        std::map<uintptr_t, ChunkRange> Ranges;
+        std::atomic<uintptr_t> Lowest = UINTPTR_MAX;
+        std::atomic<uintptr_t> HighestEnd = 0;
+    };
+
+    // never destroyed, values in statics are still freed after everything else has shut down
+    ChunkMap& GetChunkMap()
+    {
+        static ChunkMap* chunks = new ChunkMap();
+        return *chunks;
+    }
+
+    void AddChunk(void* chunk, size_t size, TypeArena* arena)
+    {
+        ChunkMap& chunks = GetChunkMap();
+        uintptr_t start = uintptr_t(chunk);
+
+        std::unique_lock<std::shared_mutex> guard(chunks.Lock);
+        chunks.Ranges[start] = ChunkRange{ start + size, arena };
+
+        if (start < chunks.Lowest)
+            chunks.Lowest = start;
+        if (start + size > chunks.HighestEnd)
+            chunks.HighestEnd = start + size;
+    }
+
+    void RemoveChunk(void* chunk)
+    {
+        ChunkMap& chunks = GetChunkMap();
+        std::unique_lock<std::shared_mutex> guard(chunks.Lock);
+        chunks.Ranges.erase(uintptr_t(chunk));
+    }
+
+    TypeArena* FindArena(void* pointer)
+    {
+        ChunkMap& chunks = GetChunkMap();
+        uintptr_t address = uintptr_t(pointer);
+        if (address < chunks.Lowest || address >= chunks.HighestEnd)
+            return nullptr;
+
+        std::shared_lock<std::shared_mutex> guard(chunks.Lock);
+        auto range = chunks.Ranges.upper_bound(address);
+        if (range == chunks.Ranges.begin())
+            return nullptr;
+
+        --range;
+        return address < range->second.End ? range->second.Arena : nullptr;
+    }
+}
+
+TypeArena::Scope::Scope(TypeArena* arena)
+    : Previous(CurrentArena)
+{
+    CurrentArena = arena;
+}
+
+TypeArena::Scope::~Scope()
+{
+    CurrentArena = Previous;
+}
+
+void* TypeArena::Allocate(size_t size)
+{
+    TypeArena* arena = CurrentArena;
+    if (!arena)
+    {
+        MemoryStats::Add(MemoryStats::Category::TypeValues, int64_t(size));
+        return ::operator new(size);
+    }
+
+    // arena nodes are padded so the next one stays aligned, that padding is theirs
+    size = AlignSize(size);
+    MemoryStats::Add(MemoryStats::Category::TypeValues, int64_t(size));
+
+    void* node = arena->Bump(size);
+    arena->References++;
+    return node;
+}
+
+void TypeArena::Free(void* pointer, size_t size)
+{
+    if (!pointer)
+        return;
+
+    TypeArena* arena = FindArena(pointer);
+    if (!arena)
+    {
+        MemoryStats::Remove(MemoryStats::Category::TypeValues, int64_t(size));
+        ::operator delete(pointer);
+        return;
+    }
+
+    MemoryStats::Remove(MemoryStats::Category::TypeValues, int64_t(AlignSize(size)));
+    arena->Release();
+}
+
+TypeArena::~TypeArena()
+{
+    for (void* chunk : Chunks)
+    {
+        RemoveChunk(chunk);
+        ::operator delete(chunk);
+    }
+}
+
+void* TypeArena::Bump(size_t size)
+{
+    if (size_t(ChunkEnd - Cursor) < size)
+    {
+        // chunks grow with the tree so small values stay small and large ones take few chunks
+        size_t chunkSize = std::max(NextChunkSize, size);
+        NextChunkSize = std::min(NextChunkSize * 2, MaxChunkSize);
+
+        Cursor = static_cast<uint8_t*>(::operator new(chunkSize));
+        ChunkEnd = Cursor + chunkSize;
+        Chunks.push_back(Cursor);
+        AddChunk(Cursor, chunkSize, this);
+        ReservedBytes += chunkSize;
+    }
+
+    void* block = Cursor;
+    Cursor += size;
+    return block;
+}
+
+void TypeArena::Release()
+{
+    if (--References == 0)
+        delete this;
+}
@@ -0,0 +1,56 @@
+#include "type_field_slots.h"
+
+using namespace Types;
+
+void FieldSlots::Reset(int count)
+{
+    for (int index = 0; index < Count; index++)
+        Unset(index);
+
+    if (Block)
+    {
+        TypeArena::Free(Block, sizeof(Slot) * (BitSlots + Count));
+        Block = nullptr;
+    }
+
+    Count = count;
+    BitSlots = (count + 63) / 64;
+    if (count == 0)
+        return;
+
+    // from the same arena as the value that owns them
+    Block = static_cast<Slot*>(TypeArena::Allocate(sizeof(Slot) * (BitSlots + Count)));
+    std::uninitialized_default_construct_n(Block, BitSlots + Count);
+
+    for (int bits = 0; bits < BitSlots; bits++)
+    {
+        Block[bits].Bits[SetBits] = 0;
+        Block[bits].Bits[OwnedBits] = 0;
+    }
+}
+
+void FieldSlots::Unset(int index)
+{
+    if (!IsSet(index))
+        return;
+
+    uint64_t* bits = GetBits(index);
+    if (bits[OwnedBits] & GetMask(index))
+        delete Block[GetSlot(index)].Value;
+
+    bits[SetBits] &= ~GetMask(index);
+    bits[OwnedBits] &= ~GetMask(index);
+    SetCount--;
+}
+
+FieldValue* FieldSlots::SetValue(int index, std::unique_ptr<FieldValue> value)
+{
+    Unset(index);
+
+    uint64_t* bits = GetBits(index);
+    bits[SetBits] |= GetMask(index);
+    bits[OwnedBits] |= GetMask(index);
+    SetCount++;
+
+    return Block[GetSlot(index)].Value = value.release();
+}
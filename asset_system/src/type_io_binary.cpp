@@ -0,0 +1,832 @@
+#include "type_io.h"
+
+#include "field_info.h"
+#include "attributes.h"
+#include "Profiler.h"
+#include "MappedFile.h"
+#include "MemoryStats.h"
+#include "list_codec.h"
+
+#include "raylib.h"
+
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+using namespace TypeIO;
+
+// sizes in the file, a field records its length so readers can skip it
+using FieldLength = uint64_t;
+static constexpr uint32_t NoSchemaType = uint32_t(-1);
+
+//--------------------------------------------------------------
+//   Byte helpers
+//--------------------------------------------------------------
+
+template<class T>
+static void AppendRaw(std::vector<uint8_t>& buffer, const T& value)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "only plain data can be written raw");
+
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+static void AppendString(std::vector<uint8_t>& buffer, const std::string& value)
+{
+	AppendRaw(buffer, uint32_t(value.size()));
+	buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+template<class T>
+static void AppendPrimitive(std::vector<uint8_t>& buffer, const TypeValue* owner, int index)
+{
+	AppendRaw(buffer, owner->GetFieldPrimitiveValue<T>(index));
+}
+
+template<>
+void AppendPrimitive<bool>(std::vector<uint8_t>& buffer, const TypeValue* owner, int index)
+{
+	AppendRaw(buffer, uint8_t(owner->GetFieldPrimitiveValue<bool>(index) ? 1 : 0));
+}
+
+template<>
+void AppendPrimitive<std::string>(std::vector<uint8_t>& buffer, const TypeValue* owner, int index)
+{
+	AppendString(buffer, owner->GetFieldPrimitiveValue<std::string>(index));
+}
+
+template<class T>
+static void AppendPrimitiveList(std::vector<uint8_t>& buffer, const FieldValue* value)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "only plain data can be written raw");
+
+	const std::vector<T>& values = static_cast<const PrimitiveListFieldValue<T>*>(value)->GetValues();
+	AppendRaw(buffer, uint32_t(values.size()));
+
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+	buffer.insert(buffer.end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+template<>
+void AppendPrimitiveList<bool>(std::vector<uint8_t>& buffer, const FieldValue* value)
+{
+	const std::vector<bool>& values = static_cast<const PrimitiveListFieldValue<bool>*>(value)->GetValues();
+	AppendRaw(buffer, uint32_t(values.size()));
+
+	for (bool item : values)
+		buffer.push_back(item ? 1 : 0);
+}
+
+template<>
+void AppendPrimitiveList<std::string>(std::vector<uint8_t>& buffer, const FieldValue* value)
+{
+	const std::vector<std::string>& values = static_cast<const PrimitiveListFieldValue<std::string>*>(value)->GetValues();
+	AppendRaw(buffer, uint32_t(values.size()));
+
+	for (const auto& item : values)
+		AppendString(buffer, item);
+}
+
+//--------------------------------------------------------------
+//   BinaryTypeWriter
+//--------------------------------------------------------------
+
+uint32_t BinaryTypeWriter::GetSchemaIndex(const TypeInfo* type)
+{
+	if (!type)
+		return NoSchemaType;
+
+	auto itr = SchemaIndexes.find(type);
+	if (itr != SchemaIndexes.end())
+		return itr->second;
+
+	uint32_t index = uint32_t(SchemaTypes.size());
+	SchemaTypes.push_back(type);
+	SchemaIndexes.insert_or_assign(type, index);
+	return index;
+}
+
+bool BinaryTypeWriter::WritePrimitiveField(PrimitiveType primType, const TypeValue* owner, int index)
+{
+	switch (primType)
+	{
+	default:
+	case PrimitiveType::Unknown:
+		return false;
+
+	case PrimitiveType::Bool:		AppendPrimitive<bool>(Body, owner, index); break;
+	case PrimitiveType::Char:		AppendPrimitive<char>(Body, owner, index); break;
+	case PrimitiveType::UInt8:		AppendPrimitive<uint8_t>(Body, owner, index); break;
+	case PrimitiveType::UInt16:		AppendPrimitive<uint16_t>(Body, owner, index); break;
+	case PrimitiveType::Int16:		AppendPrimitive<int16_t>(Body, owner, index); break;
+	case PrimitiveType::UInt32:		AppendPrimitive<uint32_t>(Body, owner, index); break;
+	case PrimitiveType::Int32:		AppendPrimitive<int32_t>(Body, owner, index); break;
+	case PrimitiveType::UInt64:		AppendPrimitive<uint64_t>(Body, owner, index); break;
+	case PrimitiveType::Int64:		AppendPrimitive<int64_t>(Body, owner, index); break;
+	case PrimitiveType::Float32:	AppendPrimitive<float>(Body, owner, index); break;
+	case PrimitiveType::Double64:	AppendPrimitive<double>(Body, owner, index); break;
+	case PrimitiveType::String:		AppendPrimitive<std::string>(Body, owner, index); break;
+	case PrimitiveType::Vector2:	AppendPrimitive<Vector2>(Body, owner, index); break;
+	case PrimitiveType::Vector3:	AppendPrimitive<Vector3>(Body, owner, index); break;
+	case PrimitiveType::Vector4:	AppendPrimitive<Vector4>(Body, owner, index); break;
+	case PrimitiveType::Rectangle:	AppendPrimitive<Rectangle>(Body, owner, index); break;
+	case PrimitiveType::Matrix:		AppendPrimitive<Matrix>(Body, owner, index); break;
+	case PrimitiveType::GUID:		AppendPrimitive<Hashes::GUID>(Body, owner, index); break;
+	case PrimitiveType::Color:		AppendPrimitive<Color>(Body, owner, index); break;
+	}
+
+	return true;
+}
+
+bool BinaryTypeWriter::WriteCompressedListField(const FieldInfo* fieldInfo, PrimitiveType primType, const FieldValue* value)
+{
+	const auto* compressed = fieldInfo->GetAttribute<AttributeTypes::CompressedListAttribute>();
+	if (!compressed || !CompressLists)
+		return false;
+
+	size_t start = Body.size();
+	size_t rawBytes = 0;
+
+	if (primType == PrimitiveType::Float32)
+	{
+		const std::vector<float>& values = static_cast<const PrimitiveListFieldValue<float>*>(value)->GetValues();
+		AppendRaw(Body, ListEncoding::Floats);
+		if (!ListCodec::EncodeFloats(values, compressed->Bits, Body))
+		{
+			Body.resize(start);
+			return false;
+		}
+		rawBytes = values.size() * sizeof(float);
+	}
+	else if (primType == PrimitiveType::UInt8)
+	{
+		const std::vector<uint8_t>& values = static_cast<const PrimitiveListFieldValue<uint8_t>*>(value)->GetValues();
+		AppendRaw(Body, ListEncoding::Bytes);
+		ListCodec::EncodeBytes(values, compressed->Stride, Body);
+		rawBytes = values.size();
+	}
+	else
+	{
+		return false;
+	}
+
+	Stats.Lists++;
+	Stats.RawBytes += rawBytes;
+	Stats.EncodedBytes += Body.size() - start;
+	return true;
+}
+
+bool BinaryTypeWriter::WritePrimitiveListField(PrimitiveType primType, const FieldValue* value)
+{
+	AppendRaw(Body, ListEncoding::Raw);
+
+	switch (primType)
+	{
+	default:
+	case PrimitiveType::Unknown:
+		return false;
+
+	case PrimitiveType::Bool:		AppendPrimitiveList<bool>(Body, value); break;
+	case PrimitiveType::Char:		AppendPrimitiveList<char>(Body, value); break;
+	case PrimitiveType::UInt8:		AppendPrimitiveList<uint8_t>(Body, value); break;
+	case PrimitiveType::UInt16:		AppendPrimitiveList<uint16_t>(Body, value); break;
+	case PrimitiveType::Int16:		AppendPrimitiveList<int16_t>(Body, value); break;
+	case PrimitiveType::UInt32:		AppendPrimitiveList<uint32_t>(Body, value); break;
+	case PrimitiveType::Int32:		AppendPrimitiveList<int32_t>(Body, value); break;
+	case PrimitiveType::UInt64:		AppendPrimitiveList<uint64_t>(Body, value); break;
+	case PrimitiveType::Int64:		AppendPrimitiveList<int64_t>(Body, value); break;
+	case PrimitiveType::Float32:	AppendPrimitiveList<float>(Body, value); break;
+	case PrimitiveType::Double64:	AppendPrimitiveList<double>(Body, value); break;
+	case PrimitiveType::String:		AppendPrimitiveList<std::string>(Body, value); break;
+	case PrimitiveType::Vector2:	AppendPrimitiveList<Vector2>(Body, value); break;
+	case PrimitiveType::Vector3:	AppendPrimitiveList<Vector3>(Body, value); break;
+	case PrimitiveType::Vector4:	AppendPrimitiveList<Vector4>(Body, value); break;
+	case PrimitiveType::Rectangle:	AppendPrimitiveList<Rectangle>(Body, value); break;
+	case PrimitiveType::Matrix:		AppendPrimitiveList<Matrix>(Body, value); break;
+	case PrimitiveType::GUID:		AppendPrimitiveList<Hashes::GUID>(Body, value); break;
+	case PrimitiveType::Color:		AppendPrimitiveList<Color>(Body, value); break;
+	}
+
+	return true;
+}
+
+bool BinaryTypeWriter::WriteEnumerationField(const FieldInfo* fieldInfo, const FieldValue* value)
+{
+	const EnumerationFieldInfo* enumFieldInfo = static_cast<const EnumerationFieldInfo*>(fieldInfo);
+	const EnumerationFieldValue* enumFieldValue = static_cast<const EnumerationFieldValue*>(value);
+
+	// by name like the JSON files, so reordering an enum does not change what loads
+	auto itr = enumFieldInfo->TypePtr->Values.find(enumFieldValue->GetValue());
+	if (itr == enumFieldInfo->TypePtr->Values.end())
+		return false;
+
+	AppendString(Body, itr->second);
+	return true;
+}
+
+void BinaryTypeWriter::WriteTypeValue(const TypeValue* value)
+{
+	const TypeInfo* type = value->GetType();
+	AppendRaw(Body, GetSchemaIndex(type));
+
+	size_t countOffset = Body.size();
+	AppendRaw(Body, uint32_t(0));
+
+	if (!type)
+		return;
+
+	uint32_t fieldCount = 0;
+	int typeFieldCount = type->GetFieldCount();
+	for (int index = 0; index < typeFieldCount; index++)
+	{
+		if (value->FieldIsDefault(index))
+			continue;
+
+		const FieldInfo* fieldInfo = type->GetField(index);
+		const FieldValue* fieldValue = value->GetFieldValue(index);
+		FieldType fieldType = fieldInfo->GetType();
+
+		PrimitiveType primType = PrimitiveType::Unknown;
+		if (fieldInfo->IsPrimtive())
+			primType = static_cast<const PrimitiveFieldInfo*>(fieldInfo)->GetPrimitiveType();
+
+		size_t fieldStart = Body.size();
+		AppendRaw(Body, uint32_t(index));
+		AppendRaw(Body, uint8_t(fieldType));
+		AppendRaw(Body, uint8_t(primType));
+
+		size_t lengthOffset = Body.size();
+		AppendRaw(Body, FieldLength(0));
+
+		bool written = true;
+		switch (fieldType)
+		{
+		case FieldType::Primitive:
+			written = WritePrimitiveField(primType, value, index);
+			break;
+
+		case FieldType::PrimitiveList:
+			written = WriteCompressedListField(fieldInfo, primType, fieldValue) || WritePrimitiveListField(primType, fieldValue);
+			break;
+
+		case FieldType::Enumeration:
+			written = WriteEnumerationField(fieldInfo, fieldValue);
+			break;
+
+		case FieldType::Type:
+			WriteTypeValue(static_cast<const TypeValue*>(fieldValue));
+			break;
+
+		case FieldType::TypeList:
+			WriteTypeListValue(static_cast<const TypeListValue*>(fieldValue));
+			break;
+
+		default:
+			written = false;
+			break;
+		}
+
+		if (!written)
+		{
+			Body.resize(fieldStart);
+			continue;
+		}
+
+		FieldLength length = FieldLength(Body.size() - lengthOffset - sizeof(FieldLength));
+		memcpy(Body.data() + lengthOffset, &length, sizeof(FieldLength));
+		fieldCount++;
+	}
+
+	memcpy(Body.data() + countOffset, &fieldCount, sizeof(uint32_t));
+}
+
+void BinaryTypeWriter::WriteTypeListValue(const TypeListValue* value)
+{
+	AppendRaw(Body, GetSchemaIndex(value->GetType()));
+	AppendRaw(Body, uint32_t(value->Size()));
+
+	// where each element starts, counted from the end of the table
+	size_t tableOffset = Body.size();
+	Body.resize(Body.size() + value->Size() * sizeof(FieldLength));
+	size_t elementsStart = Body.size();
+
+	for (size_t i = 0; i < value->Size(); i++)
+	{
+		FieldLength offset = FieldLength(Body.size() - elementsStart);
+		memcpy(Body.data() + tableOffset + i * sizeof(FieldLength), &offset, sizeof(FieldLength));
+
+		WriteTypeValue(&value->Get(i));
+	}
+}
+
+bool BinaryTypeWriter::Write(TypeValue* value, const std::string& fileName)
+{
+	PROFILE_SCOPE("BinaryTypeWriter::Write");
+
+	Body.clear();
+	SchemaTypes.clear();
+	SchemaIndexes.clear();
+	Stats = ListCodecStats();
+
+	// the body goes first so the schema only holds the types that are used
+	WriteTypeValue(value);
+
+	std::vector<uint8_t> header;
+	header.insert(header.end(), BinaryMagic, BinaryMagic + sizeof(BinaryMagic));
+	AppendRaw(header, BinaryVersion);
+
+	AppendRaw(header, uint32_t(SchemaTypes.size()));
+	for (const TypeInfo* type : SchemaTypes)
+	{
+		AppendString(header, type->TypeName);
+
+		int fieldCount = type->GetFieldCount();
+		AppendRaw(header, uint32_t(fieldCount));
+		for (int i = 0; i < fieldCount; i++)
+			AppendString(header, type->GetField(i)->GetName());
+	}
+
+	FILE* fp = fopen(fileName.c_str(), "wb");
+	if (!fp)
+		return false;
+
+	bool ok = fwrite(header.data(), header.size(), 1, fp) == 1 && fwrite(Body.data(), Body.size(), 1, fp) == 1;
+	fclose(fp);
+
+	if (ok && Stats.Lists > 0)
+	{
+		TraceLog(LOG_INFO, "TypeIO: %s compressed %d lists from %s to %s (%.1fx)", fileName.c_str(), int(Stats.Lists),
+			MemoryStats::FormatBytes(Stats.RawBytes).c_str(), MemoryStats::FormatBytes(Stats.EncodedBytes).c_str(), Stats.GetRatio());
+	}
+
+	return ok;
+}
+
+//--------------------------------------------------------------
+//   BinaryTypeReader
+//--------------------------------------------------------------
+
+bool BinaryTypeReader::ReadBytes(void* data, size_t size)
+{
+	if (size_t(End - Cursor) < size)
+		return false;
+
+	memcpy(data, Cursor, size);
+	Cursor += size;
+	return true;
+}
+
+bool BinaryTypeReader::ReadString(std::string& value)
+{
+	uint32_t size = 0;
+	if (!ReadRaw(size) || size_t(End - Cursor) < size)
+		return false;
+
+	value.assign(reinterpret_cast<const char*>(Cursor), size);
+	Cursor += size;
+	return true;
+}
+
+bool BinaryTypeReader::ReadSchema()
+{
+	uint32_t typeCount = 0;
+	if (!ReadRaw(typeCount))
+		return false;
+
+	Schema.clear();
+	for (uint32_t t = 0; t < typeCount; t++)
+	{
+		std::string typeName;
+		uint32_t fieldCount = 0;
+		if (!ReadString(typeName) || !ReadRaw(fieldCount))
+			return false;
+
+		SchemaType& schemaType = Schema.emplace_back();
+		schemaType.Type = TypeDatabase::Get().FindType(typeName);
+
+		for (uint32_t f = 0; f < fieldCount; f++)
+		{
+			std::string fieldName;
+			if (!ReadString(fieldName))
+				return false;
+
+			schemaType.FieldIndexes.push_back(schemaType.Type ? schemaType.Type->FindFieldIndex(fieldName) : -1);
+		}
+	}
+
+	return true;
+}
+
+template<class T>
+bool BinaryTypeReader::ReadPrimitive(TypeValue* destinationValue, int fieldIndex)
+{
+	T value;
+	if (!ReadRaw(value))
+		return false;
+
+	destinationValue->SetFieldPrimitiveValue<T>(fieldIndex, value);
+	return true;
+}
+
+template<>
+bool BinaryTypeReader::ReadPrimitive<bool>(TypeValue* destinationValue, int fieldIndex)
+{
+	uint8_t value = 0;
+	if (!ReadRaw(value))
+		return false;
+
+	destinationValue->SetFieldPrimitiveValue<bool>(fieldIndex, value != 0);
+	return true;
+}
+
+template<>
+bool BinaryTypeReader::ReadPrimitive<std::string>(TypeValue* destinationValue, int fieldIndex)
+{
+	std::string value;
+	if (!ReadString(value))
+		return false;
+
+	destinationValue->SetFieldPrimitiveValue<std::string>(fieldIndex, value);
+	return true;
+}
+
+template<class T>
+bool BinaryTypeReader::ReadPrimitiveList(TypeValue* destinationValue, int fieldIndex, uint32_t count)
+{
+	// the whole array in one copy, checked against the remaining data before anything is allocated
+	if (size_t(End - Cursor) / sizeof(T) < count)
+		return false;
+
+	std::vector<T>& values = destinationValue->GetPrimitiveListFieldValue<T>(fieldIndex).GetValues();
+	size_t start = values.size();
+	values.resize(start + count);
+	return ReadBytes(values.data() + start, count * sizeof(T));
+}
+
+template<>
+bool BinaryTypeReader::ReadPrimitiveList<bool>(TypeValue* destinationValue, int fieldIndex, uint32_t count)
+{
+	if (size_t(End - Cursor) < count)
+		return false;
+
+	auto& list = destinationValue->GetPrimitiveListFieldValue<bool>(fieldIndex);
+	for (uint32_t i = 0; i < count; i++)
+		list.PushBack(Cursor[i] != 0);
+
+	Cursor += count;
+	return true;
+}
+
+template<>
+bool BinaryTypeReader::ReadPrimitiveList<std::string>(TypeValue* destinationValue, int fieldIndex, uint32_t count)
+{
+	auto& list = destinationValue->GetPrimitiveListFieldValue<std::string>(fieldIndex);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		std::string value;
+		if (!ReadString(value))
+			return false;
+
+		list.PushBack(value);
+	}
+	return true;
+}
+
+bool BinaryTypeReader::ReadPrimitiveField(TypeValue* destinationValue, int fieldIndex, PrimitiveType primType)
+{
+	switch (primType)
+	{
+	default:
+	case PrimitiveType::Unknown:
+		return false;
+
+	case PrimitiveType::Bool:		return ReadPrimitive<bool>(destinationValue, fieldIndex);
+	case PrimitiveType::Char:		return ReadPrimitive<char>(destinationValue, fieldIndex);
+	case PrimitiveType::UInt8:		return ReadPrimitive<uint8_t>(destinationValue, fieldIndex);
+	case PrimitiveType::UInt16:		return ReadPrimitive<uint16_t>(destinationValue, fieldIndex);
+	case PrimitiveType::Int16:		return ReadPrimitive<int16_t>(destinationValue, fieldIndex);
+	case PrimitiveType::UInt32:		return ReadPrimitive<uint32_t>(destinationValue, fieldIndex);
+	case PrimitiveType::Int32:		return ReadPrimitive<int32_t>(destinationValue, fieldIndex);
+	case PrimitiveType::UInt64:		return ReadPrimitive<uint64_t>(destinationValue, fieldIndex);
+	case PrimitiveType::Int64:		return ReadPrimitive<int64_t>(destinationValue, fieldIndex);
+	case PrimitiveType::Float32:	return ReadPrimitive<float>(destinationValue, fieldIndex);
+	case PrimitiveType::Double64:	return ReadPrimitive<double>(destinationValue, fieldIndex);
+	case PrimitiveType::String:		return ReadPrimitive<std::string>(destinationValue, fieldIndex);
+	case PrimitiveType::Vector2:	return ReadPrimitive<Vector2>(destinationValue, fieldIndex);
+	case PrimitiveType::Vector3:	return ReadPrimitive<Vector3>(destinationValue, fieldIndex);
+	case PrimitiveType::Vector4:	return ReadPrimitive<Vector4>(destinationValue, fieldIndex);
+	case PrimitiveType::Rectangle:	return ReadPrimitive<Rectangle>(destinationValue, fieldIndex);
+	case PrimitiveType::Matrix:		return ReadPrimitive<Matrix>(destinationValue, fieldIndex);
+	case PrimitiveType::GUID:		return ReadPrimitive<Hashes::GUID>(destinationValue, fieldIndex);
+	case PrimitiveType::Color:		return ReadPrimitive<Color>(destinationValue, fieldIndex);
+	}
+}
+
+bool BinaryTypeReader::ReadCompressedListField(TypeValue* destinationValue, int fieldIndex, PrimitiveType primType, ListEncoding encoding)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// the codecs take the rest of the field
+	size_t encodedBytes = size_t(End - Cursor);
+	size_t rawBytes = 0;
+	bool decoded = false;
+
+	if (encoding == ListEncoding::Floats && primType == PrimitiveType::Float32)
+	{
+		std::vector<float>& values = destinationValue->GetPrimitiveListFieldValue<float>(fieldIndex).GetValues();
+		decoded = ListCodec::DecodeFloats(Cursor, encodedBytes, values);
+		rawBytes = values.size() * sizeof(float);
+	}
+	else if (encoding == ListEncoding::Bytes && primType == PrimitiveType::UInt8)
+	{
+		std::vector<uint8_t>& values = destinationValue->GetPrimitiveListFieldValue<uint8_t>(fieldIndex).GetValues();
+		decoded = ListCodec::DecodeBytes(Cursor, encodedBytes, values);
+		rawBytes = values.size();
+	}
+
+	Cursor = End;
+	if (!decoded)
+		return false;
+
+	Stats.Lists++;
+	Stats.RawBytes += rawBytes;
+	Stats.EncodedBytes += encodedBytes + sizeof(ListEncoding);
+	Stats.DecodeMS += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+bool BinaryTypeReader::ReadPrimitiveListField(TypeValue* destinationValue, int fieldIndex, PrimitiveType primType)
+{
+	if (FileVersion >= 3)
+	{
+		ListEncoding encoding = ListEncoding::Raw;
+		if (!ReadRaw(encoding))
+			return false;
+
+		if (encoding != ListEncoding::Raw)
+			return ReadCompressedListField(destinationValue, fieldIndex, primType, encoding);
+	}
+
+	uint32_t count = 0;
+	if (!ReadRaw(count))
+		return false;
+
+	switch (primType)
+	{
+	default:
+	case PrimitiveType::Unknown:
+		return false;
+
+	case PrimitiveType::Bool:		return ReadPrimitiveList<bool>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Char:		return ReadPrimitiveList<char>(destinationValue, fieldIndex, count);
+	case PrimitiveType::UInt8:		return ReadPrimitiveList<uint8_t>(destinationValue, fieldIndex, count);
+	case PrimitiveType::UInt16:		return ReadPrimitiveList<uint16_t>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Int16:		return ReadPrimitiveList<int16_t>(destinationValue, fieldIndex, count);
+	case PrimitiveType::UInt32:		return ReadPrimitiveList<uint32_t>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Int32:		return ReadPrimitiveList<int32_t>(destinationValue, fieldIndex, count);
+	case PrimitiveType::UInt64:		return ReadPrimitiveList<uint64_t>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Int64:		return ReadPrimitiveList<int64_t>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Float32:	return ReadPrimitiveList<float>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Double64:	return ReadPrimitiveList<double>(destinationValue, fieldIndex, count);
+	case PrimitiveType::String:		return ReadPrimitiveList<std::string>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Vector2:	return ReadPrimitiveList<Vector2>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Vector3:	return ReadPrimitiveList<Vector3>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Vector4:	return ReadPrimitiveList<Vector4>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Rectangle:	return ReadPrimitiveList<Rectangle>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Matrix:		return ReadPrimitiveList<Matrix>(destinationValue, fieldIndex, count);
+	case PrimitiveType::GUID:		return ReadPrimitiveList<Hashes::GUID>(destinationValue, fieldIndex, count);
+	case PrimitiveType::Color:		return ReadPrimitiveList<Color>(destinationValue, fieldIndex, count);
+	}
+}
+
+bool BinaryTypeReader::ReadEnumerationField(TypeValue* destinationValue, int fieldIndex, EnumerationFieldInfo* fieldInfo)
+{
+	std::string valueName;
+	if (!ReadString(valueName))
+		return false;
+
+	for (auto& [index, name] : fieldInfo->TypePtr->Values)
+	{
+		if (name == valueName)
+		{
+			destinationValue->SetFieldEnumerationValueInt(fieldIndex, index);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool BinaryTypeReader::ReadTypeValue(TypeValue* destinationValue)
+{
+	uint32_t schemaIndex = 0;
+	uint32_t fieldCount = 0;
+	if (!ReadRaw(schemaIndex) || !ReadRaw(fieldCount))
+		return false;
+
+	if (schemaIndex >= Schema.size() || !Schema[schemaIndex].Type)
+		return false;
+
+	const SchemaType& schemaType = Schema[schemaIndex];
+	TypeInfo* type = schemaType.Type;
+
+	destinationValue->SetType(type);
+
+	for (uint32_t f = 0; f < fieldCount; f++)
+	{
+		uint32_t fileFieldIndex = 0;
+		uint8_t fieldType = 0;
+		uint8_t primType = 0;
+		FieldLength length = 0;
+		if (!ReadRaw(fileFieldIndex) || !ReadRaw(fieldType) || !ReadRaw(primType) || !ReadRaw(length))
+			return false;
+
+		if (length > FieldLength(End - Cursor))
+			return false;
+
+		const uint8_t* fieldEnd = Cursor + length;
+
+		int index = fileFieldIndex < schemaType.FieldIndexes.size() ? schemaType.FieldIndexes[fileFieldIndex] : -1;
+		FieldInfo* fieldInfo = index >= 0 ? type->GetField(index) : nullptr;
+
+		// fields that are gone or changed kind keep their defaults
+		bool matches = fieldInfo && uint8_t(fieldInfo->GetType()) == fieldType;
+		if (matches && fieldInfo->IsPrimtive())
+			matches = uint8_t(static_cast<PrimitiveFieldInfo*>(fieldInfo)->GetPrimitiveType()) == primType;
+
+		if (matches)
+		{
+			// a field that fails to parse is dropped, its length still finds the next one
+			const uint8_t* end = End;
+			End = fieldEnd;
+
+			switch (fieldInfo->GetType())
+			{
+			case FieldType::Primitive:
+				ReadPrimitiveField(destinationValue, index, PrimitiveType(primType));
+				break;
+
+			case FieldType::PrimitiveList:
+				ReadPrimitiveListField(destinationValue, index, PrimitiveType(primType));
+				break;
+
+			case FieldType::Enumeration:
+				ReadEnumerationField(destinationValue, index, static_cast<EnumerationFieldInfo*>(fieldInfo));
+				break;
+
+			case FieldType::Type:
+				ReadTypeValue(destinationValue->GetTypeFieldValue(index));
+				break;
+
+			case FieldType::TypeList:
+				ReadTypeListValue(destinationValue->GetTypeListFieldValue(index), DeferLazyLists && fieldInfo->HasAttribute<AttributeTypes::LazyLoadAttribute>());
+				break;
+			}
+
+			End = end;
+		}
+
+		Cursor = fieldEnd;
+	}
+
+	return true;
+}
+
+namespace TypeIO
+{
+	// Reads the elements of a deferred list out of the mapping on request, with the schema of the file they came from
+	class BinaryListSource : public TypeListSource
+	{
+	public:
+		BinaryTypeReader Reader;
+
+		// element offsets from Start, the last element runs to End
+		const uint8_t* Start = nullptr;
+		const uint8_t* End = nullptr;
+		std::vector<FieldLength> Offsets;
+
+		bool LoadElement(size_t sourceIndex, TypeValue* value) override
+		{
+			PROFILE_SCOPE("BinaryListSource::LoadElement");
+
+			Reader.Cursor = Start + Offsets[sourceIndex];
+			Reader.End = sourceIndex + 1 < Offsets.size() ? Start + Offsets[sourceIndex + 1] : End;
+			bool result = Reader.ReadTypeValue(value);
+
+			Reader.Cursor = Reader.End = nullptr;
+			return result;
+		}
+	};
+}
+
+bool BinaryTypeReader::ReadTypeListValue(TypeListValue& listValue, bool defer)
+{
+	uint32_t schemaIndex = 0;
+	uint32_t count = 0;
+	if (!ReadRaw(schemaIndex) || !ReadRaw(count))
+		return false;
+
+	if (schemaIndex >= Schema.size() || !Schema[schemaIndex].Type)
+		return false;
+
+	std::vector<FieldLength> offsets;
+	if (FileVersion >= 2)
+	{
+		if (size_t(End - Cursor) / sizeof(FieldLength) < count)
+			return false;
+
+		offsets.resize(count);
+		ReadBytes(offsets.data(), count * sizeof(FieldLength));
+
+		// a deferred element is read on its own later, so the table has to be sane up front
+		for (uint32_t i = 0; i < count; i++)
+		{
+			FieldLength next = i + 1 < count ? offsets[i + 1] : FieldLength(End - Cursor);
+			if (offsets[i] > next)
+				return false;
+		}
+	}
+
+	if (defer && File && FileVersion >= 2)
+	{
+		auto source = std::make_unique<BinaryListSource>();
+		source->Reader.Schema = Schema;
+		source->Reader.FileVersion = FileVersion;
+		source->Reader.File = File;
+		source->Reader.DeferLazyLists = DeferLazyLists;
+		source->Start = Cursor;
+		source->End = End;
+		source->Offsets = std::move(offsets);
+
+		listValue.SetSource(std::move(source), count);
+
+		// the list is the whole field, what is left of it belongs to the elements
+		Cursor = End;
+		return true;
+	}
+
+	TypeInfo* type = Schema[schemaIndex].Type;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto itemValue = listValue.PushBack(type);
+		if (!ReadTypeValue(itemValue))
+			return false;
+	}
+
+	return true;
+}
+
+bool BinaryTypeReader::IsBinaryData(const uint8_t* data, size_t size)
+{
+	return size >= sizeof(BinaryMagic) && memcmp(data, BinaryMagic, sizeof(BinaryMagic)) == 0;
+}
+
+bool BinaryTypeReader::Read(TypeValue* value, const uint8_t* data, size_t size)
+{
+	PROFILE_SCOPE("BinaryTypeReader::Read");
+
+	if (!IsBinaryData(data, size))
+		return false;
+
+	Cursor = data + sizeof(BinaryMagic);
+	End = data + size;
+	Stats = ListCodecStats();
+
+	if (!ReadRaw(FileVersion) || FileVersion > BinaryVersion)
+		return false;
+
+	if (!ReadSchema())
+		return false;
+
+	// lazily read elements go to the same arena when they are loaded
+	if (UseArena)
+		value->SetArena(TypeArena::Create());
+	TypeArena::Scope arenaScope(value->GetArena());
+
+	// a tree being read is not being edited, nobody is told about each field
+	ValueChangedEvent::SuppressScope suppressScope;
+
+	bool result = ReadTypeValue(value);
+
+	Cursor = End = nullptr;
+	return result;
+}
+
+bool BinaryTypeReader::Read(TypeValue* value, std::shared_ptr<const MappedFile> file)
+{
+	File = std::move(file);
+	bool result = Read(value, File->GetData(), File->GetSize());
+
+	// deferred lists hold their own reference to the mapping
+	File.reset();
+	return result;
+}
+
+bool BinaryTypeReader::Read(TypeValue* value, const std::string& fileName)
+{
+	auto file = std::make_shared<MappedFile>();
+	if (!file->Open(fileName))
+		return false;
+
+	return Read(value, std::shared_ptr<const MappedFile>(std::move(file)));
+}
@@ -1,39 +1,27 @@
 #include "type_io.h"
 
 #include "field_info.h"
+#include "Profiler.h"
+#include "Base64.h"
+#include "MappedFile.h"
+#include "MemoryStats.h"
 
-#include "rapidjson/document.h"
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
-#include "rapidjson/prettywriter.h"
+#include "rapidjson/reader.h"
+#include "rapidjson/filereadstream.h"
+#include "rapidjson/memorystream.h"
 
+#include "raylib.h"
 #include "raymath.h"
 
+#include <cstdio>
+#include <string_view>
+#include <type_traits>
+
 using namespace TypeIO;
 using namespace rapidjson;
 
 //--------------------------------------------------------------
-//   File IO
-//--------------------------------------------------------------
-std::string ReadFileText(const std::string& fileName)
-{
-	std::string contents;
-	FILE* fp = fopen(fileName.c_str(), "rt");
-	if (!fp)
-		return contents;
-
-	fseek(fp, 0, SEEK_END);
-	size_t len = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	contents.resize(len + 1);
-	fread(contents.data(), len, 1, fp);
-	fclose(fp);
-
-	return contents;
-}
-
-//--------------------------------------------------------------
-//   TypeReader
+//   Value helpers
 //--------------------------------------------------------------
 
 Matrix FloatToMatrix(float mat[16])
@@ -60,485 +48,845 @@ Matrix FloatToMatrix(float mat[16])
 	return result;
 }
 
-bool TypeReader::AddEnumerationeField(TypeValue* destinationValue, int fieldIndex, EnumerationFieldInfo* fieldInfo, rapidjson::Value& jsonValue)
+// one scalar event from the SAX reader
+struct JsonScalar
 {
-	if (!jsonValue.IsObject())
-		return false;
-
-	rapidjson::Value& typeName = jsonValue[TypeName];
-	rapidjson::Value& fieldValue = jsonValue[ValueName];
-
-	std::string valueName = fieldValue.GetString();
-
-	for (auto& [index, name] : fieldInfo->TypePtr->Values)
-	{
-		if (name == valueName)
+	enum class Kind
+	{
+		Null,
+		Bool,
+		Int,
+		Uint,
+		Double,
+		String,
+	};
+
+	Kind ValueKind = Kind::Null;
+	bool BoolValue = false;
+	int64_t IntValue = 0;
+	uint64_t UintValue = 0;
+	double DoubleValue = 0;
+	std::string_view Text;
+
+	bool IsNumber() const { return ValueKind == Kind::Int || ValueKind == Kind::Uint || ValueKind == Kind::Double; }
+	bool IsString() const { return ValueKind == Kind::String; }
+
+	template<class T>
+	T As() const
+	{
+		switch (ValueKind)
 		{
-			destinationValue->SetFieldEnumerationValueInt(fieldIndex, index);
-			return true;
+		case Kind::Bool:
+			return T(BoolValue);
+		case Kind::Int:
+			return T(IntValue);
+		case Kind::Uint:
+			return T(UintValue);
+		case Kind::Double:
+			return T(DoubleValue);
+		default:
+			return T();
 		}
 	}
-	return false;
+};
 
+static bool IsNumericType(PrimitiveType primType)
+{
+	return primType >= PrimitiveType::Char && primType <= PrimitiveType::Double64;
 }
 
-bool TypeReader::AddPrimtiveField(TypeValue* destinationValue, int fieldIndex, PrimitiveFieldInfo* fieldInfo, rapidjson::Value& jsonValue)
+// packed lists are one base64 string of the raw little endian elements
+template<class T>
+static bool DecodePackedList(std::vector<T>& values, std::string_view text)
 {
-	if (!jsonValue.IsObject())
+	size_t size = Base64::GetDecodedSize(text);
+	if (size % sizeof(T) != 0)
 		return false;
 
-	rapidjson::Value& typeName = jsonValue[TypeName];
-	rapidjson::Value& fieldValue = jsonValue[ValueName];
+	size_t start = values.size();
+	values.resize(start + size / sizeof(T));
+	if (Base64::Decode(text, values.data() + start, size))
+		return true;
 
-	switch (fieldInfo->GetPrimitiveType())
-	{
-	default:
-	case PrimitiveType::Unknown:
-		return false;
+	values.resize(start);
+	return false;
+}
 
-	case PrimitiveType::Bool:
-		destinationValue->SetFieldPrimitiveValue<bool>(fieldIndex, fieldValue.GetBool());
-		break;
-	case PrimitiveType::Char:
-		destinationValue->SetFieldPrimitiveValue<char>(fieldIndex, fieldValue.GetInt());
-		break;
-	case PrimitiveType::UInt8:
-		destinationValue->SetFieldPrimitiveValue<uint8_t>(fieldIndex, fieldValue.GetUint());
-		break;
-	case PrimitiveType::UInt16:
-		destinationValue->SetFieldPrimitiveValue<uint16_t>(fieldIndex, fieldValue.GetUint());
-		break;
-	case PrimitiveType::Int16:
-		destinationValue->SetFieldPrimitiveValue<int16_t>(fieldIndex, fieldValue.GetInt());
-		break;
-	case PrimitiveType::UInt32:
-		destinationValue->SetFieldPrimitiveValue<uint32_t>(fieldIndex, fieldValue.GetUint());
-		break;
-	case PrimitiveType::Int32:
-		destinationValue->SetFieldPrimitiveValue<int32_t>(fieldIndex, fieldValue.GetInt());
-		break;
-	case PrimitiveType::UInt64:
-		destinationValue->SetFieldPrimitiveValue<uint64_t>(fieldIndex, fieldValue.GetUint64());
-		break;
-	case PrimitiveType::Int64:
-		destinationValue->SetFieldPrimitiveValue<int64_t>(fieldIndex, fieldValue.GetInt64());
-		break;
-	case PrimitiveType::Float32:
-		destinationValue->SetFieldPrimitiveValue<float>(fieldIndex, fieldValue.GetFloat());
-		break;
-	case PrimitiveType::Double64:
-		destinationValue->SetFieldPrimitiveValue<double>(fieldIndex, fieldValue.GetDouble());
-		break;
-	case PrimitiveType::String:
-		destinationValue->SetFieldPrimitiveValue<std::string>(fieldIndex, fieldValue.GetString());
-		break;
-	case PrimitiveType::Vector2:
+template<class T>
+static void AppendNumber(void* storage, const JsonScalar& value)
+{
+	static_cast<std::vector<T>*>(storage)->push_back(value.As<T>());
+}
+
+//--------------------------------------------------------------
+//   TypeReadHandler
+//--------------------------------------------------------------
+
+// What the object or array being parsed is. Every StartObject and StartArray pushes one frame and every
+// EndObject and EndArray pops it, values and keys are handled by the frame on top.
+enum class FrameType
+{
+	Skip,			// contents are ignored
+	Document,		// the file, RootData holds the root value
+	Type,			// a type value, TypeName then Fields
+	Fields,			// one member per field, named by the field
+	Field,			// primitive, primitive list and enumeration fields, TypeName and Value
+	TypeList,		// TypeName then the Value array
+	TypeListItems,	// one type value per item
+	PrimitiveList,	// array of primitive values
+	Compound,		// vector, rectangle, matrix or color, gathered into the components
+};
+
+enum class MemberKey
+{
+	None,
+	RootData,
+	TypeName,
+	Fields,
+	Value,
+};
+
+struct ReadFrame
+{
+	FrameType Type = FrameType::Skip;
+	MemberKey Key = MemberKey::None;
+
+	TypeValue* Value = nullptr;
+
+	// type of the value, or of the items of a type list
+	TypeInfo* ValueType = nullptr;
+	TypeListValue* List = nullptr;
+
+	// set by the key in a Fields frame and carried into the field frames
+	int FieldIndex = -1;
+	FieldInfo* Field = nullptr;
+	PrimitiveType Primitive = PrimitiveType::Unknown;
+
+	// numeric lists append straight to the vector behind the list field
+	void* ListStorage = nullptr;
+	void (*Append)(void* storage, const JsonScalar& value) = nullptr;
+
+	// compound values are set on the field when done, or pushed to the list they are in
+	bool IntoList = false;
+	bool IsArray = false;
+	int Component = 0;
+	float Components[16] = { 0 };
+};
+
+class TypeReadHandler : public BaseReaderHandler<UTF8<>, TypeReadHandler>
+{
+public:
+	TypeReadHandler(TypeValue* root) : Root(root)
 	{
-		auto& x = fieldValue["X"];
-		auto& y = fieldValue["Y"];
-		destinationValue->SetFieldPrimitiveValue<Vector2>(fieldIndex, Vector2{ x.GetFloat(), y.GetFloat() });
+		Frames.reserve(32);
 	}
-	break;
-	case PrimitiveType::Vector3:
+
+	// true once the root value has been given its type
+	bool RootRead = false;
+
+	bool Null()
 	{
-		auto& x = fieldValue["X"];
-		auto& y = fieldValue["Y"];
-		auto& z = fieldValue["Z"];
-		destinationValue->SetFieldPrimitiveValue<Vector3>(fieldIndex, Vector3{ x.GetFloat(), y.GetFloat(), z.GetFloat() });
-	}
-	break;
-	case PrimitiveType::Vector4:
-	{
-		auto& x = fieldValue["X"];
-		auto& y = fieldValue["Y"];
-		auto& z = fieldValue["Z"];
-		auto& w = fieldValue["W"];
-		destinationValue->SetFieldPrimitiveValue<Vector4>(fieldIndex, Vector4{ x.GetFloat(), y.GetFloat(), z.GetFloat(), w.GetFloat() });
-	}
-	break;
-	case PrimitiveType::Rectangle:
-	{
-		auto& x = fieldValue["X"];
-		auto& y = fieldValue["Y"];
-		auto& w = fieldValue["Width"];
-		auto& h = fieldValue["Height"];
-		destinationValue->SetFieldPrimitiveValue<Rectangle>(fieldIndex, Rectangle{ x.GetFloat(), y.GetFloat(), w.GetFloat(), h.GetFloat() });
+		JsonScalar value;
+		return OnScalar(value);
 	}
-	break;
-	case PrimitiveType::Matrix:
-	{
-		float matf[16] = { 0 };
-		const auto& array = fieldValue.GetArray();
 
-		for (int i = 0; i < 16; i++)
-		{
-			matf[i] = array[i].GetFloat();
-		}
-		Matrix mat = FloatToMatrix(matf);
-		destinationValue->SetFieldPrimitiveValue<Matrix>(fieldIndex, mat);
-	}
-	break;
-	case PrimitiveType::GUID:
+	bool Bool(bool b)
 	{
-		Hashes::GUID guid;
-		guid.Parse(fieldValue.GetString());
-		destinationValue->SetFieldPrimitiveValue<Hashes::GUID>(fieldIndex, guid);
-	}
-	break;
-	case PrimitiveType::Color:
-	{
-		Color color;
-		const auto& array = fieldValue.GetArray();
-		color.r = array[0].GetInt();
-		color.g = array[1].GetInt();
-		color.b = array[2].GetInt();
-		color.a = array[3].GetInt();
-		destinationValue->SetFieldPrimitiveValue<Color>(fieldIndex, color);
-	}
-	break;
+		JsonScalar value;
+		value.ValueKind = JsonScalar::Kind::Bool;
+		value.BoolValue = b;
+		return OnScalar(value);
 	}
 
-	return true;
-}
+	bool Int(int i) { return Int64(i); }
+	bool Uint(unsigned u) { return Uint64(u); }
 
-bool TypeReader::AddPrimtiveListField(TypeValue* destinationValue, int fieldIndex, PrimitiveFieldInfo* fieldInfo, rapidjson::Value& jsonValue)
-{
-	if (!jsonValue.IsObject())
-		return false;
-
-	rapidjson::Value& typeName = jsonValue[TypeName];
-	rapidjson::Value& fieldValue = jsonValue[ValueName];
-
-	if (!fieldValue.IsArray())
-		return false;
+	bool Int64(int64_t i)
+	{
+		JsonScalar value;
+		value.ValueKind = JsonScalar::Kind::Int;
+		value.IntValue = i;
+		return OnScalar(value);
+	}
 
-	const auto& array = fieldValue.GetArray();
+	bool Uint64(uint64_t u)
+	{
+		JsonScalar value;
+		value.ValueKind = JsonScalar::Kind::Uint;
+		value.UintValue = u;
+		return OnScalar(value);
+	}
 
-	switch (fieldInfo->GetPrimitiveType())
+	bool Double(double d)
 	{
-	default:
-	case PrimitiveType::Unknown:
-		return false;
+		JsonScalar value;
+		value.ValueKind = JsonScalar::Kind::Double;
+		value.DoubleValue = d;
+		return OnScalar(value);
+	}
 
-	case PrimitiveType::Bool:
+	bool String(const char* str, SizeType length, bool)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<bool>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetBool());
-		}
+		JsonScalar value;
+		value.ValueKind = JsonScalar::Kind::String;
+		value.Text = std::string_view(str, length);
+		return OnScalar(value);
 	}
-	break;
 
-	case PrimitiveType::Char:
+	bool StartObject()
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<char>(fieldIndex);
-		for (auto& i : array)
+		if (Frames.empty())
 		{
-			list.PushBack(i.GetInt());
+			ReadFrame document;
+			document.Type = FrameType::Document;
+			Frames.push_back(document);
+			return true;
 		}
+
+		ReadFrame child = OpenObject(Frames.back());
+		Frames.back().Key = MemberKey::None;
+		Frames.push_back(child);
+		return true;
 	}
-	break;
 
-	case PrimitiveType::UInt8:
+	bool StartArray()
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<uint8_t>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetUint());
-		}
+		if (Frames.empty())
+			return false;
+
+		ReadFrame child = OpenArray(Frames.back());
+		Frames.back().Key = MemberKey::None;
+		Frames.push_back(child);
+		return true;
 	}
-	break;
 
-	case PrimitiveType::UInt16:
+	bool EndObject(SizeType)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<uint16_t>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetUint());
-		}
+		return CloseFrame();
 	}
-	break;
 
-	case PrimitiveType::Int16:
+	bool EndArray(SizeType)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<int16_t>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetInt());
-		}
+		return CloseFrame();
 	}
-	break;
 
-	case PrimitiveType::UInt32:
+	bool Key(const char* str, SizeType length, bool)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<uint32_t>(fieldIndex);
-		for (auto& i : array)
+		ReadFrame& frame = Frames.back();
+		std::string_view name(str, length);
+
+		switch (frame.Type)
 		{
-			list.PushBack(i.GetUint());
+		default:
+			break;
+
+		case FrameType::Document:
+			frame.Key = name == RootData ? MemberKey::RootData : MemberKey::None;
+			break;
+
+		case FrameType::Type:
+		case FrameType::TypeList:
+		case FrameType::Field:
+			if (name == TypeName)
+				frame.Key = MemberKey::TypeName;
+			else if (name == Fields)
+				frame.Key = MemberKey::Fields;
+			else if (name == ValueName)
+				frame.Key = MemberKey::Value;
+			else
+				frame.Key = MemberKey::None;
+			break;
+
+		case FrameType::Fields:
+			frame.FieldIndex = frame.ValueType->FindFieldIndex(std::string(name));
+			frame.Field = frame.FieldIndex >= 0 ? frame.ValueType->GetField(frame.FieldIndex) : nullptr;
+			break;
+
+		case FrameType::Compound:
+			if (name == "X")
+				frame.Component = 0;
+			else if (name == "Y")
+				frame.Component = 1;
+			else if (name == "Z" || name == "Width")
+				frame.Component = 2;
+			else if (name == "W" || name == "Height")
+				frame.Component = 3;
+			else
+				frame.Component = -1;
+			break;
 		}
+
+		return true;
 	}
-	break;
 
-	case PrimitiveType::Int32:
+protected:
+	TypeValue* Root = nullptr;
+	std::vector<ReadFrame> Frames;
+
+	static ReadFrame MakeFieldFrame(FrameType type, const ReadFrame& parent)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<int32_t>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetInt());
-		}
+		ReadFrame frame;
+		frame.Type = type;
+		frame.Value = parent.Value;
+		frame.FieldIndex = parent.FieldIndex;
+		frame.Field = parent.Field;
+		frame.Primitive = parent.Primitive;
+		return frame;
 	}
-	break;
 
-	case PrimitiveType::UInt64:
+	static ReadFrame MakeCompoundFrame(const ReadFrame& parent, bool intoList, bool isArray)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<uint64_t>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetUint64());
-		}
+		ReadFrame frame = MakeFieldFrame(FrameType::Compound, parent);
+		frame.IntoList = intoList;
+		frame.IsArray = isArray;
+		return frame;
 	}
-	break;
 
-	case PrimitiveType::Int64:
+	static bool IsObjectCompound(PrimitiveType primType)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<int64_t>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetInt64());
-		}
+		return primType == PrimitiveType::Vector2 || primType == PrimitiveType::Vector3 || primType == PrimitiveType::Vector4 || primType == PrimitiveType::Rectangle;
 	}
-	break;
 
-	case PrimitiveType::Float32:
+	static bool IsArrayCompound(PrimitiveType primType)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<float>(fieldIndex);
-		for (auto& i : array)
-		{
-			list.PushBack(i.GetFloat());
-		}
+		return primType == PrimitiveType::Matrix || primType == PrimitiveType::Color;
 	}
-	break;
 
-	case PrimitiveType::Double64:
+	ReadFrame OpenObject(const ReadFrame& parent)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<double>(fieldIndex);
-		for (auto& i : array)
+		ReadFrame frame;
+
+		switch (parent.Type)
 		{
-			list.PushBack(i.GetDouble());
+		default:
+			break;
+
+		case FrameType::Document:
+			if (parent.Key == MemberKey::RootData)
+			{
+				frame.Type = FrameType::Type;
+				frame.Value = Root;
+			}
+			break;
+
+		case FrameType::Type:
+			if (parent.Key == MemberKey::Fields && parent.ValueType)
+			{
+				frame.Type = FrameType::Fields;
+				frame.Value = parent.Value;
+				frame.ValueType = parent.ValueType;
+			}
+			break;
+
+		case FrameType::Fields:
+			if (!parent.Field)
+				break;
+
+			switch (parent.Field->GetType())
+			{
+			case FieldType::Primitive:
+			case FieldType::PrimitiveList:
+			case FieldType::Enumeration:
+				frame = MakeFieldFrame(FrameType::Field, parent);
+				if (parent.Field->GetType() != FieldType::Enumeration)
+					frame.Primitive = static_cast<PrimitiveFieldInfo*>(parent.Field)->GetPrimitiveType();
+				break;
+
+			case FieldType::Type:
+				frame.Type = FrameType::Type;
+				frame.Value = parent.Value->GetTypeFieldValue(parent.FieldIndex);
+				break;
+
+			case FieldType::TypeList:
+				frame.Type = FrameType::TypeList;
+				frame.List = &parent.Value->GetTypeListFieldValue(parent.FieldIndex);
+				break;
+
+			default:
+				break;
+			}
+			break;
+
+		case FrameType::Field:
+			if (parent.Key == MemberKey::Value && parent.Field->GetType() == FieldType::Primitive && IsObjectCompound(parent.Primitive))
+				frame = MakeCompoundFrame(parent, false, false);
+			break;
+
+		case FrameType::TypeListItems:
+			if (parent.ValueType)
+			{
+				frame.Type = FrameType::Type;
+				frame.Value = parent.List->PushBack(parent.ValueType);
+			}
+			break;
+
+		case FrameType::PrimitiveList:
+			if (IsObjectCompound(parent.Primitive))
+				frame = MakeCompoundFrame(parent, true, false);
+			break;
 		}
+
+		return frame;
 	}
-	break;
 
-	case PrimitiveType::String:
+	ReadFrame OpenArray(const ReadFrame& parent)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<std::string>(fieldIndex);
-		for (auto& i : array)
+		ReadFrame frame;
+
+		switch (parent.Type)
 		{
-			list.PushBack(i.GetString());
+		default:
+			break;
+
+		case FrameType::Field:
+			if (parent.Key != MemberKey::Value)
+				break;
+
+			if (parent.Field->GetType() == FieldType::PrimitiveList)
+			{
+				frame = MakeFieldFrame(FrameType::PrimitiveList, parent);
+				BindNumericList(frame);
+			}
+			else if (parent.Field->GetType() == FieldType::Primitive && IsArrayCompound(parent.Primitive))
+			{
+				frame = MakeCompoundFrame(parent, false, true);
+			}
+			break;
+
+		case FrameType::TypeList:
+			if (parent.Key == MemberKey::Value && parent.ValueType)
+			{
+				frame.Type = FrameType::TypeListItems;
+				frame.List = parent.List;
+				frame.ValueType = parent.ValueType;
+			}
+			break;
+
+		case FrameType::PrimitiveList:
+			if (IsArrayCompound(parent.Primitive))
+				frame = MakeCompoundFrame(parent, true, true);
+			break;
 		}
+
+		return frame;
 	}
-	break;
 
-	case PrimitiveType::Vector2:
+	bool CloseFrame()
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<Vector2>(fieldIndex);
-		for (auto& i : array)
-		{
-			auto& x = i["X"];
-			auto& y = i["Y"];
-			list.PushBack(Vector2{ x.GetFloat(), y.GetFloat() });
-		}
+		if (Frames.empty())
+			return false;
+
+		if (Frames.back().Type == FrameType::Compound)
+			FinishCompound(Frames.back());
+
+		Frames.pop_back();
+		return true;
 	}
-	break;
 
-	case PrimitiveType::Vector3:
+	bool OnScalar(const JsonScalar& value)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<Vector3>(fieldIndex);
-		for (auto& i : array)
+		if (Frames.empty())
+			return false;
+
+		ReadFrame& frame = Frames.back();
+
+		switch (frame.Type)
 		{
-			auto& x = i["X"];
-			auto& y = i["Y"];
-			auto& z = i["Z"];
-			list.PushBack(Vector3{ x.GetFloat(), y.GetFloat(), z.GetFloat() });
+		default:
+			break;
+
+		case FrameType::Type:
+			if (frame.Key == MemberKey::TypeName && value.IsString())
+			{
+				frame.ValueType = TypeDatabase::Get().FindType(std::string(value.Text));
+				if (frame.ValueType)
+				{
+					frame.Value->SetType(frame.ValueType);
+					if (frame.Value == Root)
+						RootRead = true;
+				}
+			}
+			break;
+
+		case FrameType::TypeList:
+			if (frame.Key == MemberKey::TypeName && value.IsString())
+				frame.ValueType = TypeDatabase::Get().FindType(std::string(value.Text));
+			break;
+
+		case FrameType::Field:
+			if (frame.Key == MemberKey::Value)
+				SetFieldValue(frame, value);
+			break;
+
+		case FrameType::PrimitiveList:
+			AppendListValue(frame, value);
+			break;
+
+		case FrameType::Compound:
+			if (frame.Component >= 0 && frame.Component < 16 && value.IsNumber())
+				frame.Components[frame.Component] = value.As<float>();
+			if (frame.IsArray)
+				frame.Component++;
+			break;
 		}
+
+		frame.Key = MemberKey::None;
+		return true;
 	}
-	break;
 
-	case PrimitiveType::Vector4:
+	template<class T>
+	static void BindNumericList(ReadFrame& frame, std::vector<T>& values)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<Vector4>(fieldIndex);
-		for (auto& i : array)
-		{
-			auto& x = i["X"];
-			auto& y = i["Y"];
-			auto& z = i["Z"];
-			auto& w = i["W"];
-			list.PushBack(Vector4{ x.GetFloat(), y.GetFloat(), z.GetFloat(), w.GetFloat() });
-		}
+		frame.ListStorage = &values;
+		frame.Append = &AppendNumber<T>;
 	}
-	break;
 
-	case PrimitiveType::Rectangle:
+	static void BindNumericList(ReadFrame& frame)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<Rectangle>(fieldIndex);
-		for (auto& i : array)
+		TypeValue* value = frame.Value;
+		int index = frame.FieldIndex;
+
+		switch (frame.Primitive)
 		{
-			auto& x = i["X"];
-			auto& y = i["Y"];
-			auto& w = i["Width"];
-			auto& h = i["Height"];
-			list.PushBack(Rectangle{ x.GetFloat(), y.GetFloat(), w.GetFloat(), h.GetFloat() });
+		default:
+			break;
+
+		case PrimitiveType::Char:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<char>(index).GetValues());
+			break;
+		case PrimitiveType::UInt8:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<uint8_t>(index).GetValues());
+			break;
+		case PrimitiveType::UInt16:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<uint16_t>(index).GetValues());
+			break;
+		case PrimitiveType::Int16:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<int16_t>(index).GetValues());
+			break;
+		case PrimitiveType::UInt32:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<uint32_t>(index).GetValues());
+			break;
+		case PrimitiveType::Int32:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<int32_t>(index).GetValues());
+			break;
+		case PrimitiveType::UInt64:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<uint64_t>(index).GetValues());
+			break;
+		case PrimitiveType::Int64:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<int64_t>(index).GetValues());
+			break;
+		case PrimitiveType::Float32:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<float>(index).GetValues());
+			break;
+		case PrimitiveType::Double64:
+			BindNumericList(frame, value->GetPrimitiveListFieldValue<double>(index).GetValues());
+			break;
 		}
 	}
-	break;
 
-	case PrimitiveType::Matrix:
+	static void SetFieldValue(const ReadFrame& frame, const JsonScalar& value)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<Matrix>(fieldIndex);
-		for (auto& i : array)
+		switch (frame.Field->GetType())
 		{
-			float matf[16] = { 0 };
-			const auto& matArray = i.GetArray();
+		default:
+			break;
+
+		case FieldType::Primitive:
+			SetPrimitiveValue(frame, value);
+			break;
 
-			for (int m = 0; m < 16; m++)
+		case FieldType::PrimitiveList:
+			if (value.IsString())
+				DecodePackedField(frame, value.Text);
+			break;
+
+		case FieldType::Enumeration:
+			if (value.IsString())
 			{
-				matf[m] = matArray[m].GetFloat();
+				for (auto& [index, name] : static_cast<EnumerationFieldInfo*>(frame.Field)->TypePtr->Values)
+				{
+					if (name == value.Text)
+					{
+						frame.Value->SetFieldEnumerationValueInt(frame.FieldIndex, index);
+						break;
+					}
+				}
 			}
-			Matrix mat = FloatToMatrix(matf);
-			list.PushBack(mat);
+			break;
 		}
 	}
-	break;
 
-	case PrimitiveType::GUID:
+	static void SetPrimitiveValue(const ReadFrame& frame, const JsonScalar& value)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<Hashes::GUID>(fieldIndex);
-		for (auto& i : array)
+		TypeValue* destinationValue = frame.Value;
+		int fieldIndex = frame.FieldIndex;
+
+		if ((IsNumericType(frame.Primitive) || frame.Primitive == PrimitiveType::Bool) && (value.IsString() || value.ValueKind == JsonScalar::Kind::Null))
+			return;
+
+		switch (frame.Primitive)
 		{
-			list.PushBack(Hashes::GUID::FromString(i.GetString()));
+		default:
+			break;
+
+		case PrimitiveType::Bool:
+			destinationValue->SetFieldPrimitiveValue<bool>(fieldIndex, value.As<bool>());
+			break;
+		case PrimitiveType::Char:
+			destinationValue->SetFieldPrimitiveValue<char>(fieldIndex, value.As<char>());
+			break;
+		case PrimitiveType::UInt8:
+			destinationValue->SetFieldPrimitiveValue<uint8_t>(fieldIndex, value.As<uint8_t>());
+			break;
+		case PrimitiveType::UInt16:
+			destinationValue->SetFieldPrimitiveValue<uint16_t>(fieldIndex, value.As<uint16_t>());
+			break;
+		case PrimitiveType::Int16:
+			destinationValue->SetFieldPrimitiveValue<int16_t>(fieldIndex, value.As<int16_t>());
+			break;
+		case PrimitiveType::UInt32:
+			destinationValue->SetFieldPrimitiveValue<uint32_t>(fieldIndex, value.As<uint32_t>());
+			break;
+		case PrimitiveType::Int32:
+			destinationValue->SetFieldPrimitiveValue<int32_t>(fieldIndex, value.As<int32_t>());
+			break;
+		case PrimitiveType::UInt64:
+			destinationValue->SetFieldPrimitiveValue<uint64_t>(fieldIndex, value.As<uint64_t>());
+			break;
+		case PrimitiveType::Int64:
+			destinationValue->SetFieldPrimitiveValue<int64_t>(fieldIndex, value.As<int64_t>());
+			break;
+		case PrimitiveType::Float32:
+			destinationValue->SetFieldPrimitiveValue<float>(fieldIndex, value.As<float>());
+			break;
+		case PrimitiveType::Double64:
+			destinationValue->SetFieldPrimitiveValue<double>(fieldIndex, value.As<double>());
+			break;
+
+		case PrimitiveType::String:
+			if (value.IsString())
+				destinationValue->SetFieldPrimitiveValue<std::string>(fieldIndex, std::string(value.Text));
+			break;
+
+		case PrimitiveType::GUID:
+			if (value.IsString())
+			{
+				Hashes::GUID guid;
+				guid.Parse(value.Text);
+				destinationValue->SetFieldPrimitiveValue<Hashes::GUID>(fieldIndex, guid);
+			}
+			break;
 		}
 	}
-	break;
 
-	case PrimitiveType::Color:
+	static void DecodePackedField(const ReadFrame& frame, std::string_view text)
 	{
-		auto& list = destinationValue->GetPrimitiveListFieldValue<Color>(fieldIndex);
-		for (auto& i : array)
+		TypeValue* value = frame.Value;
+		int index = frame.FieldIndex;
+
+		switch (frame.Primitive)
 		{
-			float matf[16] = { 0 };
-			const auto& colorArray = i.GetArray();
-
-			Color color;
-			color.r = colorArray[0].GetInt();
-			color.g = colorArray[1].GetInt();
-			color.b = colorArray[2].GetInt();
-			color.a = colorArray[3].GetInt();
-			list.PushBack(color);
+		default:
+			break;
+
+		case PrimitiveType::Char:
+			DecodePackedList(value->GetPrimitiveListFieldValue<char>(index).GetValues(), text);
+			break;
+		case PrimitiveType::UInt8:
+			DecodePackedList(value->GetPrimitiveListFieldValue<uint8_t>(index).GetValues(), text);
+			break;
+		case PrimitiveType::UInt16:
+			DecodePackedList(value->GetPrimitiveListFieldValue<uint16_t>(index).GetValues(), text);
+			break;
+		case PrimitiveType::Int16:
+			DecodePackedList(value->GetPrimitiveListFieldValue<int16_t>(index).GetValues(), text);
+			break;
+		case PrimitiveType::UInt32:
+			DecodePackedList(value->GetPrimitiveListFieldValue<uint32_t>(index).GetValues(), text);
+			break;
+		case PrimitiveType::Int32:
+			DecodePackedList(value->GetPrimitiveListFieldValue<int32_t>(index).GetValues(), text);
+			break;
+		case PrimitiveType::UInt64:
+			DecodePackedList(value->GetPrimitiveListFieldValue<uint64_t>(index).GetValues(), text);
+			break;
+		case PrimitiveType::Int64:
+			DecodePackedList(value->GetPrimitiveListFieldValue<int64_t>(index).GetValues(), text);
+			break;
+		case PrimitiveType::Float32:
+			DecodePackedList(value->GetPrimitiveListFieldValue<float>(index).GetValues(), text);
+			break;
+		case PrimitiveType::Double64:
+			DecodePackedList(value->GetPrimitiveListFieldValue<double>(index).GetValues(), text);
+			break;
 		}
 	}
-	break;
-	}
-
-	return true;
-}
 
-bool TypeReader::ReadTypeListValue(TypeListValue& listValue, rapidjson::Value& jsonValue)
-{
-	if (!jsonValue.HasMember(TypeName) || !jsonValue[TypeName].IsString())
-		return false;
-
-	TypeInfo* type = TypeDatabase::Get().FindType(jsonValue[TypeName].GetString());
-	if (!type)
-		return false;
-
-	if (jsonValue.HasMember(ValueName) && jsonValue[ValueName].IsArray())
+	static void AppendListValue(const ReadFrame& frame, const JsonScalar& value)
 	{
-		auto& fieldValue = jsonValue[ValueName];
-
-		const auto& array = fieldValue.GetArray();
+		if (frame.Append)
+		{
+			if (value.IsNumber())
+				frame.Append(frame.ListStorage, value);
+			return;
+		}
 
-		for (auto& i : array)
+		switch (frame.Primitive)
 		{
-			auto itemValue = listValue.PushBack(type);
-			ReadTypeValue(itemValue, i);
+		default:
+			break;
+
+		case PrimitiveType::Bool:
+			if (value.ValueKind == JsonScalar::Kind::Bool)
+				frame.Value->GetPrimitiveListFieldValue<bool>(frame.FieldIndex).PushBack(value.BoolValue);
+			break;
+
+		case PrimitiveType::String:
+			if (value.IsString())
+				frame.Value->GetPrimitiveListFieldValue<std::string>(frame.FieldIndex).PushBack(std::string(value.Text));
+			break;
+
+		case PrimitiveType::GUID:
+			if (value.IsString())
+				frame.Value->GetPrimitiveListFieldValue<Hashes::GUID>(frame.FieldIndex).PushBack(Hashes::GUID::FromString(value.Text));
+			break;
 		}
 	}
 
-	return true;
-}
-
-bool TypeReader::ReadTypeValue(TypeValue* destinationValue, rapidjson::Value& jsonValue)
-{
-	if (!jsonValue.HasMember(TypeName) || !jsonValue[TypeName].IsString())
-		return false;
-
-	TypeInfo* type = TypeDatabase::Get().FindType(jsonValue[TypeName].GetString());
-	if (!type)
-		return false;
-
-	destinationValue->SetType(type);
+	template<class T>
+	static void StoreCompound(const ReadFrame& frame, const T& value)
+	{
+		if (frame.IntoList)
+			frame.Value->GetPrimitiveListFieldValue<T>(frame.FieldIndex).PushBack(value);
+		else
+			frame.Value->SetFieldPrimitiveValue<T>(frame.FieldIndex, value);
+	}
 
-	if (jsonValue.HasMember(Fields) && jsonValue[Fields].IsObject())
+	static void FinishCompound(const ReadFrame& frame)
 	{
-		for (auto& field : jsonValue[Fields].GetObject())
+		const float* c = frame.Components;
+
+		switch (frame.Primitive)
 		{
-			int index = type->FindFieldIndex(field.name.GetString());
-			if (index >= 0)
-			{
-				auto fieldInfo = type->GetField(index);
-				switch (fieldInfo->GetType())
-				{
-				case FieldType::Primitive:
-					AddPrimtiveField(destinationValue, index, static_cast<PrimitiveFieldInfo*>(fieldInfo), field.value);
-					break;
+		default:
+			break;
+
+		case PrimitiveType::Vector2:
+			StoreCompound(frame, Vector2{ c[0], c[1] });
+			break;
+		case PrimitiveType::Vector3:
+			StoreCompound(frame, Vector3{ c[0], c[1], c[2] });
+			break;
+		case PrimitiveType::Vector4:
+			StoreCompound(frame, Vector4{ c[0], c[1], c[2], c[3] });
+			break;
+		case PrimitiveType::Rectangle:
+			StoreCompound(frame, Rectangle{ c[0], c[1], c[2], c[3] });
+			break;
+
+		case PrimitiveType::Matrix:
+		{
+			float matf[16] = { 0 };
+			for (int i = 0; i < 16; i++)
+				matf[i] = c[i];
+			StoreCompound(frame, FloatToMatrix(matf));
+		}
+		break;
 
-				case FieldType::PrimitiveList:
-					AddPrimtiveListField(destinationValue, index, static_cast<PrimitiveFieldInfo*>(fieldInfo), field.value);
-					break;
+		case PrimitiveType::Color:
+			StoreCompound(frame, Color{ (unsigned char)c[0], (unsigned char)c[1], (unsigned char)c[2], (unsigned char)c[3] });
+			break;
+		}
+	}
+};
 
-				case FieldType::Enumeration:
-					AddEnumerationeField(destinationValue, index, static_cast<EnumerationFieldInfo*>(fieldInfo), field.value);
-					break;
+//--------------------------------------------------------------
+//   TypeReader
+//--------------------------------------------------------------
 
-				case FieldType::Type:
-					ReadTypeValue(destinationValue->GetTypeFieldValue(index), field.value);
-					break;
+// the writer emits the shortest text for each real, it only reads back to the same bits when parsed exactly
+static constexpr unsigned ParseFlags = kParseFullPrecisionFlag;
 
-				case FieldType::TypeList:
-					ReadTypeListValue(destinationValue->GetTypeListFieldValue(index), field.value);
-					break;
-				}
-			}
-		}
-	}
+void TypeReader::ReportStats(const ListCodecStats& stats, const std::string& fileName)
+{
+	Stats = stats;
+	if (Stats.Lists == 0)
+		return;
 
-	return true;
+	TraceLog(LOG_INFO, "TypeIO: %s decoded %d compressed lists, %s from %s (%.1fx) at %.0f MB/s", fileName.c_str(), int(Stats.Lists),
+		MemoryStats::FormatBytes(Stats.RawBytes).c_str(), MemoryStats::FormatBytes(Stats.EncodedBytes).c_str(), Stats.GetRatio(), Stats.GetDecodeSpeed());
 }
 
 bool TypeReader::Read(TypeValue* value, const std::string& fileName)
 {
-	std::string fileData = ReadFileText(fileName.c_str());
-	if (fileData.empty())
-		return false;
+	PROFILE_SCOPE("TypeReader::Read");
 
-	Document d;
-	d.Parse(fileData.c_str());
+	Stats = ListCodecStats();
 
-	RootDocument = &d;
+	if (UseArena)
+		value->SetArena(TypeArena::Create());
+	TypeArena::Scope arenaScope(value->GetArena());
 
-	if (RootDocument->HasMember(Version))
+	// a tree being read is not being edited, nobody is told about each field
+	ValueChangedEvent::SuppressScope suppressScope;
+
+	TypeReadHandler handler(value);
+	Reader reader;
+	ParseResult result;
+
+	auto file = std::make_shared<MappedFile>();
+	if (MapFile && file->Open(fileName))
 	{
-		// (*RootDocument)[Version].GetString()
-	}
+		if (BinaryTypeReader::IsBinaryData(file->GetData(), file->GetSize()))
+		{
+			BinaryTypeReader binaryReader;
+			binaryReader.DeferLazyLists = DeferLazyLists;
+			binaryReader.UseArena = false;
+			bool result = binaryReader.Read(value, std::shared_ptr<const MappedFile>(std::move(file)));
+			ReportStats(binaryReader.Stats, fileName);
+			return result;
+		}
 
-	if (RootDocument->HasMember(RootData))
+		// the parser reads the mapped pages directly, only the string being decoded is ever copied.
+		// a terminated mapping can go through StringStream, which is the stream rapidjson scans with SIMD
+		const char* text = reinterpret_cast<const char*>(file->GetData());
+		if (file->IsNullTerminated())
+		{
+			StringStream stream(text);
+			result = reader.Parse<ParseFlags>(stream, handler);
+		}
+		else
+		{
+			MemoryStream stream(text, file->GetSize());
+			result = reader.Parse<ParseFlags>(stream, handler);
+		}
+	}
+	else
 	{
-		Value& rootObject = (*RootDocument)[RootData];
-		if (!rootObject.IsObject())
+		FILE* fp = fopen(fileName.c_str(), "rb");
+		if (!fp)
 			return false;
 
-		return ReadTypeValue(value, rootObject);
+		char magic[sizeof(BinaryMagic)] = { 0 };
+		bool isBinary = fread(magic, sizeof(magic), 1, fp) == 1 && BinaryTypeReader::IsBinaryData(reinterpret_cast<const uint8_t*>(magic), sizeof(magic));
+		if (isBinary)
+		{
+			fclose(fp);
+			BinaryTypeReader binaryReader;
+			binaryReader.DeferLazyLists = DeferLazyLists;
+			binaryReader.UseArena = false;
+			bool result = binaryReader.Read(value, fileName);
+			ReportStats(binaryReader.Stats, fileName);
+			return result;
+		}
+		fseek(fp, 0, SEEK_SET);
+
+		// only this much of the file is in memory at once
+		std::vector<char> buffer(64 * 1024);
+		FileReadStream stream(fp, buffer.data(), buffer.size());
+		result = reader.Parse<ParseFlags>(stream, handler);
+		fclose(fp);
 	}
-	return false;
+
+	return !result.IsError() && handler.RootRead;
 }
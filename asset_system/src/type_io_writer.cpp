@@ -2,664 +2,434 @@
 
 #include "field_info.h"
 #include "attributes.h"
+#include "Profiler.h"
+#include "Base64.h"
 
-#include "rapidjson/document.h"
-#include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
 #include "rapidjson/prettywriter.h"
+#include "rapidjson/filewritestream.h"
 
 #include "raymath.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <type_traits>
+
 using namespace TypeIO;
 using namespace rapidjson;
 
-
 //--------------------------------------------------------------
-//   File IO
+//   TypeWriteEmitter
 //--------------------------------------------------------------
 
-void WriteFileText(const std::string& fileName, const char* data, size_t size)
+// Walks a value and sends it to a rapidjson Writer or PrettyWriter as it goes, nothing is buffered but the
+// stream itself. The layout matches what TypeReadHandler expects, TypeName always comes first.
+template<class JsonWriter>
+class TypeWriteEmitter
 {
-	std::string contents;
-	FILE* fp = fopen(fileName.c_str(), "wt");
-	if (!fp)
-		return;
-
-	fwrite(data, size, 1, fp);
-	fclose(fp);
-}
-
-//--------------------------------------------------------------
-//   TypeWriter
-//--------------------------------------------------------------
+public:
+	TypeWriteEmitter(JsonWriter& json) : Json(json) {}
 
-bool TypeWriter::SetPrimitiveFieldJson(PrimitiveType primType, const FieldValue* value, rapidjson::Value& fieldType, rapidjson::Value& returnValue)
-{
-	switch (primType)
+	void WriteTypeValue(const TypeValue* value)
 	{
-	default:
-	case PrimitiveType::Unknown:
-		returnValue.SetString("UNKNOWN!!!!!!");
-		return false;
+		Json.StartObject();
 
-	case PrimitiveType::Bool:
-		fieldType.SetString("bool");
-		returnValue.SetBool(static_cast<const PrimitiveFieldValue<bool>*>(value)->GetValue());
-		break;
-	case PrimitiveType::Char:
-		fieldType.SetString("char");
-		returnValue.SetInt(static_cast<const PrimitiveFieldValue<char>*>(value)->GetValue());
-		break;
-	case PrimitiveType::UInt8:
-		fieldType.SetString("uint8");
-		returnValue.SetUint(static_cast<const PrimitiveFieldValue<uint8_t>*>(value)->GetValue());
-		break;
-	case PrimitiveType::UInt16:
-		fieldType.SetString("uint16");
-		returnValue.SetUint(static_cast<const PrimitiveFieldValue<uint16_t>*>(value)->GetValue());
-		break;
-	case PrimitiveType::Int16:
-		fieldType.SetString("int16");
-		returnValue.SetInt(static_cast<const PrimitiveFieldValue<int16_t>*>(value)->GetValue());
-		break;
-	case PrimitiveType::UInt32:
-		fieldType.SetString("uint32");
-		returnValue.SetUint(static_cast<const PrimitiveFieldValue<uint32_t>*>(value)->GetValue());
-		break;
-	case PrimitiveType::Int32:
-		fieldType.SetString("int32");
-		returnValue.SetInt(static_cast<const PrimitiveFieldValue<int32_t>*>(value)->GetValue());
-		break;
-	case PrimitiveType::UInt64:
-		fieldType.SetString("uint64");
-		returnValue.SetUint64(static_cast<const PrimitiveFieldValue<uint64_t>*>(value)->GetValue());
-		break;
-	case PrimitiveType::Int64:
-		fieldType.SetString("int64");
-		returnValue.SetInt64(static_cast<const PrimitiveFieldValue<int64_t>*>(value)->GetValue());
-		break;
-	case PrimitiveType::Float32:
-		fieldType.SetString("float");
-		returnValue.SetFloat(static_cast<const PrimitiveFieldValue<float>*>(value)->GetValue());
-		break;
-	case PrimitiveType::Double64:
-		fieldType.SetString("double");
-		returnValue.SetDouble(static_cast<const PrimitiveFieldValue<double>*>(value)->GetValue());
-		break;
-	case PrimitiveType::String:
-		fieldType.SetString("string");
-		returnValue.SetString(StringRef(static_cast<const PrimitiveFieldValue<std::string>*>(value)->GetValue().c_str()));
-		break;
-	case PrimitiveType::Vector2:
-	{
-		fieldType.SetString("vector2");
-		returnValue.SetObject();
+		const TypeInfo* type = value->GetType();
+		if (!type)
+		{
+			Json.EndObject();
+			return;
+		}
 
-		Vector2 vec = static_cast<const PrimitiveFieldValue<Vector2>*>(value)->GetValue();
-		Value x;
-		x.SetFloat(vec.x);
-		returnValue.AddMember("X", x, RootDocument->GetAllocator());
+		Json.Key(TypeName);
+		WriteString(type->TypeName);
 
-		Value y;
-		y.SetFloat(vec.y);
-		returnValue.AddMember("Y", y, RootDocument->GetAllocator());
-	}
-	break;
+		Json.Key(Fields);
+		Json.StartObject();
+		int fieldCount = type->GetFieldCount();
+		for (int index = 0; index < fieldCount; index++)
+		{
+			if (value->FieldIsDefault(index))
+				continue;
 
-	case PrimitiveType::Vector3:
-	{
-		fieldType.SetString("vector3");
-		returnValue.SetObject();
+			const FieldInfo* fieldInfo = type->GetField(index);
+			const FieldValue* fieldValue = value->GetFieldValue(index);
 
-		Vector3 vec = static_cast<const PrimitiveFieldValue<Vector3>*>(value)->GetValue();
-		Value x;
-		x.SetFloat(vec.x);
-		returnValue.AddMember("X", x, RootDocument->GetAllocator());
+			switch (fieldInfo->GetType())
+			{
+			case FieldType::Primitive:
+			case FieldType::PrimitiveList:
+			case FieldType::Enumeration:
+			case FieldType::Type:
+			case FieldType::TypeList:
+				break;
+
+			default:
+				continue;
+			}
 
-		Value y;
-		y.SetFloat(vec.y);
-		returnValue.AddMember("Y", y, RootDocument->GetAllocator());
+			Json.Key(fieldInfo->GetName().c_str(), SizeType(fieldInfo->GetName().size()));
 
-		Value z;
-		z.SetFloat(vec.z);
-		returnValue.AddMember("Z", z, RootDocument->GetAllocator());
-	}
-	break;
+			switch (fieldInfo->GetType())
+			{
+			case FieldType::Primitive:
+			case FieldType::PrimitiveList:
+				WritePrimitiveField(fieldInfo, value, index);
+				break;
 
-	case PrimitiveType::Vector4:
-	{
-		fieldType.SetString("vector4");
-		returnValue.SetObject();
+			case FieldType::Enumeration:
+				WriteEnumerationField(fieldInfo, fieldValue);
+				break;
 
-		Vector4 vec = static_cast<const PrimitiveFieldValue<Vector4>*>(value)->GetValue();
-		Value x;
-		x.SetFloat(vec.x);
-		returnValue.AddMember("X", x, RootDocument->GetAllocator());
+			case FieldType::Type:
+				WriteTypeValue(static_cast<const TypeValue*>(fieldValue));
+				break;
 
-		Value y;
-		y.SetFloat(vec.y);
-		returnValue.AddMember("Y", y, RootDocument->GetAllocator());
+			case FieldType::TypeList:
+				WriteTypeListValue(static_cast<const TypeListValue*>(fieldValue));
+				break;
 
-		Value z;
-		z.SetFloat(vec.z);
-		returnValue.AddMember("Z", z, RootDocument->GetAllocator());
+			default:
+				break;
+			}
+		}
+		Json.EndObject();
 
-		Value w;
-		w.SetFloat(vec.w);
-		returnValue.AddMember("W", w, RootDocument->GetAllocator());
+		Json.EndObject();
 	}
-	break;
-
-	case PrimitiveType::Rectangle:
-	{
-		fieldType.SetString("rectangle");
-		returnValue.SetObject();
-
-		Rectangle rect = static_cast<const PrimitiveFieldValue<Rectangle>*>(value)->GetValue();
-		Value x;
-		x.SetFloat(rect.x);
-		returnValue.AddMember("X", x, RootDocument->GetAllocator());
-
-		Value y;
-		y.SetFloat(rect.y);
-		returnValue.AddMember("Y", y, RootDocument->GetAllocator());
 
-		Value w;
-		w.SetFloat(rect.width);
-		returnValue.AddMember("Width", w, RootDocument->GetAllocator());
+protected:
+	JsonWriter& Json;
 
-		Value h;
-		h.SetFloat(rect.height);
-		returnValue.AddMember("Height", h, RootDocument->GetAllocator());
+	void WriteString(const std::string& text)
+	{
+		Json.String(text.c_str(), SizeType(text.size()), true);
 	}
-	break;
 
-	case PrimitiveType::Matrix:
+	// shortest text that reads back to the same bits, floats are formatted as floats so 0.1f stays 0.1
+	template<class T>
+	void WriteReal(T value)
 	{
-		fieldType.SetString("matrix");
-		returnValue.SetArray();
-
-		Matrix mat = static_cast<const PrimitiveFieldValue<Matrix>*>(value)->GetValue();
-		for (float v : MatrixToFloat(mat))
+		// not valid json, the writer refuses these the same way it always has
+		if (!std::isfinite(value))
 		{
-			Value matValue;
-			matValue.SetFloat(v);
-			returnValue.PushBack(matValue, RootDocument->GetAllocator());
+			Json.Double(value);
+			return;
 		}
-	}
-	break;
-
-	case PrimitiveType::GUID:
-		fieldType.SetString("GUID");
-		returnValue.SetString(StringRef(static_cast<const PrimitiveFieldValue<Hashes::GUID>*>(value)->GetValue().ToString().c_str()));
-		break;
-
-	case PrimitiveType::Color:
-	{
-		fieldType.SetString("color");
-		returnValue.SetArray();
 
-		Color color = static_cast<const PrimitiveFieldValue<Color>*>(value)->GetValue();
+		char buffer[32];
+		char* end = std::to_chars(buffer, buffer + sizeof(buffer) - 2, value).ptr;
 
-		Value colorValue;
-		colorValue.SetInt(color.r);
-		returnValue.PushBack(colorValue, RootDocument->GetAllocator());
-
-		colorValue.SetInt(color.g);
-		returnValue.PushBack(colorValue, RootDocument->GetAllocator());
-
-		colorValue.SetInt(color.b);
-		returnValue.PushBack(colorValue, RootDocument->GetAllocator());
-
-		colorValue.SetInt(color.a);
-		returnValue.PushBack(colorValue, RootDocument->GetAllocator());
-	}
-	break;
-	}
-
-	return true;
-}
-
-bool TypeWriter::SetPrimitiveFieldListJson(PrimitiveType primType, const FieldValue* value, rapidjson::Value& fieldType, rapidjson::Value& returnValue)
-{
-	returnValue.SetArray();
-
-	switch (primType)
-	{
-	default:
-	case PrimitiveType::Unknown:
-		returnValue.SetString("UNKNOWN!!!!!!");
-		return false;
-
-	case PrimitiveType::Bool:
-		fieldType.SetString("bool[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<bool>*>(value))
-		{
-			Value v;
-			v.SetBool(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::Char:
-		fieldType.SetString("char[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<char>*>(value))
-		{
-			Value v;
-			v.SetInt(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::UInt8:
-		fieldType.SetString("uint8[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<uint8_t>*>(value))
-		{
-			Value v;
-			v.SetUint(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::UInt16:
-		fieldType.SetString("uint16[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<uint16_t>*>(value))
-		{
-			Value v;
-			v.SetUint(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::Int16:
-		fieldType.SetString("int16[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<int16_t>*>(value))
-		{
-			Value v;
-			v.SetInt(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::UInt32:
-		fieldType.SetString("uint32[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<uint32_t>*>(value))
-		{
-			Value v;
-			v.SetUint(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::Int32:
-		fieldType.SetString("int32[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<int32_t>*>(value))
-		{
-			Value v;
-			v.SetInt(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::UInt64:
-		fieldType.SetString("uint64[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<uint64_t>*>(value))
-		{
-			Value v;
-			v.SetUint64(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::Int64:
-		fieldType.SetString("int64[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<int64_t>*>(value))
-		{
-			Value v;
-			v.SetInt64(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::Float32:
-		fieldType.SetString("float[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<float>*>(value))
-		{
-			Value v;
-			v.SetFloat(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::Double64:
-		fieldType.SetString("double[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<double>*>(value))
+		// keep whole numbers looking like reals, and -0 from reading back as the integer 0
+		if (std::none_of(buffer, end, [](char c) { return c == '.' || c == 'e'; }))
 		{
-			Value v;
-			v.SetDouble(value);
-			returnValue.PushBack(v, RootDocument->GetAllocator());
+			*end++ = '.';
+			*end++ = '0';
 		}
-		break;
-	case PrimitiveType::String:
-		fieldType.SetString("string[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<std::string>*>(value))
-		{
-			Value v;
-			v.SetString(StringRef(value.c_str()));
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
-	case PrimitiveType::Vector2:
-	{
-		fieldType.SetString("vector2[]");
 
-		for (const auto& vec : *static_cast<const PrimitiveListFieldValue<Vector2>*>(value))
-		{
-			Value v;
-			v.SetObject();
-			Value x;
-			x.SetFloat(vec.x);
-			v.AddMember("X", x, RootDocument->GetAllocator());
-
-			Value y;
-			y.SetFloat(vec.y);
-			v.AddMember("Y", y, RootDocument->GetAllocator());
-
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
+		Json.RawValue(buffer, size_t(end - buffer), kNumberType);
 	}
-	break;
 
-	case PrimitiveType::Vector3:
+	void WriteTypeListValue(const TypeListValue* value)
 	{
-		fieldType.SetString("vector3[]");
+		Json.StartObject();
 
-		for (auto& vec : *static_cast<const PrimitiveListFieldValue<Vector3>*>(value))
+		const TypeInfo* type = value->GetType();
+		if (type)
 		{
-			Value v;
-			v.SetObject();
-			Value x;
-			x.SetFloat(vec.x);
-			v.AddMember("X", x, RootDocument->GetAllocator());
-
-			Value y;
-			y.SetFloat(vec.y);
-			v.AddMember("Y", y, RootDocument->GetAllocator());
+			Json.Key(TypeName);
+			WriteString(type->TypeName);
 
-			Value z;
-			z.SetFloat(vec.z);
-			v.AddMember("Z", z, RootDocument->GetAllocator());
+			Json.Key(ValueName);
+			Json.StartArray();
+			for (size_t i = 0; i < value->Size(); i++)
+			{
+				const TypeInfo* itemType = value->Get(i).GetType();
+				if (itemType && itemType->HasAttribute<AttributeTypes::NoSerializationAttribute>())
+					continue;
 
-			returnValue.PushBack(v, RootDocument->GetAllocator());
+				WriteTypeValue(&value->Get(i));
+			}
+			Json.EndArray();
 		}
+
+		Json.EndObject();
 	}
-	break;
 
-	case PrimitiveType::Vector4:
+	void WriteEnumerationField(const FieldInfo* fieldInfo, const FieldValue* value)
 	{
-		fieldType.SetString("vector4[]");
-		for (auto& vec : *static_cast<const PrimitiveListFieldValue<Vector4>*>(value))
-		{
-			Value v;
-			v.SetObject();
-			Value x;
-			x.SetFloat(vec.x);
-			v.AddMember("X", x, RootDocument->GetAllocator());
+		const EnumerationFieldInfo* enumFieldInfo = static_cast<const EnumerationFieldInfo*>(fieldInfo);
+		const EnumerationFieldValue* enumFieldValue = static_cast<const EnumerationFieldValue*>(value);
 
-			Value y;
-			y.SetFloat(vec.y);
-			v.AddMember("Y", y, RootDocument->GetAllocator());
+		Json.StartObject();
 
-			Value z;
-			z.SetFloat(vec.z);
-			v.AddMember("Z", z, RootDocument->GetAllocator());
-
-			Value w;
-			w.SetFloat(vec.w);
-			v.AddMember("W", w, RootDocument->GetAllocator());
+		auto itr = enumFieldInfo->TypePtr->Values.find(enumFieldValue->GetValue());
+		if (itr != enumFieldInfo->TypePtr->Values.end())
+		{
+			// enum name
+			Json.Key(TypeName);
+			WriteString(enumFieldInfo->TypePtr->TypeName);
 
-			returnValue.PushBack(v, RootDocument->GetAllocator());
+			Json.Key(ValueName);
+			WriteString(itr->second);
 		}
+
+		Json.EndObject();
 	}
-	break;
 
-	case PrimitiveType::Rectangle:
+	void WriteElement(bool value) { Json.Bool(value); }
+	void WriteElement(char value) { Json.Int(value); }
+	void WriteElement(uint8_t value) { Json.Uint(value); }
+	void WriteElement(uint16_t value) { Json.Uint(value); }
+	void WriteElement(int16_t value) { Json.Int(value); }
+	void WriteElement(uint32_t value) { Json.Uint(value); }
+	void WriteElement(int32_t value) { Json.Int(value); }
+	void WriteElement(uint64_t value) { Json.Uint64(value); }
+	void WriteElement(int64_t value) { Json.Int64(value); }
+	void WriteElement(float value) { WriteReal(value); }
+	void WriteElement(double value) { WriteReal(value); }
+	void WriteElement(const std::string& value) { WriteString(value); }
+	void WriteElement(const Hashes::GUID& value) { WriteString(value.ToString()); }
+
+	void WriteElement(const Vector2& value)
 	{
-		fieldType.SetString("rectangle[]");
-
-		for (auto& vec : *static_cast<const PrimitiveListFieldValue<Rectangle>*>(value))
-		{
-			Value v;
-			v.SetObject();
-			Value x;
-			x.SetFloat(vec.x);
-			v.AddMember("X", x, RootDocument->GetAllocator());
-
-			Value y;
-			y.SetFloat(vec.y);
-			v.AddMember("Y", y, RootDocument->GetAllocator());
-
-			Value w;
-			w.SetFloat(vec.width);
-			v.AddMember("Width", w, RootDocument->GetAllocator());
-
-			Value h;
-			h.SetFloat(vec.height);
-			v.AddMember("Height", h, RootDocument->GetAllocator());
-
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
+		Json.StartObject();
+		Json.Key("X");
+		WriteElement(value.x);
+		Json.Key("Y");
+		WriteElement(value.y);
+		Json.EndObject();
 	}
-	break;
 
-	case PrimitiveType::Matrix:
+	void WriteElement(const Vector3& value)
 	{
-		fieldType.SetString("matrix[]");
-
-		for (auto& vec : *static_cast<const PrimitiveListFieldValue<Matrix>*>(value))
-		{
-			Value v;
-			v.SetArray();
-			Matrix mat = static_cast<const PrimitiveFieldValue<Matrix>*>(value)->GetValue();
-			for (float m : MatrixToFloat(mat))
-			{
-				Value matValue;
-				matValue.SetFloat(m);
-				v.PushBack(matValue, RootDocument->GetAllocator());
-			}
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
+		Json.StartObject();
+		Json.Key("X");
+		WriteElement(value.x);
+		Json.Key("Y");
+		WriteElement(value.y);
+		Json.Key("Z");
+		WriteElement(value.z);
+		Json.EndObject();
 	}
-	break;
-
-	case PrimitiveType::GUID:
-		fieldType.SetString("GUID[]");
-		for (const auto& value : *static_cast<const PrimitiveListFieldValue<Hashes::GUID>*>(value))
-		{
-			Value v;
-			v.SetString(StringRef(value.ToString().c_str()));
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
-		break;
 
-	case PrimitiveType::Color:
+	void WriteElement(const Vector4& value)
 	{
-		fieldType.SetString("color[]");
-
-		for (auto& vec : *static_cast<const PrimitiveListFieldValue<Color>*>(value))
-		{
-			Value v;
-			v.SetArray();
-			Color color = static_cast<const PrimitiveFieldValue<Color>*>(value)->GetValue();
-
-			Value colorValue;
-			colorValue.SetInt(color.r);
-			v.PushBack(colorValue, RootDocument->GetAllocator());
-
-			colorValue.SetInt(color.g);
-			v.PushBack(colorValue, RootDocument->GetAllocator());
-
-			colorValue.SetInt(color.b);
-			v.PushBack(colorValue, RootDocument->GetAllocator());
-
-			colorValue.SetInt(color.a);
-			v.PushBack(colorValue, RootDocument->GetAllocator());
-
-			returnValue.PushBack(v, RootDocument->GetAllocator());
-		}
+		Json.StartObject();
+		Json.Key("X");
+		WriteElement(value.x);
+		Json.Key("Y");
+		WriteElement(value.y);
+		Json.Key("Z");
+		WriteElement(value.z);
+		Json.Key("W");
+		WriteElement(value.w);
+		Json.EndObject();
 	}
-	break;
-	}
-
-	return true;
-}
-
-Value TypeWriter::WritePrimitiveField(const FieldInfo* fieldInfo, const FieldValue* value)
-{
-	const PrimitiveFieldInfo* primField = static_cast<const PrimitiveFieldInfo*>(fieldInfo);
-
-	Value fieldValue;
-	fieldValue.SetObject();
 
-	Value fieldType;
-	Value returnValue;
-
-	if (fieldInfo->GetType() == FieldType::PrimitiveList)
+	void WriteElement(const Rectangle& value)
 	{
-		if (SetPrimitiveFieldListJson(primField->GetPrimitiveType(), value, fieldType, returnValue))
-		{
-			fieldValue.AddMember(TypeName, fieldType, RootDocument->GetAllocator());
-			fieldValue.AddMember(ValueName, returnValue, RootDocument->GetAllocator());
-		}
+		Json.StartObject();
+		Json.Key("X");
+		WriteElement(value.x);
+		Json.Key("Y");
+		WriteElement(value.y);
+		Json.Key("Width");
+		WriteElement(value.width);
+		Json.Key("Height");
+		WriteElement(value.height);
+		Json.EndObject();
 	}
-	else
+
+	void WriteElement(const Matrix& value)
 	{
-		if (SetPrimitiveFieldJson(primField->GetPrimitiveType(), value, fieldType, returnValue))
-		{
-			fieldValue.AddMember(TypeName, fieldType, RootDocument->GetAllocator());
-			fieldValue.AddMember(ValueName, returnValue, RootDocument->GetAllocator());
-		}
+		Json.StartArray();
+		for (float m : MatrixToFloat(value))
+			WriteElement(m);
+		Json.EndArray();
 	}
-	return fieldValue;
-}
-
-Value TypeWriter::WriteEnumerationField(const FieldInfo* fieldInfo, const FieldValue* value)
-{
-	const EnumerationFieldInfo* enumFieldInfo = static_cast<const EnumerationFieldInfo*>(fieldInfo);
-	const EnumerationFieldValue* enumFieldValue = static_cast<const EnumerationFieldValue*>(value);
-
 
-	Value fieldValue;
-	fieldValue.SetObject();
+	void WriteElement(const Color& value)
+	{
+		Json.StartArray();
+		Json.Int(value.r);
+		Json.Int(value.g);
+		Json.Int(value.b);
+		Json.Int(value.a);
+		Json.EndArray();
+	}
 
-	auto index = enumFieldValue->GetValue();
-	auto itr = enumFieldInfo->TypePtr->Values.find(index);
-	if (itr == enumFieldInfo->TypePtr->Values.end())
-		return fieldValue;
+	template<class T>
+	void WritePrimitive(const char* typeName, const T& value)
+	{
+		Json.StartObject();
+		Json.Key(TypeName);
+		Json.String(typeName);
+		Json.Key(ValueName);
+		WriteElement(value);
+		Json.EndObject();
+	}
 
-	// enum name
-	fieldValue.AddMember(TypeName, StringRef(enumFieldInfo->TypePtr->TypeName.c_str(), enumFieldInfo->TypePtr->TypeName.size()), RootDocument->GetAllocator());
-	fieldValue.AddMember(ValueName, StringRef(itr->second.c_str(), itr->second.size()), RootDocument->GetAllocator());
+	// numeric lists can be packed into one base64 string of the raw elements
+	template<class T>
+	void WritePrimitiveList(const char* typeName, const FieldValue* value, bool packed)
+	{
+		const std::vector<T>& values = static_cast<const PrimitiveListFieldValue<T>*>(value)->GetValues();
 
-	return fieldValue;
-}
+		Json.StartObject();
+		Json.Key(TypeName);
+		Json.String(typeName);
+		Json.Key(ValueName);
 
-Value TypeWriter::WriteTypeValue(const TypeValue* value)
-{
-	Value  rootType;
-	rootType.SetObject();
+		if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+		{
+			if (packed)
+			{
+				WriteString(Base64::Encode(values.data(), values.size() * sizeof(T)));
+				Json.EndObject();
+				return;
+			}
+		}
 
-	const TypeInfo* type = value->GetType();
-	if (!type)
-		return rootType;
+		Json.StartArray();
+		for (const auto& item : values)
+			WriteElement(T(item));
+		Json.EndArray();
 
-	Value typeObjet;
-	typeObjet.SetString(type->TypeName.c_str(), RootDocument->GetAllocator());
-	rootType.AddMember(TypeName, typeObjet, RootDocument->GetAllocator());
+		Json.EndObject();
+	}
 
-	Value fieldList;
-	fieldList.SetObject();
-	for (const auto& [index, fieldValue] : value->GetTypeFieldValues())
+	template<class T>
+	void WritePrimitiveOrList(const TypeValue* owner, int index, bool isList, bool packed, const char* typeName, const char* listTypeName)
 	{
-		Value fieldObject;
+		if (isList)
+			WritePrimitiveList<T>(listTypeName, owner->GetFieldValue(index), packed);
+		else
+			WritePrimitive<T>(typeName, owner->GetFieldPrimitiveValue<T>(index));
+	}
 
-		const FieldInfo* fieldInfo = type->GetField(index);
-		FieldType fieldType = fieldInfo->GetType();
+	void WritePrimitiveField(const FieldInfo* fieldInfo, const TypeValue* owner, int index)
+	{
+		bool isList = fieldInfo->GetType() == FieldType::PrimitiveList;
+		bool packed = isList && fieldInfo->HasAttribute<AttributeTypes::PackedListAttribute>();
 
-		switch (fieldType)
-		{
-		case Types::FieldType::Primitive:
-		case Types::FieldType::PrimitiveList:
+		switch (static_cast<const PrimitiveFieldInfo*>(fieldInfo)->GetPrimitiveType())
 		{
-			fieldObject = WritePrimitiveField(fieldInfo, fieldValue.get());
-		}
-		break;
-
-		case Types::FieldType::Enumeration:
-			fieldObject = WriteEnumerationField(fieldInfo, fieldValue.get());
+		default:
+		case PrimitiveType::Unknown:
+			Json.StartObject();
+			Json.EndObject();
 			break;
 
-		case Types::FieldType::Type:
-		{
-			fieldObject = WriteTypeValue(static_cast<const TypeValue*>(fieldValue.get()));
-		}
-		break;
-
-		case Types::FieldType::TypeList:
-		{
-			fieldObject = WriteTypeListValue(static_cast<const TypeListValue*>(fieldValue.get()));
-		}
-		break;
-
-		default:
-			continue;
+		case PrimitiveType::Bool:
+			WritePrimitiveOrList<bool>(owner, index, isList, packed, "bool", "bool[]");
+			break;
+		case PrimitiveType::Char:
+			WritePrimitiveOrList<char>(owner, index, isList, packed, "char", "char[]");
+			break;
+		case PrimitiveType::UInt8:
+			WritePrimitiveOrList<uint8_t>(owner, index, isList, packed, "uint8", "uint8[]");
+			break;
+		case PrimitiveType::UInt16:
+			WritePrimitiveOrList<uint16_t>(owner, index, isList, packed, "uint16", "uint16[]");
+			break;
+		case PrimitiveType::Int16:
+			WritePrimitiveOrList<int16_t>(owner, index, isList, packed, "int16", "int16[]");
+			break;
+		case PrimitiveType::UInt32:
+			WritePrimitiveOrList<uint32_t>(owner, index, isList, packed, "uint32", "uint32[]");
+			break;
+		case PrimitiveType::Int32:
+			WritePrimitiveOrList<int32_t>(owner, index, isList, packed, "int32", "int32[]");
+			break;
+		case PrimitiveType::UInt64:
+			WritePrimitiveOrList<uint64_t>(owner, index, isList, packed, "uint64", "uint64[]");
+			break;
+		case PrimitiveType::Int64:
+			WritePrimitiveOrList<int64_t>(owner, index, isList, packed, "int64", "int64[]");
+			break;
+		case PrimitiveType::Float32:
+			WritePrimitiveOrList<float>(owner, index, isList, packed, "float", "float[]");
+			break;
+		case PrimitiveType::Double64:
+			WritePrimitiveOrList<double>(owner, index, isList, packed, "double", "double[]");
+			break;
+		case PrimitiveType::String:
+			WritePrimitiveOrList<std::string>(owner, index, isList, packed, "string", "string[]");
+			break;
+		case PrimitiveType::Vector2:
+			WritePrimitiveOrList<Vector2>(owner, index, isList, packed, "vector2", "vector2[]");
+			break;
+		case PrimitiveType::Vector3:
+			WritePrimitiveOrList<Vector3>(owner, index, isList, packed, "vector3", "vector3[]");
+			break;
+		case PrimitiveType::Vector4:
+			WritePrimitiveOrList<Vector4>(owner, index, isList, packed, "vector4", "vector4[]");
+			break;
+		case PrimitiveType::Rectangle:
+			WritePrimitiveOrList<Rectangle>(owner, index, isList, packed, "rectangle", "rectangle[]");
+			break;
+		case PrimitiveType::Matrix:
+			WritePrimitiveOrList<Matrix>(owner, index, isList, packed, "matrix", "matrix[]");
+			break;
+		case PrimitiveType::GUID:
+			WritePrimitiveOrList<Hashes::GUID>(owner, index, isList, packed, "GUID", "GUID[]");
+			break;
+		case PrimitiveType::Color:
+			WritePrimitiveOrList<Color>(owner, index, isList, packed, "color", "color[]");
 			break;
 		}
-
-		fieldList.AddMember(StringRef(fieldInfo->GetName().c_str()), fieldObject, RootDocument->GetAllocator());
-
 	}
-	rootType.AddMember(Fields, fieldList, RootDocument->GetAllocator());
-	return rootType;
-}
+};
 
-rapidjson::Value TypeWriter::WriteTypeListValue(const TypeListValue* value)
+template<class JsonWriter>
+static void WriteDocument(JsonWriter& json, const TypeValue* value)
 {
-	Value  rootType;
-	rootType.SetObject();
-	const TypeInfo* type = value->GetType();
-	if (!type)
-		return rootType;
+	json.StartObject();
 
-	Value typeObjet;
-	typeObjet.SetString(type->TypeName.c_str(), RootDocument->GetAllocator());
-	rootType.AddMember(TypeName, typeObjet, RootDocument->GetAllocator());
+	// version info
+	json.Key(Version);
+	json.String("v1");
 
-	Value returnValue;
-	returnValue.SetArray();
+	// TODO, write meta
 
-	for (size_t i = 0; i < value->Size(); i++)
-	{
-		if (type->FieldHasAttribute<AttributeTypes::NoSerializationAttribute>(int(i)))
-			continue;
+	json.Key(RootData);
+	TypeWriteEmitter<JsonWriter>(json).WriteTypeValue(value);
 
-		returnValue.PushBack(WriteTypeValue(&value->Get(i)), RootDocument->GetAllocator());
-	}
-	rootType.AddMember(ValueName, returnValue, RootDocument->GetAllocator());
-	return rootType;
+	json.EndObject();
 }
 
+//--------------------------------------------------------------
+//   TypeWriter
+//--------------------------------------------------------------
+
 bool TypeWriter::Write(TypeValue* value, const std::string& fileName)
 {
-	Document doc;
-	RootDocument = &doc;
+	PROFILE_SCOPE("TypeWriter::Write");
 
-	doc.SetObject();
-	// version info
-	Value  versionNumber;
-	versionNumber.SetString("v1", doc.GetAllocator());
-	doc.AddMember(Version, versionNumber, doc.GetAllocator());
-
-	// TODO, write meta
+	FILE* fp = fopen(fileName.c_str(), "wt");
+	if (!fp)
+		return false;
 
-	doc.AddMember(RootData, WriteTypeValue(value), doc.GetAllocator());
+	std::vector<char> buffer(64 * 1024);
+	FileWriteStream stream(fp, buffer.data(), buffer.size());
 
-	StringBuffer buffer;
-	PrettyWriter<StringBuffer> writer(buffer);
-	writer.SetMaxDecimalPlaces(3);
+	if (Compact)
+	{
+		Writer<FileWriteStream> json(stream);
+		WriteDocument(json, value);
+	}
+	else
+	{
+		PrettyWriter<FileWriteStream> json(stream);
+		WriteDocument(json, value);
+	}
 
-	doc.Accept(writer);
-	WriteFileText(fileName.c_str(), buffer.GetString(), buffer.GetSize());
+	stream.Flush();
+	bool written = ferror(fp) == 0;
+	fclose(fp);
 
-	return true;
+	return written;
 }
@@ -1,5 +1,7 @@
 #include "type_values.h"
 
+#include "raylib.h"
+
 using namespace Types;
 
 
@@ -68,80 +70,105 @@ const TypeValue* TypeValue::GetParent() const
     return reinterpret_cast<const TypeValue*>(this);
 }
 
-void TypeValue::CallValueChanged(ValueChangedEvent& eventRecord)
+namespace
 {
-    eventRecord.Value = this;
-    OnValueChanged.Invoke(eventRecord);
+    thread_local int SuppressDepth = 0;
+}
 
-    if (ParentValue)
+ValueChangedEvent::SuppressScope::SuppressScope()
+{
+    SuppressDepth++;
+}
+
+ValueChangedEvent::SuppressScope::~SuppressScope()
+{
+    SuppressDepth--;
+}
+
+bool ValueChangedEvent::IsSuppressed()
+{
+    return SuppressDepth > 0;
+}
+
+bool TypeValue::HasValueChangedListeners() const
+{
+    if (ValueChangedEvent::IsSuppressed())
+        return false;
+
+    for (const TypeValue* value = this; value; value = value->ParentValue)
     {
-        eventRecord.Path.PushFront(SubPath);
-        ParentValue->CallValueChanged(eventRecord);
+        if (!value->OnValueChanged.IsEmpty())
+            return true;
     }
+
+    return false;
 }
 
-bool TypeValue::FieldIsDefault(int fieldIndex) const
+void TypeValue::CallValueChanged(ValueChangedEvent& eventRecord)
 {
-    return Values.find(fieldIndex) == Values.end();
+    // each level adds its own path in front, so the path is built back to front during the walk
+    // and only turned around for a level that has someone to tell
+    eventRecord.Path.Reverse();
+
+    for (TypeValue* value = this; value; value = value->ParentValue)
+    {
+        eventRecord.Value = value;
+        if (!value->OnValueChanged.IsEmpty())
+        {
+            eventRecord.Path.Reverse();
+            value->OnValueChanged.Invoke(eventRecord);
+            eventRecord.Path.Reverse();
+        }
+
+        if (value->ParentValue)
+            eventRecord.Path.PushBackReversed(value->SubPath);
+    }
+
+    eventRecord.Path.Reverse();
 }
 
 void TypeValue::ResetFieldToDefault(int fieldIndex)
 {
-    auto itr = Values.find(fieldIndex);
-    if (itr != Values.end())
-        Values.erase(itr);
+    Values.Unset(fieldIndex);
 }
 
 TypeValue* TypeValue::GetTypeFieldValue(int fieldIndex)
 {
-    auto itr = Values.find(fieldIndex);
-    if (itr == Values.end())
+    FieldValue* value = Values.GetValue(fieldIndex);
+    if (!value)
     {
         const TypeFieldInfo* fieldPtr = Type->GetField<TypeFieldInfo>(fieldIndex);
 
         if (fieldPtr->IsPointer)
             return nullptr;
 
-        std::unique_ptr<TypeValue> value = std::make_unique<TypeValue>(fieldPtr->TypePtr, this, FieldPath::Field(fieldIndex));
-
-        itr = Values.insert_or_assign(fieldIndex, std::move(value)).first;
+        value = Values.SetValue(fieldIndex, std::make_unique<TypeValue>(fieldPtr->TypePtr, this, FieldPath::Field(fieldIndex)));
     }
 
-    return (TypeValue*)itr->second.get();
+    return (TypeValue*)value;
 }
 
 TypeListValue& TypeValue::GetTypeListFieldValue(int fieldIndex)
 {
-    auto itr = Values.find(fieldIndex);
-    if (itr == Values.end())
+    FieldValue* value = Values.GetValue(fieldIndex);
+    if (!value)
     {
         const TypeListFieldInfo* fieldPtr = Type->GetField<TypeListFieldInfo>(fieldIndex);
 
-        std::unique_ptr<TypeListValue> value = std::make_unique<TypeListValue>(fieldPtr->TypePtr, this, FieldPath::Field(fieldIndex));
-
-        itr = Values.insert_or_assign(fieldIndex, std::move(value)).first;
+        value = Values.SetValue(fieldIndex, std::make_unique<TypeListValue>(fieldPtr->TypePtr, this, FieldPath::Field(fieldIndex)));
     }
 
-    return *(TypeListValue*)itr->second.get();
+    return *(TypeListValue*)value;
 }
 
 TypeValue* TypeValue::SetTypeFieldPointer(const TypeInfo* type, int fieldIndex)
 {
-    auto itr = Values.find(fieldIndex);
-    if (itr != Values.end())
-    {
-        TypeValue* value = (TypeValue*)itr->second.get();
-        if (value->GetType() == type)
-            return value;
-
-        Values.erase(itr);
-    }
+    TypeValue* value = (TypeValue*)Values.GetValue(fieldIndex);
+    if (value && value->GetType() == type)
+        return value;
 
     FieldPath path(FieldPath::Field(fieldIndex));
-    std::unique_ptr<TypeValue> value = std::make_unique<TypeValue>(type, this, path);
-    itr = Values.insert_or_assign(fieldIndex, std::move(value)).first;
-
-    return (TypeValue*)itr->second.get();
+    return (TypeValue*)Values.SetValue(fieldIndex, std::make_unique<TypeValue>(type, this, path));
 }
 
 TypeValue* TypeValue::SetTypeFieldPointer(const std::string& typeName, int fieldIndex)
@@ -152,7 +179,7 @@ TypeValue* TypeValue::SetTypeFieldPointer(const std::string& typeName, int field
 void TypeValue::SetType(const TypeInfo* type)
 {
     Type = type;
-    Values.clear();
+    Values.Reset(type ? type->GetFieldCount() : 0);
 
     if (type)
     {
@@ -163,8 +190,7 @@ void TypeValue::SetType(const TypeInfo* type)
                 const TypeFieldInfo* field = Type->GetField<TypeFieldInfo>(index);
                 if (field->IsPointer && field->DefaultPtrType)
                 {
-                    std::unique_ptr<TypeValue> value = std::make_unique<TypeValue>(field->DefaultPtrType, this, FieldPath::Field(index));
-                    Values.insert_or_assign(index, std::move(value)).first;
+                    Values.SetValue(index, std::make_unique<TypeValue>(field->DefaultPtrType, this, FieldPath::Field(index)));
                 }
             }
         }
@@ -208,25 +234,24 @@ std::string_view TypeValue::GetFieldNameFromPath(const FieldPath& path, int path
 
 ListFieldValue& TypeValue::GetPrimitiveListFieldValue(int fieldIndex)
 {
-    auto itr = Values.find(fieldIndex);
-    if (itr == Values.end())
+    FieldValue* value = Values.GetValue(fieldIndex);
+    if (!value)
     {
         const PrimitiveFieldInfo* fieldPtr = Type->GetField<PrimitiveFieldInfo>(fieldIndex);
 
-        auto value = ListFieldValue::Create(fieldPtr->GetPrimitiveType(), this, SubPath + FieldPath::Field(fieldIndex));
-        itr = Values.insert_or_assign(fieldIndex, std::move(value)).first;
+        value = Values.SetValue(fieldIndex, ListFieldValue::Create(fieldPtr->GetPrimitiveType(), this, SubPath + FieldPath::Field(fieldIndex)));
     }
 
-    return *(ListFieldValue*)itr->second.get();
+    return *(ListFieldValue*)value;
 }
 
 int32_t TypeValue::GetListFieldCount(int fieldIndex)
 {
-    auto itr = Values.find(fieldIndex);
-    if (itr == Values.end() || !Type->GetField(fieldIndex)->IsList())
+    FieldValue* value = Values.GetValue(fieldIndex);
+    if (!value || !Type->GetField(fieldIndex)->IsList())
         return -1;
 
-    const ListFieldValue* fieldPtr = itr->second->GetAs<ListFieldValue>();
+    const ListFieldValue* fieldPtr = value->GetAs<ListFieldValue>();
 
     return int32_t(fieldPtr->Size());
 }
@@ -255,3 +280,75 @@ void TypeValue::SetEnumFieldFromPath(const FieldPath& path, const int& value, in
         }
     }
 }
+
+void TypeListValue::SetSource(std::unique_ptr<TypeListSource> source, size_t count)
+{
+    Values.clear();
+    Values.resize(count);
+
+    Source = std::move(source);
+    SourceIndexes.resize(count);
+    for (size_t i = 0; i < count; i++)
+        SourceIndexes[i] = i;
+
+    PendingCount = count;
+    LoadFailed = false;
+    if (PendingCount == 0)
+        ReleaseSource();
+}
+
+void TypeListValue::LoadAll() const
+{
+    TypeListValue* self = const_cast<TypeListValue*>(this);
+    for (size_t i = 0; i < Values.size() && PendingCount > 0; i++)
+    {
+        if (!Values[i])
+            self->LoadElement(i);
+    }
+}
+
+void TypeListValue::LoadElement(size_t index)
+{
+    // into the arena the rest of the tree was read into
+    TypeArena::Scope arenaScope(ParentValue ? ParentValue->GetParent()->GetArena() : nullptr);
+
+    // read without a parent so filling it in does not send change events up the tree, it is not an edit
+    auto value = std::make_unique<TypeValue>(Type, nullptr, SubPath + FieldPath::Index(int(index)));
+    if (!Source->LoadElement(SourceIndexes[index], value.get()))
+    {
+        TraceLog(LOG_WARNING, "TypeIO: element %d of a lazily loaded %s list could not be read, it is left at its defaults",
+            int(index), Type ? Type->TypeName.c_str() : "?");
+
+        // nothing half read is handed out, the element starts over as if it was just added
+        value = std::make_unique<TypeValue>(Type, nullptr, SubPath + FieldPath::Index(int(index)));
+        LoadFailed = true;
+    }
+    value->ParentValue = ParentValue;
+
+    Values[index] = std::move(value);
+
+    PendingCount--;
+    if (PendingCount == 0)
+        ReleaseSource();
+}
+
+void TypeListValue::EraseSourceIndex(size_t index)
+{
+    if (!Source)
+        return;
+
+    if (!Values[index])
+        PendingCount--;
+
+    SourceIndexes.erase(SourceIndexes.begin() + index);
+    if (PendingCount == 0)
+        ReleaseSource();
+}
+
+void TypeListValue::ReleaseSource()
+{
+    // lets go of the file as soon as nothing is left to read from it
+    Source.reset();
+    SourceIndexes.clear();
+    SourceIndexes.shrink_to_fit();
+}
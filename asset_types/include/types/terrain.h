@@ -158,7 +158,11 @@ namespace AssetTypes
 			auto* type = TypeDatabase::Get().CreateType(TypeName);
 
 			type->AddPrimitiveField<uint16_t>("Material", 128);
-			type->AddPrimitiveListField("Values", Types::PrimitiveType::UInt8);
+			auto* values = type->AddPrimitiveListField("Values", Types::PrimitiveType::UInt8);
+			values->AddAttribute<AttributeTypes::PackedListAttribute>();
+
+			// a layer is painted in patches, most of it is runs of the same weight
+			values->AddAttribute<AttributeTypes::CompressedListAttribute>();
 		}
 
 		const uint16_t& GetMaterial() const { return ValuePtr->GetFieldPrimitiveValue<uint16_t>(0); }
@@ -178,7 +182,11 @@ namespace AssetTypes
 		{
 			auto* type = TypeDatabase::Get().CreateType(TypeName);
 			type->AddTypeField("Origin", TerrainPosition::TypeName);
-			type->AddPrimitiveListField("Heightmap", Types::PrimitiveType::Float32);
+			auto* heightmap = type->AddPrimitiveListField("Heightmap", Types::PrimitiveType::Float32);
+			heightmap->AddAttribute<AttributeTypes::PackedListAttribute>();
+
+			// kept exact, neighbouring tiles share their border samples and must not drift apart
+			heightmap->AddAttribute<AttributeTypes::CompressedListAttribute>();
 			type->AddTypeListField("Layers", TerrainSplatmap::TypeName);
 		}
 
@@ -199,6 +207,9 @@ namespace AssetTypes
 			type->AddAttribute<AttributeTypes::DisplayNameAttribute>("Terrain");
 			type->AddAttribute<AssetIconAttribute>(ICON_FA_MOUNTAIN);
 
+			// a tile heightmap is ~17k floats, far too big and slow as JSON text
+			type->AddAttribute<AttributeTypes::BinarySerializationAttribute>();
+
 			auto* info = type->AddTypeField("Info", TerrainInfo::TypeName);
 			info->AddAttribute<AttributeTypes::ReadOnlyAttribute>();
 
@@ -208,6 +219,9 @@ namespace AssetTypes
 			auto* tiles = type->AddTypeListField("Tiles", TerrainTile::TypeName);
 			tiles->AddAttribute<AttributeTypes::ReadOnlyAttribute>();
 			tiles->AddAttribute<AttributeTypes::HiddenAttribute>();
+
+			// streaming and editing pull in the tiles they need, opening a terrain does not read the world
+			tiles->AddAttribute<AttributeTypes::LazyLoadAttribute>();
 		}
 
 		TerrainInfo GetInfo() const { return TerrainInfo(ValuePtr->GetTypeFieldValue(1)); }
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// standard alphabet, padded
+namespace Base64
+{
+    std::string Encode(const void* data, size_t size);
+
+    // bytes the text decodes to, 0 when the length is not a valid base64 length
+    size_t GetDecodedSize(std::string_view text);
+
+    // size must be GetDecodedSize(text), false on characters outside the alphabet
+    bool Decode(std::string_view text, void* data, size_t size);
+}
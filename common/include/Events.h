@@ -33,6 +33,8 @@ namespace Events
 			EventHandlers.emplace_back(EventHandler{ handler, token });
 		}
 
+		bool IsEmpty() const { return EventHandlers.empty(); }
+
 		void Remove(Tokens::LifetimeTokenPtr token)
 		{
 			for (auto itr = EventHandlers.begin(); itr != EventHandlers.end(); itr++)
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read only memory mapping of a whole file, pages are loaded by the OS as they are touched.
+// Empty files can not be mapped and fail to open like missing ones.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    bool Open(const std::string& fileName);
+    void Close();
+
+    bool IsOpen() const { return Data != nullptr; }
+
+    const uint8_t* GetData() const { return Data; }
+    size_t GetSize() const { return Size; }
+
+    // the OS zero fills the rest of the last page, so unless the file ends exactly on a page boundary
+    // there is a 0 right after the data and it can be read as a C string
+    bool IsNullTerminated() const;
+
+protected:
+    const uint8_t* Data = nullptr;
+    size_t Size = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <cstdint>
+#include <string>
+
+// Byte counters per subsystem. GPU resources are counted where they are created and unloaded,
+// CPU data either the same way or through a TrackedBytes member that follows its owner.
+namespace MemoryStats
+{
+    enum class Category : uint8_t
+    {
+        TerrainTileData,    // heights, occlusion and splat copies kept on the CPU
+        TerrainGeometry,    // tile vertex buffers and the shared index buffer
+        TerrainTextures,    // splat, index, weight, normal, albedo and palette textures
+        Vegetation,         // grass instance buffers
+        RaylibHeap,         // MemAlloc users, mostly short lived mesh build buffers
+        Thumbnails,
+        TypeValues,         // heap allocated type system nodes
+        Count
+    };
+
+    struct Counter
+    {
+        int64_t Bytes = 0;
+        int64_t PeakBytes = 0;
+        int64_t Allocations = 0;
+    };
+
+    void Add(Category category, int64_t bytes);
+    void Remove(Category category, int64_t bytes);
+
+    Counter Get(Category category);
+    const char* GetName(Category category);
+    bool IsGpu(Category category);
+
+    // totals over all categories on one side of the bus
+    int64_t GetTotal(bool gpu);
+
+    // size of a texture and its mip chain, 0 for unloaded textures
+    int64_t GetTextureBytes(const Texture& texture);
+    void AddTexture(Category category, const Texture& texture);
+    void RemoveTexture(Category category, const Texture& texture);
+
+    std::string FormatBytes(int64_t bytes);
+
+    // counts a changing amount of memory owned by an object, copies count their own copy and moves take it over
+    class TrackedBytes
+    {
+    public:
+        TrackedBytes(Category category) : TrackedCategory(category) {}
+        TrackedBytes(const TrackedBytes& other) : TrackedCategory(other.TrackedCategory) { Set(other.Bytes); }
+        TrackedBytes(TrackedBytes&& other) noexcept : TrackedCategory(other.TrackedCategory), Bytes(other.Bytes) { other.Bytes = 0; }
+        ~TrackedBytes() { Set(0); }
+
+        TrackedBytes& operator = (const TrackedBytes& other)
+        {
+            if (this != &other)
+                Set(other.Bytes);
+            return *this;
+        }
+
+        TrackedBytes& operator = (TrackedBytes&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Set(0);
+                Bytes = other.Bytes;
+                other.Bytes = 0;
+            }
+            return *this;
+        }
+
+        void Set(int64_t bytes);
+        int64_t Get() const { return Bytes; }
+
+    private:
+        Category TrackedCategory;
+        int64_t Bytes = 0;
+    };
+}
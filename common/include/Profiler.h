@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Frame profiler, CPU scopes from any thread and GL_TIME_ELAPSED scopes on the render thread.
+// Scope names must be string literals or otherwise outlive the profiler, only the pointer is kept.
+namespace Profiler
+{
+    // all times are milliseconds since the profiler started
+    struct ScopeSample
+    {
+        const char* Name = nullptr;
+        uint32_t ThreadID = 0;
+        uint16_t Depth = 0;
+        double Start = 0;
+        double Duration = 0;
+    };
+
+    struct GpuSample
+    {
+        const char* Name = nullptr;
+        uint16_t Depth = 0;
+        // inclusive of nested scopes
+        double Duration = 0;
+    };
+
+    struct FrameRecord
+    {
+        uint64_t FrameIndex = 0;
+        double Start = 0;
+        double Duration = 0;
+
+        // sum of the outermost GPU scopes, negative until the queries for the frame come back
+        double GpuDuration = -1;
+
+        // MemoryStats totals at the end of the frame
+        int64_t CpuMemory = 0;
+        int64_t GpuMemory = 0;
+
+        std::vector<ScopeSample> Scopes;
+        std::vector<GpuSample> GpuScopes;
+    };
+
+    // takes effect at the next BeginFrame, so a frame is always recorded completely or not at all
+    void SetEnabled(bool enabled);
+    bool IsEnabled();
+
+    // true while the current frame is being recorded, the only cost a scope has when it is not
+    bool IsRecording();
+
+    void SetHistorySize(size_t frames);
+
+    // render thread, once per frame
+    void BeginFrame();
+    void EndFrame();
+
+    void BeginScope(const char* name);
+    void EndScope();
+
+    // render thread only. GL allows one time elapsed query at a time, so a nested scope pauses the query of its parent
+    void BeginGpuScope(const char* name);
+    void EndGpuScope();
+
+    // called by Scope, a scope that entered must leave on the same thread
+    double EnterScope();
+    void LeaveScope(const char* name, double start);
+
+    uint32_t GetThreadID();
+    void SetThreadName(const char* name);
+    double GetTime();
+
+    // completed frames, oldest first, render thread only
+    const std::deque<FrameRecord>& GetHistory();
+
+    // one row per frame and per scope in the history
+    bool WriteCSV(const std::string& fileName);
+
+    // keeps every recorded frame from start to stop, independent of the history size
+    void StartTrace();
+    void StopTrace();
+    bool IsTracing();
+
+    // Chrome trace event JSON of the last trace, loads in Perfetto or chrome://tracing
+    bool WriteTrace(const std::string& fileName);
+
+    // drops the pending queries, call before the GL context goes away
+    void Shutdown();
+
+    class Scope
+    {
+    public:
+        Scope(const char* name) : Name(name)
+        {
+            if (IsRecording())
+                Start = EnterScope();
+        }
+
+        ~Scope()
+        {
+            if (Start >= 0)
+                LeaveScope(Name, Start);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator = (const Scope&) = delete;
+
+    private:
+        const char* Name = nullptr;
+        double Start = -1;
+    };
+
+    class GpuScope
+    {
+    public:
+        GpuScope(const char* name) { BeginGpuScope(name); }
+        ~GpuScope() { EndGpuScope(); }
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator = (const GpuScope&) = delete;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) Profiler::GpuScope PROFILE_CONCAT(profileGpuScope, __LINE__)(name)
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Order 0 byte entropy coder (range asymmetric numeral systems). A block holds its own size and symbol
+// frequencies, data that does not shrink is stored as it is.
+namespace Rans
+{
+    // appends one block to out
+    void Encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+    // the block has to be exactly size bytes, false when it is damaged or would decode to more than maxSize
+    bool Decode(const uint8_t* data, size_t size, size_t maxSize, std::vector<uint8_t>& out);
+}
@@ -0,0 +1,110 @@
+#include "Base64.h"
+
+#include <cstdint>
+
+namespace Base64
+{
+    static constexpr char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    struct DecodeTable
+    {
+        uint8_t Values[256];
+
+        constexpr DecodeTable() : Values()
+        {
+            for (int i = 0; i < 256; i++)
+                Values[i] = 0xFF;
+
+            for (int i = 0; i < 64; i++)
+                Values[uint8_t(Alphabet[i])] = uint8_t(i);
+        }
+    };
+
+    static constexpr DecodeTable Decoding;
+
+    std::string Encode(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+        std::string text;
+        text.resize(((size + 2) / 3) * 4);
+
+        char* out = text.data();
+        size_t i = 0;
+        for (; i + 2 < size; i += 3)
+        {
+            uint32_t block = (uint32_t(bytes[i]) << 16) | (uint32_t(bytes[i + 1]) << 8) | bytes[i + 2];
+            *out++ = Alphabet[(block >> 18) & 0x3F];
+            *out++ = Alphabet[(block >> 12) & 0x3F];
+            *out++ = Alphabet[(block >> 6) & 0x3F];
+            *out++ = Alphabet[block & 0x3F];
+        }
+
+        if (i < size)
+        {
+            uint32_t block = uint32_t(bytes[i]) << 16;
+            if (i + 1 < size)
+                block |= uint32_t(bytes[i + 1]) << 8;
+
+            *out++ = Alphabet[(block >> 18) & 0x3F];
+            *out++ = Alphabet[(block >> 12) & 0x3F];
+            *out++ = i + 1 < size ? Alphabet[(block >> 6) & 0x3F] : '=';
+            *out++ = '=';
+        }
+
+        return text;
+    }
+
+    size_t GetDecodedSize(std::string_view text)
+    {
+        if (text.size() % 4 != 0)
+            return 0;
+
+        size_t size = (text.size() / 4) * 3;
+        if (!text.empty() && text[text.size() - 1] == '=')
+            size--;
+        if (text.size() > 1 && text[text.size() - 2] == '=')
+            size--;
+
+        return size;
+    }
+
+    bool Decode(std::string_view text, void* data, size_t size)
+    {
+        if (size != GetDecodedSize(text))
+            return false;
+
+        uint8_t* out = static_cast<uint8_t*>(data);
+        size_t written = 0;
+
+        for (size_t i = 0; i < text.size(); i += 4)
+        {
+            uint32_t block = 0;
+            bool padding = false;
+            for (size_t c = 0; c < 4; c++)
+            {
+                uint8_t value = Decoding.Values[uint8_t(text[i + c])];
+
+                // padding is only valid at the end of the last block
+                if (value == 0xFF)
+                {
+                    if (text[i + c] != '=' || i + 4 != text.size() || c < 2)
+                        return false;
+                    padding = true;
+                    value = 0;
+                }
+                else if (padding)
+                {
+                    return false;
+                }
+
+                block = (block << 6) | value;
+            }
+
+            for (int b = 2; b >= 0 && written < size; b--)
+                out[written++] = uint8_t(block >> (b * 8));
+        }
+
+        return true;
+    }
+}
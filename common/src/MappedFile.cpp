@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+
+static size_t GetPageSize()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return size_t(info.dwPageSize);
+}
+
+bool MappedFile::Open(const std::string& fileName)
+{
+    Close();
+
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size = { 0 };
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // the view keeps the mapping and the file open, the handles are not needed after it is made
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    Data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!Data)
+        return false;
+
+    Size = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (Data)
+        UnmapViewOfFile(Data);
+
+    Data = nullptr;
+    Size = 0;
+}
+
+#else
+
+static size_t GetPageSize()
+{
+    return size_t(sysconf(_SC_PAGESIZE));
+}
+
+bool MappedFile::Open(const std::string& fileName)
+{
+    Close();
+
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size <= 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // the mapping holds its own reference to the file
+    void* data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+        return false;
+
+    madvise(data, size_t(info.st_size), MADV_SEQUENTIAL);
+
+    Data = static_cast<const uint8_t*>(data);
+    Size = size_t(info.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (Data)
+        munmap(const_cast<uint8_t*>(Data), Size);
+
+    Data = nullptr;
+    Size = 0;
+}
+
+#endif
+
+bool MappedFile::IsNullTerminated() const
+{
+    return Data && Size % GetPageSize() != 0;
+}
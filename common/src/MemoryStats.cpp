@@ -0,0 +1,156 @@
+#include "MemoryStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace MemoryStats
+{
+    struct AtomicCounter
+    {
+        std::atomic<int64_t> Bytes{ 0 };
+        std::atomic<int64_t> PeakBytes{ 0 };
+        std::atomic<int64_t> Allocations{ 0 };
+    };
+
+    static AtomicCounter Counters[size_t(Category::Count)];
+
+    static void Adjust(Category category, int64_t bytes, int64_t allocations)
+    {
+        AtomicCounter& counter = Counters[size_t(category)];
+
+        int64_t total = counter.Bytes.fetch_add(bytes) + bytes;
+        counter.Allocations.fetch_add(allocations);
+
+        int64_t peak = counter.PeakBytes.load();
+        while (total > peak && !counter.PeakBytes.compare_exchange_weak(peak, total))
+        {
+        }
+    }
+
+    void Add(Category category, int64_t bytes)
+    {
+        Adjust(category, bytes, 1);
+    }
+
+    void Remove(Category category, int64_t bytes)
+    {
+        Adjust(category, -bytes, -1);
+    }
+
+    Counter Get(Category category)
+    {
+        const AtomicCounter& counter = Counters[size_t(category)];
+
+        Counter result;
+        result.Bytes = counter.Bytes.load();
+        result.PeakBytes = counter.PeakBytes.load();
+        result.Allocations = counter.Allocations.load();
+        return result;
+    }
+
+    const char* GetName(Category category)
+    {
+        switch (category)
+        {
+        case Category::TerrainTileData:     return "Terrain Tile Data";
+        case Category::TerrainGeometry:     return "Terrain Geometry";
+        case Category::TerrainTextures:     return "Terrain Textures";
+        case Category::Vegetation:          return "Vegetation";
+        case Category::RaylibHeap:          return "raylib MemAlloc";
+        case Category::Thumbnails:          return "Thumbnails";
+        case Category::TypeValues:          return "Type Values";
+        default:                            return "Unknown";
+        }
+    }
+
+    bool IsGpu(Category category)
+    {
+        switch (category)
+        {
+        case Category::TerrainGeometry:
+        case Category::TerrainTextures:
+        case Category::Vegetation:
+        case Category::Thumbnails:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    int64_t GetTotal(bool gpu)
+    {
+        int64_t total = 0;
+        for (size_t i = 0; i < size_t(Category::Count); i++)
+        {
+            if (IsGpu(Category(i)) == gpu)
+                total += Counters[i].Bytes.load();
+        }
+        return total;
+    }
+
+    int64_t GetTextureBytes(const Texture& texture)
+    {
+        // the editor marks missing textures with -1
+        if (texture.id == 0 || texture.id == (unsigned int)-1)
+            return 0;
+
+        int64_t bytes = 0;
+        int width = texture.width;
+        int height = texture.height;
+        for (int mip = 0; mip < std::max(texture.mipmaps, 1); mip++)
+        {
+            bytes += GetPixelDataSize(width, height, texture.format);
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+
+        return bytes;
+    }
+
+    void AddTexture(Category category, const Texture& texture)
+    {
+        int64_t bytes = GetTextureBytes(texture);
+        if (bytes > 0)
+            Add(category, bytes);
+    }
+
+    void RemoveTexture(Category category, const Texture& texture)
+    {
+        int64_t bytes = GetTextureBytes(texture);
+        if (bytes > 0)
+            Remove(category, bytes);
+    }
+
+    std::string FormatBytes(int64_t bytes)
+    {
+        char buffer[32] = { 0 };
+
+        double value = double(bytes);
+        if (bytes >= 1024 * 1024 || bytes <= -1024 * 1024)
+            snprintf(buffer, sizeof(buffer), "%.2f MB", value / (1024.0 * 1024.0));
+        else if (bytes >= 1024 || bytes <= -1024)
+            snprintf(buffer, sizeof(buffer), "%.1f KB", value / 1024.0);
+        else
+            snprintf(buffer, sizeof(buffer), "%lld B", (long long)bytes);
+
+        return buffer;
+    }
+
+    void TrackedBytes::Set(int64_t bytes)
+    {
+        if (bytes == Bytes)
+            return;
+
+        // the whole block counts as one allocation while it is non empty
+        int64_t allocations = 0;
+        if (Bytes == 0)
+            allocations = 1;
+        else if (bytes == 0)
+            allocations = -1;
+
+        Adjust(TrackedCategory, bytes - Bytes, allocations);
+        Bytes = bytes;
+    }
+}
@@ -0,0 +1,506 @@
+#include "Profiler.h"
+#include "MemoryStats.h"
+
+#include "rlgl.h"
+#include "external/glad.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+namespace Profiler
+{
+    struct OpenScope
+    {
+        const char* Name = nullptr;
+        double Start = 0;
+    };
+
+    struct GpuRecord
+    {
+        const char* Name = nullptr;
+        uint16_t Depth = 0;
+        int Parent = -1;
+
+        // one query per stretch of time the scope was the innermost one
+        std::vector<GLuint> Queries;
+    };
+
+    struct PendingGpuFrame
+    {
+        uint64_t FrameIndex = 0;
+        GLuint LastQuery = 0;
+        std::vector<GpuRecord> Records;
+    };
+
+    // frames the driver may lag behind before results are waited on
+    static constexpr size_t MaxPendingFrames = 4;
+
+    static const auto Epoch = std::chrono::steady_clock::now();
+
+    static std::atomic<bool> EnableRequested{ false };
+    static std::atomic<bool> Recording{ false };
+    static std::atomic<bool> Tracing{ false };
+    static std::atomic<uint32_t> NextThreadID{ 0 };
+
+    static std::mutex FrameLock;
+    static FrameRecord CurrentFrame;
+    static uint64_t NextFrameIndex = 0;
+
+    static size_t HistorySize = 300;
+    static std::deque<FrameRecord> History;
+
+    static thread_local std::vector<OpenScope> ScopeStack;
+    static thread_local uint16_t ScopeDepth = 0;
+
+    // trace frames only keep their timing, the scopes go in one flat list
+    static std::vector<FrameRecord> TraceFrames;
+    static std::vector<ScopeSample> TraceScopes;
+
+    static std::mutex ThreadNameLock;
+    static std::map<uint32_t, std::string> ThreadNames;
+
+    static bool GpuRecording = false;
+    static std::vector<GpuRecord> CurrentGpu;
+    static std::vector<int> GpuStack;
+    static GLuint LastGpuQuery = 0;
+    static std::deque<PendingGpuFrame> PendingGpu;
+    static std::vector<GLuint> FreeQueries;
+
+    static GLuint StartQuery()
+    {
+        GLuint query = 0;
+        if (FreeQueries.empty())
+        {
+            glGenQueries(1, &query);
+        }
+        else
+        {
+            query = FreeQueries.back();
+            FreeQueries.pop_back();
+        }
+
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        LastGpuQuery = query;
+        return query;
+    }
+
+    static FrameRecord* FindFrame(uint64_t frameIndex)
+    {
+        for (auto itr = History.rbegin(); itr != History.rend(); itr++)
+        {
+            if (itr->FrameIndex == frameIndex)
+                return &(*itr);
+        }
+        return nullptr;
+    }
+
+    static void ResolveGpuFrames()
+    {
+        while (!PendingGpu.empty())
+        {
+            PendingGpuFrame& pending = PendingGpu.front();
+
+            // queries finish in order, once the last one is back the whole frame is
+            if (PendingGpu.size() <= MaxPendingFrames)
+            {
+                GLint available = 0;
+                glGetQueryObjectiv(pending.LastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    break;
+            }
+
+            std::vector<double> totals(pending.Records.size(), 0.0);
+            for (size_t i = 0; i < pending.Records.size(); i++)
+            {
+                for (GLuint query : pending.Records[i].Queries)
+                {
+                    GLuint64 nanoseconds = 0;
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+                    totals[i] += nanoseconds / 1000000.0;
+                    FreeQueries.push_back(query);
+                }
+            }
+
+            // children always come after their parent, walking backwards rolls them up into it
+            for (size_t i = pending.Records.size(); i > 0; i--)
+            {
+                int parent = pending.Records[i - 1].Parent;
+                if (parent >= 0)
+                    totals[parent] += totals[i - 1];
+            }
+
+            if (!TraceFrames.empty() && !pending.Records.empty())
+            {
+                double gpuDuration = 0;
+                for (size_t i = 0; i < pending.Records.size(); i++)
+                {
+                    if (pending.Records[i].Depth == 0)
+                        gpuDuration += totals[i];
+                }
+
+                for (auto itr = TraceFrames.rbegin(); itr != TraceFrames.rend(); itr++)
+                {
+                    if (itr->FrameIndex == pending.FrameIndex)
+                    {
+                        itr->GpuDuration = gpuDuration;
+                        break;
+                    }
+                }
+            }
+
+            FrameRecord* frame = FindFrame(pending.FrameIndex);
+            if (frame && !pending.Records.empty())
+            {
+                frame->GpuDuration = 0;
+                frame->GpuScopes.resize(pending.Records.size());
+                for (size_t i = 0; i < pending.Records.size(); i++)
+                {
+                    frame->GpuScopes[i].Name = pending.Records[i].Name;
+                    frame->GpuScopes[i].Depth = pending.Records[i].Depth;
+                    frame->GpuScopes[i].Duration = totals[i];
+
+                    if (pending.Records[i].Depth == 0)
+                        frame->GpuDuration += totals[i];
+                }
+            }
+
+            PendingGpu.pop_front();
+        }
+    }
+
+    void SetEnabled(bool enabled)
+    {
+        EnableRequested = enabled;
+    }
+
+    bool IsEnabled()
+    {
+        return EnableRequested;
+    }
+
+    bool IsRecording()
+    {
+        return Recording.load(std::memory_order_relaxed);
+    }
+
+    void SetHistorySize(size_t frames)
+    {
+        HistorySize = frames;
+        while (History.size() > HistorySize)
+            History.pop_front();
+    }
+
+    void BeginFrame()
+    {
+        ResolveGpuFrames();
+
+        std::lock_guard<std::mutex> lock(FrameLock);
+        Recording = EnableRequested || Tracing;
+        GpuRecording = Recording;
+
+        CurrentFrame.FrameIndex = NextFrameIndex++;
+        CurrentFrame.Start = GetTime();
+        CurrentFrame.Duration = 0;
+        CurrentFrame.GpuDuration = -1;
+        CurrentFrame.Scopes.clear();
+        CurrentFrame.GpuScopes.clear();
+    }
+
+    void EndFrame()
+    {
+        while (!GpuStack.empty())
+            EndGpuScope();
+
+        if (!CurrentGpu.empty())
+        {
+            PendingGpu.emplace_back(PendingGpuFrame{ CurrentFrame.FrameIndex, LastGpuQuery, std::move(CurrentGpu) });
+            CurrentGpu.clear();
+        }
+        LastGpuQuery = 0;
+        GpuRecording = false;
+
+        {
+            std::lock_guard<std::mutex> lock(FrameLock);
+            if (Recording)
+            {
+                CurrentFrame.Duration = GetTime() - CurrentFrame.Start;
+                CurrentFrame.CpuMemory = MemoryStats::GetTotal(false);
+                CurrentFrame.GpuMemory = MemoryStats::GetTotal(true);
+
+                if (Tracing)
+                {
+                    TraceScopes.insert(TraceScopes.end(), CurrentFrame.Scopes.begin(), CurrentFrame.Scopes.end());
+
+                    FrameRecord timing;
+                    timing.FrameIndex = CurrentFrame.FrameIndex;
+                    timing.Start = CurrentFrame.Start;
+                    timing.Duration = CurrentFrame.Duration;
+                    timing.CpuMemory = CurrentFrame.CpuMemory;
+                    timing.GpuMemory = CurrentFrame.GpuMemory;
+                    TraceFrames.push_back(timing);
+                }
+
+                History.emplace_back(std::move(CurrentFrame));
+                CurrentFrame = FrameRecord();
+
+                while (History.size() > HistorySize)
+                    History.pop_front();
+            }
+            Recording = false;
+        }
+
+        ResolveGpuFrames();
+    }
+
+    void BeginScope(const char* name)
+    {
+        // a negative start marks a scope opened while not recording, so begin and end always pair up
+        ScopeStack.push_back(OpenScope{ name, IsRecording() ? EnterScope() : -1.0 });
+    }
+
+    void EndScope()
+    {
+        if (ScopeStack.empty())
+            return;
+
+        OpenScope scope = ScopeStack.back();
+        ScopeStack.pop_back();
+
+        if (scope.Start >= 0)
+            LeaveScope(scope.Name, scope.Start);
+    }
+
+    double EnterScope()
+    {
+        ScopeDepth++;
+        return GetTime();
+    }
+
+    void LeaveScope(const char* name, double start)
+    {
+        double end = GetTime();
+        ScopeDepth--;
+
+        // recording can stop while a worker scope is open, that scope is dropped
+        if (!IsRecording())
+            return;
+
+        ScopeSample sample;
+        sample.Name = name;
+        sample.ThreadID = GetThreadID();
+        sample.Depth = ScopeDepth;
+        sample.Start = start;
+        sample.Duration = end - start;
+
+        std::lock_guard<std::mutex> lock(FrameLock);
+        if (Recording)
+            CurrentFrame.Scopes.push_back(sample);
+    }
+
+    void BeginGpuScope(const char* name)
+    {
+        if (!GpuRecording)
+        {
+            GpuStack.push_back(-1);
+            return;
+        }
+
+        // anything raylib has batched so far belongs to the enclosing scope
+        rlDrawRenderBatchActive();
+
+        int parent = GpuStack.empty() ? -1 : GpuStack.back();
+        if (parent >= 0)
+            glEndQuery(GL_TIME_ELAPSED);
+
+        GpuRecord record;
+        record.Name = name;
+        record.Depth = uint16_t(GpuStack.size());
+        record.Parent = parent;
+        record.Queries.push_back(StartQuery());
+
+        GpuStack.push_back(int(CurrentGpu.size()));
+        CurrentGpu.emplace_back(std::move(record));
+    }
+
+    void EndGpuScope()
+    {
+        if (GpuStack.empty())
+            return;
+
+        int index = GpuStack.back();
+        GpuStack.pop_back();
+        if (index < 0)
+            return;
+
+        rlDrawRenderBatchActive();
+        glEndQuery(GL_TIME_ELAPSED);
+
+        int parent = CurrentGpu[index].Parent;
+        if (parent >= 0)
+            CurrentGpu[parent].Queries.push_back(StartQuery());
+    }
+
+    uint32_t GetThreadID()
+    {
+        static thread_local uint32_t threadID = NextThreadID++;
+        return threadID;
+    }
+
+    void SetThreadName(const char* name)
+    {
+        std::lock_guard<std::mutex> lock(ThreadNameLock);
+        ThreadNames[GetThreadID()] = name;
+    }
+
+    double GetTime()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Epoch).count();
+    }
+
+    const std::deque<FrameRecord>& GetHistory()
+    {
+        return History;
+    }
+
+    bool WriteCSV(const std::string& fileName)
+    {
+        FILE* fp = fopen(fileName.c_str(), "wt");
+        if (!fp)
+            return false;
+
+        fprintf(fp, "frame,frame_ms,gpu_ms,kind,scope,thread,depth,start_ms,duration_ms\n");
+
+        for (const auto& frame : History)
+        {
+            unsigned long long index = (unsigned long long)frame.FrameIndex;
+
+            fprintf(fp, "%llu,%.4f,%.4f,frame,,,,0.0000,%.4f\n", index, frame.Duration, frame.GpuDuration, frame.Duration);
+
+            for (const auto& scope : frame.Scopes)
+            {
+                fprintf(fp, "%llu,%.4f,%.4f,cpu,\"%s\",%u,%u,%.4f,%.4f\n",
+                    index, frame.Duration, frame.GpuDuration,
+                    scope.Name, scope.ThreadID, unsigned(scope.Depth), scope.Start - frame.Start, scope.Duration);
+            }
+
+            // the GPU runs on its own clock, so there is no start time to give
+            for (const auto& scope : frame.GpuScopes)
+            {
+                fprintf(fp, "%llu,%.4f,%.4f,gpu,\"%s\",,%u,,%.4f\n",
+                    index, frame.Duration, frame.GpuDuration,
+                    scope.Name, unsigned(scope.Depth), scope.Duration);
+            }
+        }
+
+        fclose(fp);
+        return true;
+    }
+
+    void StartTrace()
+    {
+        std::lock_guard<std::mutex> lock(FrameLock);
+        TraceFrames.clear();
+        TraceScopes.clear();
+        Tracing = true;
+    }
+
+    void StopTrace()
+    {
+        Tracing = false;
+    }
+
+    bool IsTracing()
+    {
+        return Tracing;
+    }
+
+    static void WriteJsonString(FILE* fp, const char* text)
+    {
+        fputc('"', fp);
+        for (const char* c = text; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                fputc('\\', fp);
+
+            if ((unsigned char)(*c) >= 0x20)
+                fputc(*c, fp);
+        }
+        fputc('"', fp);
+    }
+
+    bool WriteTrace(const std::string& fileName)
+    {
+        FILE* fp = fopen(fileName.c_str(), "wt");
+        if (!fp)
+            return false;
+
+        // trace event timestamps are in microseconds
+        fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Application\"}}");
+
+        {
+            std::lock_guard<std::mutex> lock(ThreadNameLock);
+
+            uint32_t threadCount = NextThreadID;
+            for (uint32_t thread = 0; thread < threadCount; thread++)
+            {
+                auto itr = ThreadNames.find(thread);
+                std::string name = itr != ThreadNames.end() ? itr->second : "Worker " + std::to_string(thread);
+
+                fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread);
+                WriteJsonString(fp, name.c_str());
+                fprintf(fp, "}}");
+            }
+        }
+
+        for (const auto& scope : TraceScopes)
+        {
+            fprintf(fp, ",\n{\"name\":");
+            WriteJsonString(fp, scope.Name);
+            fprintf(fp, ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                scope.ThreadID, scope.Start * 1000.0, scope.Duration * 1000.0);
+        }
+
+        // GPU queries only give durations, so the GPU shows as per frame counters rather than spans
+        for (const auto& frame : TraceFrames)
+        {
+            fprintf(fp, ",\n{\"name\":\"Frame ms\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"cpu\":%.4f", frame.Start * 1000.0, frame.Duration);
+            if (frame.GpuDuration >= 0)
+                fprintf(fp, ",\"gpu\":%.4f", frame.GpuDuration);
+            fprintf(fp, "}}");
+
+            fprintf(fp, ",\n{\"name\":\"Memory MB\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"cpu\":%.3f,\"gpu\":%.3f}}",
+                frame.Start * 1000.0, frame.CpuMemory / (1024.0 * 1024.0), frame.GpuMemory / (1024.0 * 1024.0));
+        }
+
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+        return true;
+    }
+
+    void Shutdown()
+    {
+        while (!GpuStack.empty())
+            EndGpuScope();
+
+        for (auto& record : CurrentGpu)
+            FreeQueries.insert(FreeQueries.end(), record.Queries.begin(), record.Queries.end());
+        CurrentGpu.clear();
+
+        for (auto& pending : PendingGpu)
+        {
+            for (auto& record : pending.Records)
+                FreeQueries.insert(FreeQueries.end(), record.Queries.begin(), record.Queries.end());
+        }
+        PendingGpu.clear();
+
+        if (!FreeQueries.empty())
+            glDeleteQueries(GLsizei(FreeQueries.size()), FreeQueries.data());
+        FreeQueries.clear();
+
+        History.clear();
+    }
+}
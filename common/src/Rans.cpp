@@ -0,0 +1,263 @@
+#include "Rans.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Rans
+{
+    enum class BlockMode : uint8_t
+    {
+        Stored,
+        Coded,
+    };
+
+    static constexpr uint32_t ProbBits = 12;
+    static constexpr uint32_t ProbScale = 1u << ProbBits;
+
+    // the state is kept in [StateLow, StateLow << 8) and moves a byte at a time
+    static constexpr uint32_t StateLow = 1u << 23;
+
+    template<class T>
+    static void AppendRaw(std::vector<uint8_t>& out, T value)
+    {
+        uint8_t bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<class T>
+    static bool ReadRaw(const uint8_t*& data, const uint8_t* end, T& value)
+    {
+        if (size_t(end - data) < sizeof(T))
+            return false;
+
+        memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return true;
+    }
+
+    // scales the counts to sum to ProbScale, every symbol that occurs keeps at least 1
+    static void NormalizeFrequencies(const uint64_t* counts, size_t total, uint32_t* frequencies)
+    {
+        uint32_t sum = 0;
+        for (int s = 0; s < 256; s++)
+        {
+            frequencies[s] = 0;
+            if (counts[s] == 0)
+                continue;
+
+            frequencies[s] = std::max(uint32_t(counts[s] * ProbScale / total), 1u);
+            sum += frequencies[s];
+        }
+
+        // the rounding error goes to or comes from the most common symbols
+        while (sum != ProbScale)
+        {
+            int largest = int(std::max_element(frequencies, frequencies + 256) - frequencies);
+            if (sum < ProbScale)
+            {
+                frequencies[largest] += ProbScale - sum;
+                sum = ProbScale;
+            }
+            else
+            {
+                uint32_t take = std::min(sum - ProbScale, frequencies[largest] / 2);
+                frequencies[largest] -= take;
+                sum -= take;
+            }
+        }
+    }
+
+    static bool Renormalize(uint32_t& state, const uint8_t*& data, const uint8_t* end)
+    {
+        while (state < StateLow)
+        {
+            if (data == end)
+                return false;
+
+            state = (state << 8) | *data++;
+        }
+        return true;
+    }
+
+    static void EncodeStored(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        out.push_back(uint8_t(BlockMode::Stored));
+        AppendRaw(out, uint32_t(size));
+        out.insert(out.end(), data, data + size);
+    }
+
+    void Encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        size_t blockStart = out.size();
+
+        // the tables cost more than coding saves on tiny inputs
+        if (size < 64)
+        {
+            EncodeStored(data, size, out);
+            return;
+        }
+
+        uint64_t counts[256] = { 0 };
+        for (size_t i = 0; i < size; i++)
+            counts[data[i]]++;
+
+        uint32_t frequencies[256];
+        NormalizeFrequencies(counts, size, frequencies);
+
+        uint32_t starts[256];
+        uint32_t start = 0;
+        uint16_t symbolCount = 0;
+        for (int s = 0; s < 256; s++)
+        {
+            starts[s] = start;
+            start += frequencies[s];
+            if (frequencies[s])
+                symbolCount++;
+        }
+
+        out.push_back(uint8_t(BlockMode::Coded));
+        AppendRaw(out, uint32_t(size));
+        AppendRaw(out, symbolCount);
+        for (int s = 0; s < 256; s++)
+        {
+            if (!frequencies[s])
+                continue;
+
+            out.push_back(uint8_t(s));
+            AppendRaw(out, uint16_t(frequencies[s]));
+        }
+
+        // coded back to front so the decoder can run front to back, the bytes are reversed at the end.
+        // even and odd symbols have their own state so the decoder has two independent chains to work on
+        std::vector<uint8_t> stream;
+        stream.reserve(size / 2 + 16);
+
+        uint32_t states[2] = { StateLow, StateLow };
+        for (size_t i = size; i > 0; i--)
+        {
+            uint8_t symbol = data[i - 1];
+            uint32_t frequency = frequencies[symbol];
+            uint32_t& state = states[(i - 1) & 1];
+
+            uint32_t stateMax = ((StateLow >> ProbBits) << 8) * frequency;
+            while (state >= stateMax)
+            {
+                stream.push_back(uint8_t(state & 0xFF));
+                state >>= 8;
+            }
+
+            state = ((state / frequency) << ProbBits) + (state % frequency) + starts[symbol];
+        }
+
+        for (int s = 1; s >= 0; s--)
+        {
+            stream.push_back(uint8_t(states[s] >> 24));
+            stream.push_back(uint8_t(states[s] >> 16));
+            stream.push_back(uint8_t(states[s] >> 8));
+            stream.push_back(uint8_t(states[s]));
+        }
+        std::reverse(stream.begin(), stream.end());
+
+        if (out.size() - blockStart + stream.size() >= size + 1 + sizeof(uint32_t))
+        {
+            out.resize(blockStart);
+            EncodeStored(data, size, out);
+            return;
+        }
+
+        out.insert(out.end(), stream.begin(), stream.end());
+    }
+
+    bool Decode(const uint8_t* data, size_t size, size_t maxSize, std::vector<uint8_t>& out)
+    {
+        const uint8_t* end = data + size;
+
+        uint8_t mode = 0;
+        uint32_t rawSize = 0;
+        if (!ReadRaw(data, end, mode) || !ReadRaw(data, end, rawSize) || rawSize > maxSize)
+            return false;
+
+        if (mode == uint8_t(BlockMode::Stored))
+        {
+            if (size_t(end - data) != rawSize)
+                return false;
+
+            out.assign(data, end);
+            return true;
+        }
+
+        if (mode != uint8_t(BlockMode::Coded))
+            return false;
+
+        uint16_t symbolCount = 0;
+        if (!ReadRaw(data, end, symbolCount) || symbolCount == 0 || symbolCount > 256)
+            return false;
+
+        // everything the decode step needs from a slot in one lookup
+        struct Slot
+        {
+            uint8_t Symbol;
+            uint16_t Frequency;
+            uint16_t Offset;
+        };
+        Slot slots[ProbScale];
+        bool seen[256] = { false };
+
+        uint32_t start = 0;
+        for (uint16_t i = 0; i < symbolCount; i++)
+        {
+            uint8_t symbol = 0;
+            uint16_t frequency = 0;
+            if (!ReadRaw(data, end, symbol) || !ReadRaw(data, end, frequency))
+                return false;
+
+            if (frequency == 0 || seen[symbol] || start + frequency > ProbScale)
+                return false;
+
+            seen[symbol] = true;
+            for (uint32_t f = 0; f < frequency; f++)
+                slots[start + f] = { symbol, frequency, uint16_t(f) };
+            start += frequency;
+        }
+
+        if (start != ProbScale)
+            return false;
+
+        uint32_t state0 = 0;
+        uint32_t state1 = 0;
+        if (!ReadRaw(data, end, state0) || !ReadRaw(data, end, state1) || state0 < StateLow || state1 < StateLow)
+            return false;
+
+        out.resize(rawSize);
+        uint8_t* output = out.data();
+
+        // both chains step together, each renormalizes from the shared stream in the order they were coded
+        uint32_t i = 0;
+        for (; i + 1 < rawSize; i += 2)
+        {
+            const Slot& slot0 = slots[state0 & (ProbScale - 1)];
+            const Slot& slot1 = slots[state1 & (ProbScale - 1)];
+            output[i] = slot0.Symbol;
+            output[i + 1] = slot1.Symbol;
+
+            state0 = slot0.Frequency * (state0 >> ProbBits) + slot0.Offset;
+            state1 = slot1.Frequency * (state1 >> ProbBits) + slot1.Offset;
+
+            if (!Renormalize(state0, data, end) || !Renormalize(state1, data, end))
+                return false;
+        }
+
+        if (i < rawSize)
+        {
+            const Slot& slot0 = slots[state0 & (ProbScale - 1)];
+            output[i] = slot0.Symbol;
+
+            state0 = slot0.Frequency * (state0 >> ProbBits) + slot0.Offset;
+            if (!Renormalize(state0, data, end))
+                return false;
+        }
+
+        return data == end;
+    }
+}
@@ -4,6 +4,13 @@
 
 #include "TerrainTile.h"
 #include "TerrainRender.h"
+#include "TerrainNormalBaker.h"
+#include "TerrainGrass.h"
+#include "TerrainFoliage.h"
+#include "TerrainPalette.h"
+#include "TerrainAlbedoBaker.h"
+#include "TerrainCulling.h"
+#include "TerrainDrawOrder.h"
 #include "AssetDocument.h"
 
 #include "types/terrain.h"
@@ -30,29 +37,60 @@ public:
 
 	TerrainTile& GetTile(int x, int y);
 	bool HasTile(int x, int y) const;
+	const TerrainTile* FindTile(int64_t x, int64_t y) const;
 
 	TerrainPosition SelectedTileLoc;
 
 	TerrainPosition TerrainBounds = { 0,0 };
 
+	TerrainNormalBaker NormalBaker;
+	TerrainGrassSystem Grass;
+	TerrainFoliageSystem Foliage;
+	TerrainMaterialPalette Palette;
+	TerrainAlbedoBaker AlbedoBaker;
+
+	// tiles per LOD step, lighting comes from the baked normal maps so this can stay tight
+	float LODTileDistance = 1.0f;
+	// tiles further than this many tile sizes draw their composited albedo
+	float FarAlbedoTileDistance = 3.0f;
+
+	// converts the tile splat to palette indices, a no-op until the palette has materials
+	void UpdateIndexedSplat(TerrainTile& tile);
+
+	size_t GetOccludedTileCount() const { return OcclusionCuller.GetOccludedCount(); }
+
 protected:
 	void OnAssetCreate() override;
 	void OnAssetOpen() override;
 	void OnAssetDirty() override;
 
 	void SetupDocument();
+	void SetupFoliage();
 
 	void HandleMaterialListChangedEvent(const ValueChangedEvent& event);
 
 	void RebuildMaterialIndex(int index);
+	void RebuildPalette();
 
 	bool ShowSplat = false;
+	bool ShowGrass = true;
+	bool ShowFoliage = true;
+	bool UsePalette = true;
+	bool PaletteDirty = false;
+	bool UseOcclusionCulling = true;
+
+	TerrainHorizonCuller OcclusionCuller;
+	TerrainDrawOrder DrawOrder;
+	std::vector<BoundingBox> TileBounds;
+	std::vector<float> TileDistances;
+	std::vector<uint32_t> TileFlags;
+	std::vector<uint64_t> BatchKeys;
+	std::vector<size_t> VisibleTiles;
 
 	Shader TerrainShader = { 0 };
 	TerainRenderer Renderer;
-	int SunVectorLoc = 0;
-	int SelectedShaderFlagLoc = 0;
-	int ShowSplatFlagLoc = 0;
+	Shader FoliageShader = { 0 };
+	int FoliageSunVectorLoc = -1;
 
 	std::vector<std::unique_ptr<AssetReferenceResolver<AssetTypes::TerrainMaterialAsset>>> MaterialRefs;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Panel.h"
 
 #include "TerrainBuilder.h"
+#include "TerrainAOBaker.h"
 
 class TerrainGenerationPanel : public EditorFramework::Panel
 {
@@ -15,6 +16,7 @@ protected:
     void OnShow() override;
 
     TileMeshBuilder Builder;
+    TerrainAOBaker AOBaker;
 
 private:
     int GridX = 6;
@@ -1,6 +1,8 @@
 #include "EditorThumbnailManager.h"
 
 #include "CRC64.h"
+#include "MemoryStats.h"
+#include "Profiler.h"
 #include <unordered_map>
 
 #include "AssetManager.h"
@@ -22,9 +24,12 @@ namespace Editor
             if (it != ThumbnailCache.end())
                 return it->second;
 
+            PROFILE_SCOPE("ThumbnailManager::LoadThumbnail");
+
             // Load the thumbnail from the file system
             Texture2D thumbnail = LoadTexture(AssetManager::ToFileSystemPath(AssetManager::AssetPath(path)).c_str());
             GenTextureMipmaps(&thumbnail);
+            MemoryStats::AddTexture(MemoryStats::Category::Thumbnails, thumbnail);
             SetTextureFilter(thumbnail, TEXTURE_FILTER_ANISOTROPIC_16X);
             ThumbnailCache[crc] = thumbnail;
             return thumbnail;
@@ -3,6 +3,7 @@
 #include "Application.h"
 #include "DisplayScale.h"
 #include "Dialog.h"
+#include "Profiler.h"
 
 #include "imgui_utils.h"
 #include "extras/IconsFontAwesome6.h"
@@ -12,6 +13,8 @@
 #include "raymath.h"
 #include "rlgl.h"
 
+#include <algorithm>
+
 static constexpr float CAMERA_MOVE_SPEED = 20;
 static constexpr float CAMERA_ROTATION_SPEED = 1;
 static constexpr float CAMERA_PAN_SPEED = 20;
@@ -88,7 +91,22 @@ void TerrainDocument::OnUpdate(int width, int height)
 {
 	ViewportDocument::OnUpdate(width, height);
 
-	SetShaderValue(TerrainShader, SunVectorLoc, SunVector, SHADER_UNIFORM_VEC3);
+	NormalBaker.Update(Tiles);
+	Grass.Update(Tiles);
+
+	Foliage.Update(Tiles);
+
+	if (PaletteDirty)
+		RebuildPalette();
+	AlbedoBaker.Update(Tiles);
+	Renderer.SetPalette(UsePalette ? &Palette : nullptr);
+
+	Renderer.SunVector[0] = SunVector[0];
+	Renderer.SunVector[1] = SunVector[1];
+	Renderer.SunVector[2] = SunVector[2];
+
+	if (FoliageSunVectorLoc >= 0)
+		SetShaderValue(FoliageShader, FoliageSunVectorLoc, SunVector, SHADER_UNIFORM_VEC3);
 }	
 
 void TerrainDocument::OnAssetCreate()
@@ -124,11 +142,15 @@ void TerrainDocument::HandleMaterialListChangedEvent(const ValueChangedEvent& ev
 	if (event.RecordType == ValueChangedEvent::ValueRecordType::TypeListCleared)
 	{
 		MaterialListCache.clear();
+		PaletteDirty = true;
+		AlbedoBaker.InvalidateMaterials();
 	}
     else if (event.RecordType == ValueChangedEvent::ValueRecordType::TypeListItemRemoved)
     {
 		int index = event.Path.Elements.back().Index;
 		MaterialListCache.erase(MaterialListCache.begin() + index);
+		PaletteDirty = true;
+		AlbedoBaker.InvalidateMaterials();
     }
     else if (event.RecordType == ValueChangedEvent::ValueRecordType::TypeListItemAdded)
     {
@@ -171,6 +193,33 @@ void TerrainDocument::RebuildMaterialIndex(int index)
 		MaterialListCache[index].DiffuseMap.id = -1;
 		MaterialListCache[index].NormalMap.id = -1;
 	}
+
+	PaletteDirty = true;
+	AlbedoBaker.InvalidateMaterials();
+}
+
+void TerrainDocument::RebuildPalette()
+{
+	PaletteDirty = false;
+
+	Palette.Unload();
+	Palette.Clear();
+	for (auto& material : MaterialListCache)
+		Palette.Add(&material);
+
+	if (!Palette.Build())
+		return;
+
+	for (auto& tile : Tiles)
+		UpdateIndexedSplat(tile);
+}
+
+void TerrainDocument::UpdateIndexedSplat(TerrainTile& tile)
+{
+	if (Palette.GetTextureId() == 0)
+		return;
+
+	tile.SetIndexedSplat(Palette.EncodeTile(tile));
 }
 
 void TerrainDocument::OnShowScene(const Vector2& renderSize)
@@ -190,34 +239,75 @@ void TerrainDocument::OnShowScene(const Vector2& renderSize)
 
 	DrawCube(Vector3{ 0,1,0 }, 0.125f, 2, 0.125f, PURPLE);
 
-	int showSplat = ShowSplat ? 1 : 0;
-	SetShaderValue(TerrainShader, ShowSplatFlagLoc, &showSplat, SHADER_UNIFORM_INT);
+	uint32_t drawFlags = ShowSplat ? TerrainDrawShowSplat : TerrainDrawNone;
+
+	Vector3 viewPos = VieportCamera.GetCamera()->position;
+
+	Vector3 cameraPos = viewPos;
+	cameraPos.z = 0;
+
+	// rings front to back, so nearer ridges hide the tiles behind them both in the culler and in the depth test
+	// the flags go into the batch key, a tile that switches to its far albedo also switches shaders
+	TileBounds.resize(Tiles.size());
+	TileDistances.resize(Tiles.size());
+	TileFlags.resize(Tiles.size());
+	BatchKeys.resize(Tiles.size());
+	for (size_t i = 0; i < Tiles.size(); i++)
+	{
+		TileBounds[i] = Tiles[i].GetBounds();
+
+		Vector3 tileCenter = { (Tiles[i].Origin.X + 0.5f) * Info.TerrainTileSize, (Tiles[i].Origin.Y + 0.5f) * Info.TerrainTileSize, 0 };
+		TileDistances[i] = Vector3Distance(cameraPos, tileCenter);
+
+		TileFlags[i] = drawFlags;
+		if (TileDistances[i] > Info.TerrainTileSize * FarAlbedoTileDistance)
+			TileFlags[i] |= TerrainDrawFarAlbedo;
+
+		BatchKeys[i] = Renderer.GetBatchKey(Tiles[i], TileFlags[i]);
+	}
+
+	DrawOrder.RingSize = Info.TerrainTileSize * 2;
+	DrawOrder.Update(TileBounds, viewPos);
+
+	OcclusionCuller.BeginFromCurrent();
+
+	VisibleTiles.clear();
+	for (size_t i : DrawOrder.GetOrder())
+	{
+		if (!UseOcclusionCulling || OcclusionCuller.Process(TileBounds[i]))
+			VisibleTiles.push_back(i);
+	}
+
+	DrawOrder.SortBatches(VisibleTiles, BatchKeys);
 
 	// draw terrain
-	for (int i = 0; i < Tiles.size(); i++)
+	Profiler::BeginGpuScope("Terrain");
+	for (size_t i : VisibleTiles)
 	{
-		// todo, compute the distance from the camera tile
-		int lod = (int)std::max(Tiles[i].Origin.X, Tiles[i].Origin.Y) / 3;
+		int lod = int(TileDistances[i] / (Info.TerrainTileSize * LODTileDistance));
 		if (lod >= MaxLODLevels)
 			lod = MaxLODLevels - 1;
 
-		int selected = 0;
-		SetShaderValue(TerrainShader, SelectedShaderFlagLoc, &selected, SHADER_UNIFORM_INT);
-		Renderer.Draw(Tiles[i], lod);
+		Renderer.Draw(Tiles[i], lod, TileFlags[i]);
 		if (Tiles[i].Origin == SelectedTileLoc)
 		{
 			rlEnableWireMode();
 			rlSetLineWidth(2);
 			//rlDisableDepthTest();
-			selected = 1;
-			SetShaderValue(TerrainShader, SelectedShaderFlagLoc, &selected, SHADER_UNIFORM_INT);
-			Renderer.Draw(Tiles[i], lod);
+			Renderer.Draw(Tiles[i], lod, drawFlags | TerrainDrawSelected);
 			// rlEnableDepthTest();
 
 			rlDisableWireMode();
 			rlSetLineWidth(1);
 		}
 	}
+	Profiler::EndGpuScope();
+
+	if (ShowGrass)
+		Grass.Draw(VieportCamera.GetCamera()->position);
+
+	if (ShowFoliage)
+		Foliage.Draw(*VieportCamera.GetCamera());
 }
 
 void TerrainDocument::OnShowUI()
@@ -243,31 +333,68 @@ void TerrainDocument::OnShowUI()
 
 void TerrainDocument::SetupDocument()
 {
-	TerrainShader = LoadShader("resources/shaders/terrain.vs", "resources/shaders/terrain.fs");
-	if (!IsShaderValid(TerrainShader))
+	// variants per active layer set and draw flag are compiled on demand
+	if (!Renderer.LoadShaderSource("resources/shaders/terrain.vs", "resources/shaders/terrain.fs"))
+	{
 		TerrainShader = LoadShader(nullptr, nullptr);
-
-	SunVectorLoc = GetShaderLocation(TerrainShader, "sunVector");
+		Renderer.SetShader(TerrainShader);
+	}
 
 	NearPlane = 0.1f;
 	FarPlane = 5000.0f;
 
-	float selectedColor[4] = { 1,1,0,1 };
-	SetShaderValue(TerrainShader, GetShaderLocation(TerrainShader, "selectedColor"), selectedColor, SHADER_UNIFORM_VEC4);
+	Renderer.SelectedColor = YELLOW;
 
-	SelectedShaderFlagLoc = GetShaderLocation(TerrainShader, "selected");
-	ShowSplatFlagLoc = GetShaderLocation(TerrainShader, "showSplat");
+	Shader grassShader = LoadShader("resources/shaders/grass.vs", "resources/shaders/grass.fs");
+	if (IsShaderValid(grassShader))
+		Grass.SetShader(grassShader);
 
-	Renderer.SetShader(TerrainShader);
+	SetupFoliage();
 
 	auto visGroup = MainToolbar.AddGroup("TerrainVis");
 	auto splatCommand = visGroup->AddItem<StateMenuCommand>(0, ICON_FA_SPLOTCH, "Show Splatmap", [this](CommandContextSet*) {ShowSplat = !ShowSplat; }, [this](CommandContextSet*) {return ShowSplat; });
+	auto grassCommand = visGroup->AddItem<StateMenuCommand>(1, ICON_FA_SEEDLING, "Show Grass", [this](CommandContextSet*) {ShowGrass = !ShowGrass; }, [this](CommandContextSet*) {return ShowGrass; });
+	auto foliageCommand = visGroup->AddItem<StateMenuCommand>(2, ICON_FA_TREE, "Show Foliage", [this](CommandContextSet*) {ShowFoliage = !ShowFoliage; }, [this](CommandContextSet*) {return ShowFoliage; });
+	auto occlusionCommand = visGroup->AddItem<StateMenuCommand>(4, ICON_FA_EYE_SLASH, "Occlusion Culling", [this](CommandContextSet*) {UseOcclusionCulling = !UseOcclusionCulling; }, [this](CommandContextSet*) {return UseOcclusionCulling; });
+	auto paletteCommand = visGroup->AddItem<StateMenuCommand>(3, ICON_FA_LAYER_GROUP, "Material Palette", [this](CommandContextSet*) {UsePalette = !UsePalette; }, [this](CommandContextSet*) {return UsePalette; });
 
 	auto& cameraGroup = MainToolbar.AddGroup("Cameras");
 
 	auto viewMenu = DocumentMenuBar.AddSubItem("View", "", 20);
 	auto showGroup = viewMenu->AddGroup("Show", ICON_FA_EYE);
 	showGroup->AddItem(0, splatCommand);
+	showGroup->AddItem(1, grassCommand);
+	showGroup->AddItem(2, foliageCommand);
+	showGroup->AddItem(3, paletteCommand);
+	showGroup->AddItem(4, occlusionCommand);
+}
+
+void TerrainDocument::SetupFoliage()
+{
+	FoliageShader = LoadShader("resources/shaders/foliage.vs", "resources/shaders/foliage.fs");
+	if (!IsShaderValid(FoliageShader))
+		return;
+
+	FoliageShader.locs[SHADER_LOC_VERTEX_INSTANCE_TX] = GetShaderLocationAttrib(FoliageShader, "instanceTransform");
+	FoliageSunVectorLoc = GetShaderLocation(FoliageShader, "sunVector");
+
+	// placeholder tree until foliage comes from assets
+	TerrainFoliageType tree;
+	tree.SplatChannel = 1;
+	tree.InstanceMesh = GenMeshCone(1.5f, 6, 8);
+	tree.MeshTransform = MatrixRotateX(90 * DEG2RAD);
+	tree.InstanceMaterial = LoadMaterialDefault();
+	tree.InstanceMaterial.shader = FoliageShader;
+	tree.InstanceMaterial.maps[MATERIAL_MAP_DIFFUSE].color = DARKGREEN;
+
+	Image impostor = GenImageColor(32, 64, BLANK);
+	ImageDrawRectangle(&impostor, 14, 52, 4, 12, BROWN);
+	ImageDrawTriangle(&impostor, Vector2{ 16, 0 }, Vector2{ 2, 54 }, Vector2{ 30, 54 }, DARKGREEN);
+	tree.Impostor = LoadTextureFromImage(impostor);
+	UnloadImage(impostor);
+	tree.ImpostorSize = Vector2{ 3, 6 };
+
+	Foliage.Types.push_back(tree);
 }
 
 void TerrainDocument::OnCreated()
@@ -303,4 +430,15 @@ bool TerrainDocument::HasTile(int x, int y) const
 	}
 
 	return false;
+}
+
+const TerrainTile* TerrainDocument::FindTile(int64_t x, int64_t y) const
+{
+	for (auto& tile : Tiles)
+	{
+		if (tile.Origin.X == x && tile.Origin.Y == y)
+			return &tile;
+	}
+
+	return nullptr;
 }
\ No newline at end of file
@@ -68,7 +68,7 @@ void TerrainGenerationPanel::OnShow()
                     }
                 }
 
-                tile.Splatmap = LoadTextureFromImage(testSplat);
+                tile.SetSplatFromImage(testSplat);
                 UnloadImage(testSplat);
 
                 for (int i = 0; i < 5; i++)
@@ -84,10 +84,18 @@ void TerrainGenerationPanel::OnShow()
                 }
 
 
+                doc->UpdateIndexedSplat(tile);
+
                 tile.Origin = TerrainPosition{ x, y };
                 Builder.Build(tile);
+                doc->NormalBaker.QueueBake(tile);
             }
         }
+
+        // occlusion looks into the neighbours, so it has to wait until every tile has heights
+        auto lookup = [doc](int64_t x, int64_t y) { return doc->FindTile(x, y); };
+        for (auto& tile : doc->Tiles)
+            AOBaker.Bake(tile, lookup);
     }
 
 }
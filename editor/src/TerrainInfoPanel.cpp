@@ -3,6 +3,7 @@
 #include "TerrainDocument.h"
 
 #include "DisplayScale.h"
+#include "MemoryStats.h"
 
 #include "extras/IconsFontAwesome6.h"
 #include "ImGuiExtras.h"
@@ -69,6 +70,8 @@ void TerrainInfoPanel::OnShow()
 
     if (ImGui::CollapsingHeader("Tiles", ImGuiTreeNodeFlags_DefaultOpen))
     {
+        ImGui::Text("%d of %d tiles occluded", int(doc->GetOccludedTileCount()), int(doc->Tiles.size()));
+
         size_t count = std::min(std::max(size_t(1),doc->Tiles.size()), size_t(5));
 
         float height = (ImGui::GetTextLineHeight() * count) + (count - 1) * ImGui::GetStyle().ItemInnerSpacing.y;
@@ -99,6 +102,37 @@ void TerrainInfoPanel::OnShow()
         ImGui::EndChild();
     }
 
+    if (ImGui::CollapsingHeader("Memory"))
+    {
+        if (ImGui::BeginTable("MemoryTable", 4, tableFlags | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Category");
+            ImGui::TableSetupColumn("Size");
+            ImGui::TableSetupColumn("Peak");
+            ImGui::TableSetupColumn("Allocs");
+            ImGui::TableHeadersRow();
+
+            for (size_t i = 0; i < size_t(MemoryStats::Category::Count); i++)
+            {
+                MemoryStats::Category category = MemoryStats::Category(i);
+                MemoryStats::Counter counter = MemoryStats::Get(category);
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s%s", MemoryStats::GetName(category), MemoryStats::IsGpu(category) ? " (GPU)" : "");
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(MemoryStats::FormatBytes(counter.Bytes).c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(MemoryStats::FormatBytes(counter.PeakBytes).c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%lld", (long long)counter.Allocations);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::Text("CPU %s, GPU %s", MemoryStats::FormatBytes(MemoryStats::GetTotal(false)).c_str(), MemoryStats::FormatBytes(MemoryStats::GetTotal(true)).c_str());
+    }
+
     if (ImGui::CollapsingHeader("Overview", ImGuiTreeNodeFlags_DefaultOpen))
     {
         if (ImGui::BeginChild("Map", ImGui::GetContentRegionAvail(), ImGuiChildFlags_Border))
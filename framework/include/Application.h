@@ -137,6 +137,9 @@ namespace EditorFramework
 
 		void ApplyWindowSettings();
 
+		void ToggleTrace();
+		void FinishTrace();
+
 		// app window settings
 		static constexpr float InvalidSize = -99999999.0f;
 
@@ -181,6 +184,9 @@ namespace EditorFramework
 		bool ShowStyleEditor = false;
 		bool ShowMetricsWindow = false;
 
+		// set by --trace, where the trace is written when recording stops
+		std::string TraceFile;
+
 		Rectangle ContentRectangle = { 0,0,0,0 };
 
 		bool WindowMenuDirty = false;
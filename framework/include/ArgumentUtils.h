@@ -35,7 +35,7 @@ namespace EditorFramework
 				else if (foundArg && count < pramCount)
 				{
 					params.push_back(std::string_view(arg));
-					pramCount++;
+					count++;
 				}
 			}
 
@@ -4,6 +4,9 @@
 
 #include <list>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace EditorFramework
 {
@@ -38,4 +41,43 @@ namespace EditorFramework
         LogPanel();
         void OnShow() override;
     };
-}
\ No newline at end of file
+
+    class ProfilerPanel : public Panel
+    {
+    private:
+        struct ScopeStats
+        {
+            std::string_view Name;
+            bool Gpu = false;
+            size_t Calls = 0;
+            double Total = 0;
+            double MaxFrame = 0;
+
+            // running sum for the frame being tallied, so the max is per frame and not per call
+            size_t LastFrame = 0;
+            double FrameTotal = 0;
+        };
+
+        bool Recording = true;
+
+        std::vector<float> CpuTimes;
+        std::vector<float> GpuTimes;
+        std::vector<float> MemoryUsage;
+
+        std::vector<ScopeStats> Stats;
+        std::unordered_map<std::string_view, size_t> CpuStatIndex;
+        std::unordered_map<std::string_view, size_t> GpuStatIndex;
+
+        void Tally(std::unordered_map<std::string_view, size_t>& index, std::string_view name, bool gpu, size_t frame, double duration);
+        void ExportCSV();
+
+    public:
+        DEFINE_PANEL(ProfilerPanel);
+
+        ProfilerPanel();
+        void OnShow() override;
+
+        // the profiler only records while the panel is open and not paused
+        bool WantsRecording() { return IsOpen() && Recording; }
+    };
+}
@@ -18,6 +18,8 @@ namespace EditorFramework
     static constexpr char ImGuiMetricsAction[] = "Metrics Window";
     static constexpr char ImGuiItemPickerAction[] = "Item Picker";
 
+    static constexpr char RecordTraceAction[] = "Record Trace";
+
     static constexpr char ResetLayoutAction[] = "Reset Layout";
 
     static constexpr char PreferencesAction[] = "Preferences...";
@@ -52,6 +54,8 @@ namespace EditorFramework
         ActionRegistry::Register(ImGuiStyleAction, ICON_FA_PEN_FANCY, "Show ImGi Style Editor", ImGuiKey_None);
         ActionRegistry::Register(ImGuiMetricsAction, ICON_FA_RULER_COMBINED, "Show ImGui Metrics Window", ImGuiKey_None);
         ActionRegistry::Register(ImGuiItemPickerAction, ICON_FA_BUG_SLASH, "Break in debugger on next item click", ImGuiKey_None); 
+
+        ActionRegistry::Register(RecordTraceAction, ICON_FA_STOPWATCH, "Record profiler scopes to a Chrome trace file", ImGuiKey_None);
         
         ActionRegistry::Register(ResetLayoutAction, ICON_FA_RECYCLE, "Reset Layout", ImGuiKey_None);
 
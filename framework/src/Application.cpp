@@ -6,6 +6,8 @@
 #include "StandardActions.h"
 #include "DefaultPanels.h"
 #include "KeybindingsDialog.h"
+#include "Profiler.h"
+#include "ArgumentUtils.h"
 
 #include "raylib.h"
 #include "raymath.h"
@@ -76,6 +78,13 @@ namespace EditorFramework
 			args.push_back(argv[arg]);
 		}
 
+		auto traceParams = ArgumentUtils::GetArgumentParams("--trace", 1, args);
+		if (!traceParams.empty())
+		{
+			TraceFile = traceParams[0];
+			Profiler::StartTrace();
+		}
+
 		OnProcessArguments(args);
 	}
 
@@ -85,7 +94,12 @@ namespace EditorFramework
 
 		while (!WantQuit)
 		{
+			auto* profilerPanel = GetPanel<ProfilerPanel>();
+			Profiler::SetEnabled(profilerPanel != nullptr && profilerPanel->WantsRecording());
+
+			Profiler::BeginFrame();
 			Update();
+			Profiler::EndFrame();
 
 			if (WindowShouldClose())
 				Quit();
@@ -120,6 +134,8 @@ namespace EditorFramework
 
 		LogSink::Init();
 
+		Profiler::SetThreadName("Main");
+
 		LoadSettings();
 
 		// do not set HI DPI in flags, we are going to manage that ourselves
@@ -201,9 +217,12 @@ namespace EditorFramework
 
 	void Application::Update()
 	{
+		PROFILE_SCOPE("Application::Update");
+
 		RebuildWindowMenu();
 
 		BeginDrawing();
+		Profiler::BeginGpuScope("Frame");
 		ClearBackground(DARKGRAY);
 
 		if (IsTextureValid(BackgroundTexture))
@@ -327,7 +346,9 @@ namespace EditorFramework
 					ContentRectangle.width = contentArea.x;
 					ContentRectangle.height = contentArea.y;
 
+					Profiler::BeginScope("Document::OnUpdate");
 					doc->OnUpdate(int(contentArea.x), int(contentArea.y));
+					Profiler::EndScope();
 
 					if (!IsRenderTextureValid(ActiveDocumentRenderTexture) || int(contentArea.x) != ActiveDocumentRenderTexture.texture.width || int(contentArea.y) != ActiveDocumentRenderTexture.texture.height)
 					{
@@ -337,11 +358,15 @@ namespace EditorFramework
 						ActiveDocumentRenderTexture = LoadRenderTexture(int(contentArea.x), int(contentArea.y));
 					}
 
+					Profiler::BeginScope("Document::OnShowContent");
+					Profiler::BeginGpuScope("Document::OnShowContent");
 					BeginTextureMode(ActiveDocumentRenderTexture);
 					auto color = ImGui::GetStyle().Colors[ImGuiCol_WindowBg];
 					ClearBackground(Color{ uint8_t(color.x * 255), uint8_t(color.y * 255), uint8_t(color.z * 255), uint8_t(color.w * 255) });
 					doc->OnShowContent(int(contentArea.x), int(contentArea.y));
 					EndTextureMode();
+					Profiler::EndGpuScope();
+					Profiler::EndScope();
 
 					auto cursor = ImGui::GetCursorPos();
 					rlImGuiImageRenderTexture(&ActiveDocumentRenderTexture);
@@ -364,6 +389,7 @@ namespace EditorFramework
 			}
 		}
 
+		Profiler::BeginScope("Panels");
 		for (auto& [id, panel] : Panels)
 		{
 			if (ResetLayouts)
@@ -371,6 +397,7 @@ namespace EditorFramework
 
 			panel->Update();
 		}
+		Profiler::EndScope();
 
 		if (ShowDemoWindow)
 			ImGui::ShowDemoWindow(&ShowDemoWindow);
@@ -394,8 +421,13 @@ namespace EditorFramework
 		ResetLayouts = false;
 
 		// Draw ImGui over the top of the background
+		Profiler::BeginScope("ImGui");
+		Profiler::BeginGpuScope("ImGui");
 		rlImGuiEnd();
+		Profiler::EndGpuScope();
+		Profiler::EndScope();
 
+		Profiler::EndGpuScope();
 		EndDrawing();
 	}
 
@@ -414,6 +446,10 @@ namespace EditorFramework
 
 		rlImGuiShutdown();
 		OnShutdown();
+
+		if (Profiler::IsTracing())
+			FinishTrace();
+		Profiler::Shutdown();
 		CloseWindow();
 	}
 
@@ -484,6 +520,7 @@ namespace EditorFramework
 	void Application::RegisterDefaultPanels()
 	{
 		RegisterPanel<LogPanel>();
+		RegisterPanel<ProfilerPanel>();
 	}
 
 	void Application::RegisterDefaultMenus(MenuBar& menu)
@@ -561,6 +598,12 @@ namespace EditorFramework
 			nullptr,
 			[this](CommandContextSet*) {return ShowMetricsWindow; });
 
+		auto profilingGroup = programmer->AddGroup("Profiling", ICON_FA_GAUGE_HIGH, 20);
+
+		profilingGroup->AddItem<ActionCommandItem>(0, RecordTraceAction, [this](float, CommandContextSet*) { ToggleTrace(); },
+			nullptr,
+			[this](CommandContextSet*) {return Profiler::IsTracing(); });
+
 		// Panel menu
 		auto panelMenu = menu.AddSubItem("Panels", "", 600);
 		auto panelsGroup = panelMenu->AddGroup("Panels", ICON_FA_WINDOW_RESTORE, 10);
@@ -589,6 +632,35 @@ namespace EditorFramework
 		OnSetupMainMenuBar(menu);
 	}
 
+	void Application::ToggleTrace()
+	{
+		if (Profiler::IsTracing())
+			FinishTrace();
+		else
+			Profiler::StartTrace();
+	}
+
+	void Application::FinishTrace()
+	{
+		Profiler::StopTrace();
+
+		std::string fileName = TraceFile;
+		if (fileName.empty())
+		{
+			const char* filters[] = { "*.json" };
+			const char* selected = tinyfd_saveFileDialog("Save trace as...", "trace.json", 1, filters, "Chrome trace files");
+			if (!selected)
+				return;
+
+			fileName = selected;
+		}
+
+		if (Profiler::WriteTrace(fileName))
+			TraceLog(LOG_INFO, "Trace written to %s", fileName.c_str());
+		else
+			TraceLog(LOG_WARNING, "Unable to write trace to %s", fileName.c_str());
+	}
+
 	void Application::RebuildWindowMenu()
 	{
 		if (!WindowMenu || !WindowMenuDirty)
@@ -5,6 +5,12 @@
 #include "rlImGuiColors.h"
 #include "ImGuiExtras.h"
 
+#include "MemoryStats.h"
+#include "Profiler.h"
+#include "tinyfiledialogs.h"
+
+#include <algorithm>
+#include <cfloat>
 #include <deque>
 
 namespace EditorFramework
@@ -197,4 +203,187 @@ namespace EditorFramework
         }
         ImGui::EndChild();
     }
-}
\ No newline at end of file
+
+    ProfilerPanel::ProfilerPanel()
+    {
+        Icon = ICON_FA_GAUGE_HIGH;
+        Name = "Profiler";
+
+        Location = PlanelLayoutLocation::Bottom;
+
+        // recording costs a little every frame, so it is opt in
+        Close();
+    }
+
+    void ProfilerPanel::Tally(std::unordered_map<std::string_view, size_t>& index, std::string_view name, bool gpu, size_t frame, double duration)
+    {
+        auto itr = index.find(name);
+        if (itr == index.end())
+        {
+            itr = index.emplace(name, Stats.size()).first;
+            Stats.emplace_back();
+            Stats.back().Name = name;
+            Stats.back().Gpu = gpu;
+            Stats.back().LastFrame = frame;
+        }
+
+        ScopeStats& stats = Stats[itr->second];
+        if (stats.LastFrame != frame)
+        {
+            stats.MaxFrame = std::max(stats.MaxFrame, stats.FrameTotal);
+            stats.FrameTotal = 0;
+            stats.LastFrame = frame;
+        }
+
+        stats.Calls++;
+        stats.Total += duration;
+        stats.FrameTotal += duration;
+    }
+
+    void ProfilerPanel::ExportCSV()
+    {
+        const char* filters[] = { "*.csv" };
+        const char* fileName = tinyfd_saveFileDialog("Export profile...", "profile.csv", 1, filters, "CSV files");
+        if (!fileName)
+            return;
+
+        if (Profiler::WriteCSV(fileName))
+            TraceLog(LOG_INFO, "Profile written to %s", fileName);
+        else
+            TraceLog(LOG_WARNING, "Unable to write profile to %s", fileName);
+    }
+
+    void ProfilerPanel::OnShow()
+    {
+        const auto& history = Profiler::GetHistory();
+
+        ImGui::Checkbox("Record", &Recording);
+
+        ImGui::SameLine();
+        ImGui::BeginDisabled(history.empty());
+        if (ImGui::Button(ICON_FA_FILE_CSV " Export CSV"))
+            ExportCSV();
+        ImGui::EndDisabled();
+
+        if (history.empty())
+        {
+            ImGui::TextUnformatted("No frames recorded");
+            return;
+        }
+
+        CpuTimes.clear();
+        GpuTimes.clear();
+
+        float maxCpu = 0;
+        float maxGpu = 0;
+        for (const auto& frame : history)
+        {
+            CpuTimes.push_back(float(frame.Duration));
+            GpuTimes.push_back(float(std::max(frame.GpuDuration, 0.0)));
+
+            maxCpu = std::max(maxCpu, CpuTimes.back());
+            maxGpu = std::max(maxGpu, GpuTimes.back());
+        }
+
+        // never scale below a 60hz frame, so a steady light load reads as light
+        float scale = std::max({ maxCpu, maxGpu, 1000.0f / 60.0f });
+
+        const auto& last = history.back();
+        ImGui::SameLine();
+        ImGui::Text("CPU %.2f ms (max %.2f)  GPU %.2f ms (max %.2f)", last.Duration, maxCpu, std::max(last.GpuDuration, 0.0), maxGpu);
+
+        ImGui::PlotLines("##CpuFrames", CpuTimes.data(), int(CpuTimes.size()), 0, "CPU", 0, scale, ImVec2(-1, 50));
+        ImGui::PlotLines("##GpuFrames", GpuTimes.data(), int(GpuTimes.size()), 0, "GPU", 0, scale, ImVec2(-1, 50));
+
+        if (ImGui::CollapsingHeader("Memory"))
+        {
+            MemoryUsage.clear();
+            for (const auto& frame : history)
+                MemoryUsage.push_back(float(frame.CpuMemory + frame.GpuMemory) / (1024.0f * 1024.0f));
+
+            ImGui::Text("CPU %s  GPU %s", MemoryStats::FormatBytes(last.CpuMemory).c_str(), MemoryStats::FormatBytes(last.GpuMemory).c_str());
+            ImGui::PlotLines("##Memory", MemoryUsage.data(), int(MemoryUsage.size()), 0, "MB", 0, FLT_MAX, ImVec2(-1, 50));
+
+            if (ImGui::BeginTable("###ProfilerMemory", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+            {
+                ImGui::TableSetupColumn("Category", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("Size");
+                ImGui::TableSetupColumn("Peak");
+                ImGui::TableSetupColumn("Allocs");
+                ImGui::TableHeadersRow();
+
+                for (size_t i = 0; i < size_t(MemoryStats::Category::Count); i++)
+                {
+                    MemoryStats::Category category = MemoryStats::Category(i);
+                    MemoryStats::Counter counter = MemoryStats::Get(category);
+
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s%s", MemoryStats::GetName(category), MemoryStats::IsGpu(category) ? " (GPU)" : "");
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(MemoryStats::FormatBytes(counter.Bytes).c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(MemoryStats::FormatBytes(counter.PeakBytes).c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%lld", (long long)counter.Allocations);
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        // hottest scopes over the whole history, inclusive of their children
+        Stats.clear();
+        CpuStatIndex.clear();
+        GpuStatIndex.clear();
+
+        for (size_t f = 0; f < history.size(); f++)
+        {
+            for (const auto& scope : history[f].Scopes)
+                Tally(CpuStatIndex, scope.Name, false, f, scope.Duration);
+
+            for (const auto& scope : history[f].GpuScopes)
+                Tally(GpuStatIndex, scope.Name, true, f, scope.Duration);
+        }
+
+        for (auto& stats : Stats)
+            stats.MaxFrame = std::max(stats.MaxFrame, stats.FrameTotal);
+
+        std::sort(Stats.begin(), Stats.end(), [](const ScopeStats& a, const ScopeStats& b) { return a.Total > b.Total; });
+
+        double frameCount = double(history.size());
+
+        ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("###ProfilerScopes", 5, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Timer");
+            ImGui::TableSetupColumn("Calls/Frame");
+            ImGui::TableSetupColumn("Avg ms");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+
+            for (const auto& stats : Stats)
+            {
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(stats.Name.data(), stats.Name.data() + stats.Name.size());
+
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(stats.Gpu ? "GPU" : "CPU");
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", stats.Calls / frameCount);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.Total / frameCount);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.MaxFrame);
+            }
+
+            ImGui::EndTable();
+        }
+    }
+}
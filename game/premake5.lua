@@ -55,4 +55,6 @@ project (workspaceName)
     includedirs { "include" }
     
     link_raylib()
+    link_to("terrainLib")
+    link_to("common")
 -- To link to a lib use link_to("LIB_FOLDER_NAME")
\ No newline at end of file
@@ -45,6 +45,11 @@ int LODLevel = 0;
 #include "tile_builder.h"
 #include "tile_renderer.h"
 
+#include "TerrainCulling.h"
+#include "TerrainDrawOrder.h"
+
+#include <algorithm>
+
 
 float SunVector[3] = { 0,0,1 };
 int SunVectorLoc = 0;
@@ -57,6 +62,10 @@ TerrainMaterial RoadMateral;
 TerrainMaterial SnowMateral;
 
 std::vector<TerrainTile> Tiles;
+std::vector<BoundingBox> TileBounds;
+TerrainDrawOrder DrawOrder;
+
+TerrainHorizonCuller OcclusionCuller;
 
 Camera3D ViewCamera = { 0 };
 
@@ -223,6 +232,11 @@ void GameInit()
 
 			tile.Origin = TerrainPosition{ x, y };
 			builder.Build(tile);
+
+			auto range = std::minmax_element(tile.TerrainHeightMap.begin(), tile.TerrainHeightMap.end());
+			Vector3 min = { x * info.TerrainTileSize, y * info.TerrainTileSize, *range.first };
+			Vector3 max = { (x + 1) * info.TerrainTileSize, (y + 1) * info.TerrainTileSize, *range.second };
+			TileBounds.push_back(BoundingBox{ min, max });
 		}
 	}
 
@@ -287,9 +301,18 @@ void GameDraw()
 
 	DrawCube(Vector3{ 0,1,0 }, 0.125f, 2, 0.125f, PURPLE);
 
+	// every tile shares the same materials here, so the ring order is the whole batch order
+	DrawOrder.RingSize = info.TerrainTileSize * 2;
+	DrawOrder.Update(TileBounds, ViewCamera.position);
+
+	OcclusionCuller.BeginFromCurrent();
+
 	//rlEnableWireMode();
-	for (int i = 0; i < Tiles.size(); i++)
+	for (size_t i : DrawOrder.GetOrder())
 	{
+		if (!OcclusionCuller.Process(TileBounds[i]))
+			continue;
+
 		int lod = (int)std::max(Tiles[i].Origin.X, Tiles[i].Origin.Y) / 3;
 		if (lod >= MaxLODLevels)
 			lod = MaxLODLevels - 1;
@@ -302,6 +325,7 @@ void GameDraw()
 	EndMode3D();
 
 	DrawText(TextFormat("LOD Level = %d", LODLevel), 3, 20, 20, WHITE);
+	DrawText(TextFormat("Occluded %d of %d tiles", int(OcclusionCuller.GetOccludedCount()), int(Tiles.size())), 3, 40, 20, WHITE);
 	DrawFPS(3, 3);
 	EndDrawing();
 }
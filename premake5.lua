@@ -156,9 +156,11 @@ workspace (workspaceName)
 
     filter { "platforms:x64" }
         architecture "x86_64"
+        defines { "RAPIDJSON_SSE2" }
 
     filter { "platforms:Arm64" }
         architecture "ARM64"
+        defines { "RAPIDJSON_NEON" }
 
     filter {}
 
@@ -0,0 +1,21 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+in vec3 fragNormal;
+
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec3 sunVector;
+
+// Output fragment color
+out vec4 finalColor;
+
+void main()
+{
+    vec4 texelColor = texture(texture0, fragTexCoord)*colDiffuse;
+
+    float NdotL = max(dot(normalize(fragNormal), normalize(sunVector)), 0.0);
+
+    finalColor = vec4(texelColor.rgb*(0.6 + NdotL*0.6), texelColor.a);
+}
@@ -0,0 +1,15 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in float fragHeight;
+
+uniform vec4 baseColor;
+uniform vec4 tipColor;
+
+// Output fragment color
+out vec4 finalColor;
+
+void main()
+{
+    finalColor = mix(baseColor, tipColor, fragHeight);
+}
@@ -0,0 +1,37 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+
+// per instance, xyz world position, w random seed
+in vec4 instanceData;
+
+// Input uniform values
+uniform mat4 mvp;
+uniform float time;
+uniform vec2 bladeSize;
+
+// Output vertex attributes (to fragment shader)
+out float fragHeight;
+
+void main()
+{
+    float seed = instanceData.w;
+    float angle = seed * 6.2831853;
+    float scale = 0.7 + fract(seed * 17.0) * 0.6;
+
+    vec3 local = vertexPosition * vec3(bladeSize.x, bladeSize.x, bladeSize.y * scale);
+
+    float s = sin(angle);
+    float c = cos(angle);
+    local.xy = vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    // sway grows with the square of the height so the root stays put
+    float bend = vertexPosition.z * vertexPosition.z * bladeSize.y * 0.25;
+    local.x += sin(time * 1.7 + instanceData.x * 0.35 + seed * 6.0) * bend;
+    local.y += cos(time * 1.3 + instanceData.y * 0.35 + seed * 4.0) * bend * 0.5;
+
+    fragHeight = vertexPosition.z;
+
+    gl_Position = mvp*vec4(instanceData.xyz + local, 1.0);
+}
@@ -7,10 +7,27 @@ in vec4 fragColor;
 in vec3 fragNormal;
 in vec3 fragPosition;
 
+// TerainRenderer compiles permutations with TERRAIN_PERMUTATION, LAYER_MASK and the feature
+// flags defined, without them every layer is compiled in and chosen at runtime
+#ifdef TERRAIN_PERMUTATION
+const int selected = SELECTED;
+const int showSplat = SHOW_SPLAT;
+const int useNormalMap = USE_NORMAL_MAP;
+const int materialCount = 5;
+const int indexedSplat = INDEXED_SPLAT;
+const int farAlbedo = FAR_ALBEDO;
+#else
+#define LAYER_MASK 31
 uniform int selected;
+uniform int showSplat;
+uniform int useNormalMap;
+uniform int materialCount;
+uniform int indexedSplat;
+uniform int farAlbedo;
+#endif
+
 uniform vec4 selectedColor;
 
-uniform int showSplat;
 uniform float specularValue;
 
 uniform vec3 sunVector;
@@ -29,10 +46,20 @@ uniform vec4 matTint4;
 
 uniform vec4 colDiffuse;
 
-uniform int materialCount;
-
 uniform sampler2D splatmap;
 
+// palette mode, every material is a layer of one array and each splat texel names its top four
+uniform sampler2DArray materialArray;
+uniform vec4 paletteTint[32];
+uniform sampler2D splatIndices;
+uniform sampler2D splatWeights;
+
+// far field, every layer pre-blended into one low resolution texture
+uniform sampler2D albedoMap;
+
+uniform sampler2D normalMap;
+uniform vec2 normalMapTransform;
+
 // Output fragment color
 out vec4 finalColor;
 
@@ -51,10 +78,27 @@ void main()
 
     vec3 viewD = normalize(viewPos - fragPosition);
 
-    // TODO< check the splat map to see if we even need the base layer
-
     vec4 splatmapColor = vec4(1,0,1,1);
 
+    if (farAlbedo == 1)
+    {
+        texelColor = texture(albedoMap, fragTexCoord);
+    }
+    else if (indexedSplat == 1)
+    {
+        ivec4 layers = ivec4(texture(splatIndices, fragTexCoord) * 255.0 + 0.5);
+        vec4 weights = texture(splatWeights, fragTexCoord);
+
+        splatmapColor = texture(materialArray, vec3(fragTexCoord2, layers.x)) * paletteTint[layers.x] * weights.x;
+        splatmapColor += texture(materialArray, vec3(fragTexCoord2, layers.y)) * paletteTint[layers.y] * weights.y;
+        splatmapColor += texture(materialArray, vec3(fragTexCoord2, layers.z)) * paletteTint[layers.z] * weights.z;
+        splatmapColor += texture(materialArray, vec3(fragTexCoord2, layers.w)) * paletteTint[layers.w] * weights.w;
+
+        texelColor = splatmapColor;
+        splatColor = weights;
+    }
+
+#if (LAYER_MASK & 1) != 0
     int baseBlock = 0;
     if (splatColor.r >= 1 || splatColor.g >= 1 || splatColor.b >= 1 || splatColor.a >= 1)
     {
@@ -65,38 +109,49 @@ void main()
     {
         splatmapColor = texture(matDiffuse0, fragTexCoord2)* matTint0;
     }
+#endif
 
-     if (materialCount >= 2 && splatColor.r > 0)
-     {
+#if (LAYER_MASK & 2) != 0
+    if (materialCount >= 2 && splatColor.r > 0)
+    {
         vec4 mat1Color = texture(matDiffuse1, fragTexCoord2) * matTint1;
         splatmapColor = mix(mat1Color, splatmapColor, 1-splatColor.r);
-     }
-    
-     if (materialCount >= 3 && splatColor.g > 0)
-     {
-         vec4 mat2Color = texture(matDiffuse2, fragTexCoord2) * matTint2;
-         splatmapColor = mix(mat2Color, splatmapColor, 1-splatColor.g);
-     }
-     
-     if (materialCount >= 4 && splatColor.b > 0)
-     {
-         vec4 mat3Color = texture(matDiffuse3, fragTexCoord2) * matTint3;
-         splatmapColor = mix(mat3Color, splatmapColor, 1-splatColor.b);
-     }
-     
+    }
+#endif
+
+#if (LAYER_MASK & 4) != 0
+    if (materialCount >= 3 && splatColor.g > 0)
+    {
+        vec4 mat2Color = texture(matDiffuse2, fragTexCoord2) * matTint2;
+        splatmapColor = mix(mat2Color, splatmapColor, 1-splatColor.g);
+    }
+#endif
+
+#if (LAYER_MASK & 8) != 0
+    if (materialCount >= 4 && splatColor.b > 0)
+    {
+        vec4 mat3Color = texture(matDiffuse3, fragTexCoord2) * matTint3;
+        splatmapColor = mix(mat3Color, splatmapColor, 1-splatColor.b);
+    }
+#endif
+
+#if (LAYER_MASK & 16) != 0
     if (materialCount >= 5 && splatColor.a > 0)
     {
         vec4 mat4Color = texture(matDiffuse4, fragTexCoord2) * matTint4;
         splatmapColor = mix(mat4Color, splatmapColor, 1-splatColor.a);
     }
+#endif
 
-    if (materialCount > 0)
+    if (materialCount > 0 && LAYER_MASK != 0)
         texelColor = splatmapColor;
 
     if (showSplat == 1)
         texelColor = vec4(splatColor.r,splatColor.g,splatColor.b,1);
 
     vec3 normal = normalize(fragNormal);
+    if (useNormalMap == 1)
+        normal = normalize(texture(normalMap, fragTexCoord * normalMapTransform.x + normalMapTransform.y).xyz * 2.0 - 1.0);
 
     vec3 light = normalize(sunVector);
 
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "TerrainTile.h"
+
+#include <functional>
+#include <vector>
+
+// finds a loaded tile by tile grid position, nullptr when there is none
+using TerrainTileLookup = std::function<const TerrainTile* (int64_t x, int64_t y)>;
+
+// Horizon based ambient occlusion baked per vertex from the heightfield
+class TerrainAOBaker
+{
+public:
+    int Directions = 8;
+    int Steps = 12;
+    // world units searched for the horizon, capped at one tile
+    float Radius = 24;
+    float Strength = 1.0f;
+
+    // threads working on one bake, the calling thread included, the rest come from the shared TerrainJobQueue.
+    // 0 uses every worker of the queue
+    unsigned int ThreadCount = 0;
+
+    // (grid+1)^2 values, 255 is fully open sky
+    std::vector<uint8_t> BakeVertexOcclusion(const TerrainTile& tile, const TerrainTileLookup& neighbours) const;
+
+    // stores the result on the tile and updates the color stream if the mesh is built
+    void Bake(TerrainTile& tile, const TerrainTileLookup& neighbours) const;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "TerrainTile.h"
+#include "raylib.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Composites the splat and layer materials of a tile into one low resolution albedo texture for distant tiles.
+// Far away every material is well past its smallest mip, so each one is reduced to its tinted average color.
+class TerrainAlbedoBaker
+{
+public:
+    // texels across a tile
+    int Resolution = 64;
+
+    // composites tiles whose splat or materials changed since their last bake, call from the render thread
+    size_t Update(std::vector<TerrainTile>& tiles);
+
+    // forget the cached material colors, every tile is recomposited on the next update
+    void InvalidateMaterials();
+
+    static Color GetAverageColor(const TerrainMaterial& material);
+
+    // RGBA8, resolution x resolution, layerColors holds the tinted average of each tile layer
+    static std::vector<Color> Composite(const TerrainTile& tile, const Color* layerColors, int layerCount, int resolution);
+
+protected:
+    const Color& GetLayerColor(const TerrainMaterial* material);
+
+    std::unordered_map<const TerrainMaterial*, Color> LayerColors;
+    uint32_t MaterialRevision = 1;
+};
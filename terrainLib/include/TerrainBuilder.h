@@ -9,6 +9,15 @@ class TileMeshBuilder
 public:
     void Build(TerrainTile& tile);
 
+    // rewrites the color stream of a built tile from its baked occlusion
+    static void UpdateColors(TerrainTile& tile);
+
+    // CPU side index list of every LOD back to back, lodInfos gets the range of each
+    static std::vector<uint16_t> BuildIndexList(int gridSize, TerrainLODTriangleInfo* lodInfos);
+
+    // largest height difference between the full grid and the triangles of each LOD, MaxLODLevels entries
+    static void ComputeLODErrors(const TerrainTile& tile, float* errors);
+
 protected:
     std::vector<Vector3> GetSiblingNormals(TerrainTile& tile, int16_t h, int16_t v);
     Vector3 TileMeshBuilder::ComputeNormalForLocation(TerrainTile& tile, int16_t h, int16_t v);
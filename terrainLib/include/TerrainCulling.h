@@ -0,0 +1,55 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <vector>
+
+// View frustum planes pulled from a combined view projection matrix
+struct TerrainFrustum
+{
+    // left, right, bottom, top, near, far, xyz normal pointing inside, w distance
+    Vector4 Planes[6] = { 0 };
+
+    void Extract(const Matrix& viewProjection);
+
+    // uses the current rlgl modelview and projection, call inside BeginMode3D
+    void ExtractFromCurrent();
+
+    bool IsBoxVisible(const BoundingBox& box) const;
+};
+
+// Terrain on terrain occlusion with a 1D screen space horizon.
+// Tiles have to be fed front to back, each one is tested against the horizon built by the tiles before it.
+// Assumes the camera has no roll, so screen up stays world up.
+class TerrainHorizonCuller
+{
+public:
+    // horizon columns across the screen
+    int Resolution = 256;
+
+    void Begin(const Matrix& viewProjection);
+
+    // uses the current rlgl modelview and projection, call inside BeginMode3D
+    void BeginFromCurrent();
+
+    // true if every part of the box projects under the horizon
+    bool IsOccluded(const BoundingBox& bounds) const;
+
+    // raises the horizon by the solid ground under a tile, the footprint of the box up to its min z
+    void AddOccluder(const BoundingBox& bounds);
+
+    // tests, counts and, if visible, adds the tile as an occluder, returns true when it should be drawn
+    bool Process(const BoundingBox& bounds);
+
+    size_t GetOccludedCount() const { return OccludedCount; }
+    size_t GetProcessedCount() const { return ProcessedCount; }
+
+protected:
+    Matrix ViewProjection = { 0 };
+
+    // highest normalized device y known to be covered, per column
+    std::vector<float> Horizon;
+
+    size_t OccludedCount = 0;
+    size_t ProcessedCount = 0;
+};
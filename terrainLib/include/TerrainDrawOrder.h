@@ -0,0 +1,36 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Front to back tile ordering by footprint distance, with the tiles bucketed into camera distance rings.
+// The order is kept between frames and re-sorted in place, so a small camera move costs about one linear pass.
+class TerrainDrawOrder
+{
+public:
+    // world units per ring
+    float RingSize = 256;
+
+    // bounds are indexed like the caller's tiles, a change in count starts the order over
+    void Update(const std::vector<BoundingBox>& bounds, const Vector3& viewPos);
+
+    // every tile, nearest first, for passes that need strict front to back like occlusion
+    const std::vector<size_t>& GetOrder() const { return Order; }
+
+    int GetRing(size_t tile) const { return Rings[tile]; }
+    float GetDistance(size_t tile) const { return Distances[tile]; }
+
+    // regroups a front to back list ring by ring, inside a ring tiles sharing a batch key are drawn together
+    // and each batch stays front to back
+    void SortBatches(std::vector<size_t>& tiles, const std::vector<uint64_t>& batchKeys) const;
+
+protected:
+    std::vector<size_t> Order;
+    std::vector<float> Distances;
+    std::vector<int> Rings;
+
+    // scratch for SortBatches
+    mutable std::vector<uint32_t> BatchIndices;
+};
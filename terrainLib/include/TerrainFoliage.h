@@ -0,0 +1,119 @@
+#pragma once
+
+#include "TerrainTile.h"
+#include "raylib.h"
+
+#include <future>
+#include <vector>
+
+struct TerrainFoliageType
+{
+    // placement
+    int SplatChannel = 1;
+    float MinWeight = 0.5f;
+    // largest allowed 1 - normal.z, 0 is flat ground only
+    float MaxSlope = 0.3f;
+    // poisson disk radius in world units
+    float Spacing = 6;
+    float MinScale = 0.8f;
+    float MaxScale = 1.3f;
+    // top of the tallest instance above its base, used to grow the cull bounds
+    float Height = 6;
+
+    // near, drawn instanced
+    Mesh InstanceMesh = { 0 };
+    Material InstanceMaterial = { 0 };
+    // applied before the placement transform, for meshes that are not Z up
+    Matrix MeshTransform = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+
+    // far, drawn as a camera facing card
+    Texture2D Impostor = { 0 };
+    Vector2 ImpostorSize = { 4, 6 };
+};
+
+// 8 bytes per placed instance
+struct TerrainFoliageInstance
+{
+    // tile local position, x and y over the tile size, z over the terrain height range
+    uint16_t X = 0;
+    uint16_t Y = 0;
+    uint16_t Z = 0;
+    uint8_t Type = 0;
+    // drives rotation and scale
+    uint8_t Seed = 0;
+};
+
+// Trees and foliage placed by material weight and slope, drawn as meshes near the camera and impostors far away
+class TerrainFoliageSystem
+{
+public:
+    std::vector<TerrainFoliageType> Types;
+
+    float ImpostorDistance = 160;
+    float MaxDistance = 1000;
+    uint64_t Seed = 7;
+
+    // cells per tile side, each is culled on its own and draws all near or all far
+    int CellsPerTile = 4;
+
+    ~TerrainFoliageSystem();
+
+    // starts placement jobs for tiles whose heights or splat changed, collects finished ones and drops tiles that are gone
+    void Update(const std::vector<TerrainTile>& tiles);
+
+    void Draw(const Camera3D& camera);
+
+    void Clear();
+
+    size_t GetInstanceCount() const;
+    size_t GetDrawnMeshCount() const { return DrawnMeshes; }
+    size_t GetDrawnImpostorCount() const { return DrawnImpostors; }
+
+protected:
+    struct Cell
+    {
+        BoundingBox Bounds = { 0 };
+
+        // the instances of the cell, sorted by type, TypeStarts has one more entry than there are types
+        size_t First = 0;
+        std::vector<uint32_t> TypeStarts;
+
+        // mesh transforms of the instances, built when the cell is first drawn near and dropped once it is far
+        std::vector<Matrix> Transforms;
+    };
+
+    struct TileFoliage
+    {
+        TerrainPosition Origin;
+        uint32_t SplatRevision = 0;
+        uint32_t HeightRevision = 0;
+        bool Pending = false;
+
+        BoundingBox Bounds = { 0 };
+        float MinZ = 0;
+        float RangeZ = 0;
+
+        std::vector<TerrainFoliageInstance> Instances;
+        std::vector<Cell> Cells;
+    };
+
+    static TileFoliage Place(const TerrainTile& tile, const std::vector<TerrainFoliageType>& types, uint64_t seed, int cellsPerTile);
+
+    TileFoliage& GetTileFoliage(const TerrainPosition& origin);
+
+    Matrix GetInstanceTransform(const TileFoliage& tile, const TerrainFoliageInstance& instance, float tileSize) const;
+    Vector3 GetInstancePosition(const TileFoliage& tile, const TerrainFoliageInstance& instance, float tileSize) const;
+    float GetInstanceScale(const TerrainFoliageInstance& instance) const;
+
+    std::vector<TileFoliage> Tiles;
+    std::vector<std::future<TileFoliage>> PendingPlacements;
+
+    float TileSize = 0;
+
+    // per type scratch, reused every frame, near cells copy their cached transforms in
+    std::vector<std::vector<Matrix>> NearTransforms;
+    std::vector<std::vector<Vector4>> FarPositions;
+
+    size_t DrawnMeshes = 0;
+    size_t DrawnImpostors = 0;
+};
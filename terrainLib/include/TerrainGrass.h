@@ -0,0 +1,106 @@
+#pragma once
+
+#include "TerrainTile.h"
+#include "raylib.h"
+
+#include <future>
+#include <vector>
+
+struct TerrainGrassSettings
+{
+    // splat channel that grows grass, r,g,b,a
+    int SplatChannel = 0;
+    float MinWeight = 0.25f;
+
+    // blades per square meter at full weight, in the nearest ring
+    float Density = 6;
+
+    // cells per tile side, each cell is one instanced draw
+    int CellsPerTile = 4;
+
+    // every ring halves the drawn density, cells past the last ring are skipped
+    float RingSize = 32;
+    int RingCount = 4;
+
+    float BladeWidth = 0.08f;
+    float BladeHeight = 0.6f;
+
+    Color BaseColor = { 40, 80, 20, 255 };
+    Color TipColor = { 140, 190, 70, 255 };
+
+    uint64_t Seed = 1;
+};
+
+// Instanced grass blades scattered from a splat channel
+class TerrainGrassSystem
+{
+public:
+    TerrainGrassSettings Settings;
+
+    ~TerrainGrassSystem();
+
+    void SetShader(Shader shader);
+
+    // starts scatter jobs for tiles whose splat or heights changed, uploads finished ones and drops tiles that are gone
+    void Update(const std::vector<TerrainTile>& tiles);
+
+    void Draw(const Vector3& viewPos);
+
+    void Unload();
+
+    size_t GetInstanceCount() const;
+    size_t GetDrawnCellCount() const { return DrawnCells; }
+
+protected:
+    struct Cell
+    {
+        Vector3 Center = { 0,0,0 };
+        // x,y,z world position, w random seed for rotation, scale and sway phase
+        // released once uploaded, in random order so any prefix is an even thinning
+        std::vector<Vector4> Instances;
+        size_t InstanceCount = 0;
+
+        unsigned int VaoId = 0;
+        unsigned int InstanceVbo = 0;
+    };
+
+    struct TileGrass
+    {
+        TerrainPosition Origin;
+        uint32_t SplatRevision = 0;
+        uint32_t HeightRevision = 0;
+        bool Pending = false;
+
+        std::vector<Cell> Cells;
+    };
+
+    struct ScatterResult
+    {
+        TerrainPosition Origin;
+        uint32_t SplatRevision = 0;
+        uint32_t HeightRevision = 0;
+        std::vector<Cell> Cells;
+    };
+
+    static ScatterResult Scatter(const TerrainTile& tile, const TerrainGrassSettings& settings);
+
+    void UploadCell(Cell& cell);
+    void UnloadCell(Cell& cell);
+
+    TileGrass& GetTileGrass(const TerrainPosition& origin);
+
+    Shader GrassShader = { 0 };
+    int InstanceAttribLoc = -1;
+    int TimeLoc = -1;
+    int BladeSizeLoc = -1;
+    int BaseColorLoc = -1;
+    int TipColorLoc = -1;
+
+    unsigned int BladeVbo = 0;
+    int BladeVertexCount = 0;
+
+    std::vector<TileGrass> Tiles;
+    std::vector<std::future<ScatterResult>> PendingScatters;
+
+    size_t DrawnCells = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads shared by the background bakes and placement passes.
+// Jobs run in submit order, so queuing a whole grid of tiles never starts more threads than there are cores.
+class TerrainJobQueue
+{
+public:
+    // 0 uses one thread less than the hardware has, leaving a core for the render thread
+    explicit TerrainJobQueue(unsigned int threadCount = 0);
+    ~TerrainJobQueue();
+
+    TerrainJobQueue(const TerrainJobQueue&) = delete;
+    TerrainJobQueue& operator = (const TerrainJobQueue&) = delete;
+
+    static TerrainJobQueue& Get();
+
+    // jobs must own everything they read, nothing a job captures may be touched by the render thread while it runs
+    template<class F>
+    auto Submit(F&& job) -> std::future<decltype(job())>
+    {
+        using Result = decltype(job());
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> future = task->get_future();
+        Push([task]() { (*task)(); });
+
+        return future;
+    }
+
+    size_t GetThreadCount() const { return Workers.size(); }
+
+private:
+    void Push(std::function<void()> job);
+    void Run();
+
+    std::vector<std::thread> Workers;
+    std::deque<std::function<void()>> Jobs;
+    std::mutex Lock;
+    std::condition_variable JobAdded;
+    bool Stopping = false;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "TerrainTile.h"
+#include "raylib.h"
+
+#include <future>
+#include <vector>
+
+// CPU side output of a normal bake, safe to produce on any thread
+struct TerrainNormalBakeResult
+{
+    TerrainPosition Origin = { 0,0 };
+    int Size = 0;
+
+    // RGB8, tile space normals packed as n * 0.5 + 0.5
+    std::vector<uint8_t> Pixels;
+};
+
+// Bakes a per tile normal texture from the heightfield, independent of the mesh LOD
+class TerrainNormalBaker
+{
+public:
+    // texels per heightfield quad
+    int Scale = 2;
+
+    // offline path, bakes and uploads right away
+    void Bake(TerrainTile& tile);
+
+    // async path, the heights are copied so the tile can be rebuilt while the bake runs
+    void QueueBake(const TerrainTile& tile);
+
+    // uploads finished bakes into matching tiles in queue order, call from the render thread
+    size_t Update(std::vector<TerrainTile>& tiles);
+
+    bool IsBusy() const { return !PendingBakes.empty(); }
+
+    static TerrainNormalBakeResult BakeImage(const std::vector<float>& heights, const TerrainInfo& info, int scale);
+    static void Upload(TerrainTile& tile, const TerrainNormalBakeResult& result);
+
+protected:
+    std::vector<std::future<TerrainNormalBakeResult>> PendingBakes;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "TerrainTile.h"
+#include "raylib.h"
+
+#include <vector>
+
+static constexpr int MaxPaletteMaterials = 32;
+
+// per texel, the palette index of the four heaviest layers and their weights, summing to 255
+struct TerrainIndexedSplat
+{
+    int Width = 0;
+    int Height = 0;
+
+    std::vector<Color> Indices;
+    std::vector<Color> Weights;
+};
+
+// Every terrain material in one texture array, so tiles can use any of them without rebinding
+class TerrainMaterialPalette
+{
+public:
+    // every material is resized to this when it is copied into the array
+    int LayerSize = 512;
+
+    // returns the palette index, the existing one if the material is already in, -1 when full
+    int Add(const TerrainMaterial* material);
+    int GetIndex(const TerrainMaterial* material) const;
+    size_t GetCount() const { return Materials.size(); }
+    void Clear();
+
+    // copies the diffuse maps into the array texture, needs a GL context and an explicit Unload
+    bool Build();
+    void Unload();
+
+    unsigned int GetTextureId() const { return TextureId; }
+    // rgba tint per material, in palette order
+    const float* GetTints() const { return Tints.data(); }
+
+    // the RGBA splat and layer list of the tile in indexed form, empty if the tile has no materials
+    TerrainIndexedSplat EncodeTile(const TerrainTile& tile) const;
+
+    // layerWeights holds layerCount bytes per texel, layers with a palette index below 0 are ignored
+    static TerrainIndexedSplat EncodeWeights(const uint8_t* layerWeights, int layerCount, const int* paletteIndices, int width, int height);
+
+protected:
+    std::vector<const TerrainMaterial*> Materials;
+    std::vector<float> Tints;
+
+    unsigned int TextureId = 0;
+    int64_t TextureBytes = 0;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "TerrainTile.h"
+
+#include <stdint.h>
+
+// Small deterministic generator so placement passes give the same result on every machine and thread
+struct TerrainRandom
+{
+    uint64_t State = 0;
+
+    TerrainRandom(uint64_t seed) : State(seed) {}
+
+    // seed from a tile position so each tile scatters the same way no matter the bake order
+    static uint64_t TileSeed(const TerrainPosition& origin, uint64_t salt)
+    {
+        uint64_t seed = salt;
+        seed ^= uint64_t(origin.X) * 0x9E3779B97F4A7C15ull;
+        seed ^= uint64_t(origin.Y) * 0xC2B2AE3D27D4EB4Full;
+        return Mix(seed);
+    }
+
+    static uint64_t Mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // splitmix64
+    uint64_t Next()
+    {
+        State += 0x9E3779B97F4A7C15ull;
+        return Mix(State);
+    }
+
+    // [0, 1)
+    float NextFloat()
+    {
+        return float(Next() >> 40) / float(1ull << 24);
+    }
+
+    float NextFloat(float min, float max)
+    {
+        return min + (max - min) * NextFloat();
+    }
+
+    uint32_t NextIndex(uint32_t count)
+    {
+        return uint32_t(Next() % count);
+    }
+};
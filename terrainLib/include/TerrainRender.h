@@ -3,30 +3,110 @@
 #include "raylib.h"
 
 #include "TerrainTile.h"
+#include "TerrainPalette.h"
 
+#include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+
+enum TerrainDrawFlags : uint32_t
+{
+    TerrainDrawNone = 0x00,
+    TerrainDrawShowSplat = 0x01,
+    TerrainDrawSelected = 0x02,
+    // one fetch of the tile's composited albedo instead of the splat and layers, ignored until the tile has one
+    TerrainDrawFarAlbedo = 0x04,
+};
 
 class TerainRenderer
 {
 protected:
-    Shader TerrainShader = { 0 };
+    struct ShaderPermutation
+    {
+        Shader TerrainShader = { 0 };
+
+        int MaterialTextureLocs[5] = { -1, -1, -1, -1, -1 };
+        int MaterialTintLocs[5] = { -1, -1, -1, -1, -1 };
+
+        int MaterialCountLoc = -1;
+
+        int SplatmapLoc = -1;
+
+        int IndexedSplatLoc = -1;
+        int MaterialArrayLoc = -1;
+        int PaletteTintLoc = -1;
+        int SplatIndexLoc = -1;
+        int SplatWeightLoc = -1;
+
+        int FarAlbedoLoc = -1;
+        int AlbedoMapLoc = -1;
+
+        int NormalMapLoc = -1;
+        int NormalMapTransformLoc = -1;
+        int UseNormalMapLoc = -1;
+
+        int SelectedLoc = -1;
+        int SelectedColorLoc = -1;
+        int ShowSplatLoc = -1;
+        int SunVectorLoc = -1;
+
+        void SetShader(Shader& shader);
+    };
 
-    std::vector<int> MaterialTextureLocs;
-    std::vector<int> MaterialTintLocs;
+    // used when no shader source is loaded
+    ShaderPermutation DefaultShader;
 
-    int MaterialCountLoc = -1;
+    std::string VertexSource;
+    std::string FragmentSource;
 
-    int SplatmapLoc = -1;
+    // keyed by layer mask, draw flags and feature bits
+    std::unordered_map<uint32_t, ShaderPermutation> Permutations;
+
+    // keys that did not compile, retried once the source is reloaded
+    std::unordered_set<uint32_t> FailedPermutations;
+
+    ShaderPermutation& GetPermutation(uint32_t layerMask, uint32_t flags, bool normalMap, bool indexed);
+    static uint32_t GetPermutationKey(uint32_t layerMask, uint32_t flags, bool normalMap, bool indexed);
+
+    // what Draw ends up binding for a tile drawn with the given flags
+    struct TileDrawState
+    {
+        uint32_t Flags = 0;
+        uint32_t LayerMask = 0;
+        int MaterialCount = 0;
+        bool NormalMap = false;
+        bool Indexed = false;
+        bool FarAlbedo = false;
+    };
+
+    TileDrawState GetDrawState(const TerrainTile& tile, uint32_t flags) const;
+
+    const TerrainMaterialPalette* Palette = nullptr;
 
 public:
     std::unordered_map<size_t, TerrainMaterial> MaterialLibrary;
 
     // materials?
 
+    float SunVector[3] = { 0,0,1 };
+    Color SelectedColor = { 255, 255, 0, 255 };
+
     TerainRenderer();
 
     void SetShader(Shader& shader);
 
-    void Draw(TerrainTile& tile, size_t lod = 0);
-};
\ No newline at end of file
+    // tiles with an indexed splat draw from the palette array instead of their layer list, nullptr turns it off
+    void SetPalette(const TerrainMaterialPalette* palette) { Palette = palette; }
+
+    // loads the terrain shader text, variants are compiled on first use
+    bool LoadShaderSource(const char* vsFileName, const char* fsFileName);
+    void UnloadPermutations();
+    size_t GetPermutationCount() const { return Permutations.size(); }
+
+    // tiles with equal keys share a shader permutation and material textures when drawn with these flags,
+    // so drawing them together avoids state changes
+    uint64_t GetBatchKey(const TerrainTile& tile, uint32_t flags = TerrainDrawNone) const;
+
+    void Draw(TerrainTile& tile, size_t lod = 0, uint32_t flags = TerrainDrawNone);
+};
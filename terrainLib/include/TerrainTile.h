@@ -1,6 +1,7 @@
 #pragma once
 
 #include "raylib.h"
+#include "MemoryStats.h"
 
 #include <stdint.h>
 #include <vector>
@@ -34,6 +35,8 @@ struct TerrainInfo
 
 static constexpr uint8_t MaxLODLevels = 4;
 
+struct TerrainIndexedSplat;
+
 struct TerrainLODTriangleInfo
 {
     size_t IndexStart = -1;
@@ -47,24 +50,88 @@ struct TerrainTile
     TerrainPosition Origin = { 0,0 };
 
     std::vector<float> TerrainHeightMap;
+    float MinHeight = 0;
+    float MaxHeight = 0;
+    // changes whenever the heights are replaced or unloaded
+    uint32_t HeightRevision = 0;
+
+    // (grid+1)^2 baked ambient occlusion, written to the vertex colors when present
+    std::vector<uint8_t> VertexOcclusion;
 
     std::vector<const TerrainMaterial*> LayerMaterials;
     Texture Splatmap;
 
+    // CPU copy of the splatmap for placement passes, the revision changes whenever it is replaced
+    std::vector<Color> SplatPixels;
+    int SplatWidth = 0;
+    int SplatHeight = 0;
+    uint32_t SplatRevision = 0;
+
+    // palette indices and weights of the top four layers, 0 until SetIndexedSplat is called
+    Texture SplatIndexMap = { 0 };
+    Texture SplatWeightMap = { 0 };
+
+    // bit 0 base layer, bits 1-4 the splat channels, computed when the splat is set
+    uint8_t ActiveLayerMask = 0x1F;
+
+    // baked from the heightfield, 0 until a bake has been uploaded
+    Texture NormalMap = { 0 };
+
+    // blended albedo of all layers for the far field, and what it was composited from
+    Texture AlbedoMap = { 0 };
+    uint32_t AlbedoSplatRevision = 0;
+    uint32_t AlbedoMaterialRevision = 0;
+
     unsigned int VaoId = -1;
     unsigned int* VboId = nullptr;
 
+    // size of the vertex buffers, what UnloadGeometry gives back to the memory stats
+    int64_t GeometryBytes = 0;
+
+    // the CPU side arrays above, refreshed by UpdateMemoryUsage
+    MemoryStats::TrackedBytes DataBytes{ MemoryStats::Category::TerrainTileData };
+
     const TerrainLODTriangleInfo* LODs = nullptr;
 
     TerrainTile(TerrainInfo& info);
     ~TerrainTile();
 
     void SetHeightsFromImage(Image& image);
+    void SetSplatFromImage(Image& image);
+    void SetIndexedSplat(const TerrainIndexedSplat& splat);
 
     void AddMaterial(const TerrainMaterial* material);
 
     float GetLocalHeight(int x, int y) const;
 
+    // world space box around the heightfield
+    BoundingBox GetBounds() const;
+
+    // bilinear lookups in tile local world units
+    float GetHeightAt(float x, float y) const;
+    float GetSplatWeightAt(float x, float y, int channel) const;
+
     void UnloadGeometry();
     void UnloadSplats();
+    void UnloadNormalMap();
+
+    // call after changing the heights, occlusion, splat copy or layers from outside the tile
+    void UpdateMemoryUsage();
+
+    static uint8_t ComputeActiveLayerMask(const std::vector<Color>& splat);
+
+    // per layer contribution of one splat sample (0-1 rgba), the same chain of mixes the shader does
+    static void ComputeLayerWeights(const float* channels, int layerCount, float* weights);
+};
+
+// The heights and splat of a tile with its own copy of the info, for jobs that run while the tile is edited
+struct TerrainTileSnapshot
+{
+    TerrainInfo Info;
+    TerrainTile Tile;
+
+    TerrainTileSnapshot(const TerrainTile& source);
+
+    TerrainTileSnapshot(const TerrainTileSnapshot&) = delete;
+    TerrainTileSnapshot& operator = (const TerrainTileSnapshot&) = delete;
 };
\ No newline at end of file
@@ -33,4 +33,5 @@ project (baseName)
     includedirs { "./src" }
     includedirs { "./include" }
 
-    include_raylib()
\ No newline at end of file
+    include_raylib()
+    link_to("common")
\ No newline at end of file
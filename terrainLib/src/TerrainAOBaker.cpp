@@ -0,0 +1,174 @@
+#include "TerrainAOBaker.h"
+#include "TerrainBuilder.h"
+#include "TerrainJobs.h"
+#include "Profiler.h"
+
+#include "raymath.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+
+namespace
+{
+    // rows are handed out a few at a time so a slow neighbour lookup on one side does not hold up the bake
+    constexpr int RowsPerJob = 8;
+
+    struct RowWork
+    {
+        std::atomic<int> NextRow = 0;
+        int DoneRows = 0;
+        std::mutex Lock;
+        std::condition_variable Done;
+    };
+
+    // the tile and its 8 neighbours, resolved once so worker threads never call back into the lookup
+    struct NeighbourhoodSampler
+    {
+        const TerrainTile* Tiles[3][3] = { {nullptr} };
+        int Grid = 0;
+
+        NeighbourhoodSampler(const TerrainTile& tile, const TerrainTileLookup& neighbours)
+        {
+            Grid = tile.Info.TerrainGridSize;
+
+            for (int y = -1; y <= 1; y++)
+            {
+                for (int x = -1; x <= 1; x++)
+                {
+                    const TerrainTile* neighbour = nullptr;
+                    if (x == 0 && y == 0)
+                        neighbour = &tile;
+                    else if (neighbours)
+                        neighbour = neighbours(tile.Origin.X + x, tile.Origin.Y + y);
+
+                    if (neighbour && (neighbour->TerrainHeightMap.empty() || neighbour->Info.TerrainGridSize != Grid))
+                        neighbour = nullptr;
+
+                    Tiles[y + 1][x + 1] = neighbour;
+                }
+            }
+        }
+
+        float GetHeight(int x, int y) const
+        {
+            int tx = x < 0 ? -1 : (x > Grid ? 1 : 0);
+            int ty = y < 0 ? -1 : (y > Grid ? 1 : 0);
+
+            const TerrainTile* tile = Tiles[ty + 1][tx + 1];
+            if (tile)
+                return tile->GetLocalHeight(x - tx * Grid, y - ty * Grid);
+
+            // no neighbour, extend our own edge
+            return Tiles[1][1]->GetLocalHeight(std::clamp(x, 0, Grid), std::clamp(y, 0, Grid));
+        }
+
+        float Sample(float fx, float fy) const
+        {
+            int x = int(std::floor(fx));
+            int y = int(std::floor(fy));
+            float tx = fx - x;
+            float ty = fy - y;
+
+            float h0 = Lerp(GetHeight(x, y), GetHeight(x + 1, y), tx);
+            float h1 = Lerp(GetHeight(x, y + 1), GetHeight(x + 1, y + 1), tx);
+            return Lerp(h0, h1, ty);
+        }
+    };
+}
+
+std::vector<uint8_t> TerrainAOBaker::BakeVertexOcclusion(const TerrainTile& tile, const TerrainTileLookup& neighbours) const
+{
+    int grid = tile.Info.TerrainGridSize;
+    int rowSize = grid + 1;
+
+    std::vector<uint8_t> occlusion(size_t(rowSize) * rowSize, 255);
+    if (tile.TerrainHeightMap.empty() || Directions <= 0 || Steps <= 0)
+        return occlusion;
+
+    NeighbourhoodSampler sampler(tile, neighbours);
+
+    float vertexScale = tile.Info.TerrainTileSize / grid;
+    float radius = std::min(Radius, tile.Info.TerrainTileSize);
+
+    std::vector<Vector2> directions(Directions);
+    for (int d = 0; d < Directions; d++)
+    {
+        float angle = (2 * PI * d) / Directions;
+        directions[d] = Vector2{ cosf(angle), sinf(angle) };
+    }
+
+    auto bakeRows = [&](int startRow, int endRow)
+    {
+        PROFILE_SCOPE("TerrainAOBaker::BakeRows");
+
+        for (int y = startRow; y < endRow; y++)
+        {
+            for (int x = 0; x < rowSize; x++)
+            {
+                float origin = sampler.GetHeight(x, y);
+                float total = 0;
+
+                for (const auto& dir : directions)
+                {
+                    float maxTangent = 0;
+                    for (int s = 1; s <= Steps; s++)
+                    {
+                        float distance = (radius * s) / Steps;
+                        float gridDistance = distance / vertexScale;
+
+                        float height = sampler.Sample(x + dir.x * gridDistance, y + dir.y * gridDistance);
+                        maxTangent = std::max(maxTangent, (height - origin) / distance);
+                    }
+
+                    // sin of the horizon angle
+                    total += maxTangent / sqrtf(1 + maxTangent * maxTangent);
+                }
+
+                float visibility = 1.0f - Strength * (total / Directions);
+                occlusion[size_t(y) * rowSize + x] = uint8_t(Clamp(visibility, 0, 1) * 255);
+            }
+        }
+    };
+
+    TerrainJobQueue& queue = TerrainJobQueue::Get();
+    size_t helpers = ThreadCount > 0 ? ThreadCount - 1 : queue.GetThreadCount();
+    helpers = std::min(helpers, size_t(rowSize / RowsPerJob));
+
+    // the calling thread and the queue's workers take rows until none are left. a helper that only starts
+    // after the bake returned finds nothing to take, so it never touches the locals captured here
+    auto work = std::make_shared<RowWork>();
+    auto takeRows = [work, &bakeRows, rowSize]()
+    {
+        int start = 0;
+        while ((start = work->NextRow.fetch_add(RowsPerJob)) < rowSize)
+        {
+            int end = std::min(rowSize, start + RowsPerJob);
+            bakeRows(start, end);
+
+            std::lock_guard<std::mutex> guard(work->Lock);
+            work->DoneRows += end - start;
+            if (work->DoneRows == rowSize)
+                work->Done.notify_all();
+        }
+    };
+
+    for (size_t i = 0; i < helpers; i++)
+        queue.Submit(takeRows);
+
+    takeRows();
+
+    std::unique_lock<std::mutex> guard(work->Lock);
+    work->Done.wait(guard, [&work, rowSize]() { return work->DoneRows == rowSize; });
+
+    return occlusion;
+}
+
+void TerrainAOBaker::Bake(TerrainTile& tile, const TerrainTileLookup& neighbours) const
+{
+    tile.VertexOcclusion = BakeVertexOcclusion(tile, neighbours);
+    tile.UpdateMemoryUsage();
+    TileMeshBuilder::UpdateColors(tile);
+}
@@ -0,0 +1,172 @@
+#include "TerrainAlbedoBaker.h"
+
+#include <algorithm>
+
+size_t TerrainAlbedoBaker::Update(std::vector<TerrainTile>& tiles)
+{
+    size_t baked = 0;
+
+    for (auto& tile : tiles)
+    {
+        if (tile.SplatPixels.empty() || tile.LayerMaterials.empty())
+            continue;
+
+        if (tile.AlbedoMap.id > 0 && tile.AlbedoSplatRevision == tile.SplatRevision && tile.AlbedoMaterialRevision == MaterialRevision)
+            continue;
+
+        int layerCount = std::min(int(tile.LayerMaterials.size()), 5);
+        Color layerColors[5];
+        for (int i = 0; i < layerCount; i++)
+            layerColors[i] = GetLayerColor(tile.LayerMaterials[i]);
+
+        std::vector<Color> pixels = Composite(tile, layerColors, layerCount, Resolution);
+
+        if (tile.AlbedoMap.id > 0 && tile.AlbedoMap.width == Resolution && tile.AlbedoMap.height == Resolution)
+        {
+            UpdateTexture(tile.AlbedoMap, pixels.data());
+        }
+        else
+        {
+            MemoryStats::RemoveTexture(MemoryStats::Category::TerrainTextures, tile.AlbedoMap);
+            if (tile.AlbedoMap.id > 0)
+                UnloadTexture(tile.AlbedoMap);
+
+            Image image = { pixels.data(), Resolution, Resolution, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+            tile.AlbedoMap = LoadTextureFromImage(image);
+            MemoryStats::AddTexture(MemoryStats::Category::TerrainTextures, tile.AlbedoMap);
+            SetTextureFilter(tile.AlbedoMap, TEXTURE_FILTER_BILINEAR);
+            SetTextureWrap(tile.AlbedoMap, TEXTURE_WRAP_CLAMP);
+        }
+
+        tile.AlbedoSplatRevision = tile.SplatRevision;
+        tile.AlbedoMaterialRevision = MaterialRevision;
+        baked++;
+    }
+
+    return baked;
+}
+
+void TerrainAlbedoBaker::InvalidateMaterials()
+{
+    LayerColors.clear();
+    MaterialRevision++;
+}
+
+const Color& TerrainAlbedoBaker::GetLayerColor(const TerrainMaterial* material)
+{
+    auto itr = LayerColors.find(material);
+    if (itr != LayerColors.end())
+        return itr->second;
+
+    Color average = GetAverageColor(*material);
+    Color tinted = { uint8_t(average.r * material->DiffuseColor.r / 255),
+                     uint8_t(average.g * material->DiffuseColor.g / 255),
+                     uint8_t(average.b * material->DiffuseColor.b / 255),
+                     uint8_t(average.a * material->DiffuseColor.a / 255) };
+
+    return LayerColors[material] = tinted;
+}
+
+Color TerrainAlbedoBaker::GetAverageColor(const TerrainMaterial& material)
+{
+    // the editor marks missing maps with -1
+    if (material.DiffuseMap.id == 0 || material.DiffuseMap.id == (unsigned int)-1)
+        return WHITE;
+
+    Image image = LoadImageFromTexture(material.DiffuseMap);
+    if (image.data == nullptr)
+        return WHITE;
+
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    const Color* pixels = (const Color*)image.data;
+    size_t count = size_t(image.width) * image.height;
+
+    uint64_t sum[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < count; i++)
+    {
+        sum[0] += pixels[i].r;
+        sum[1] += pixels[i].g;
+        sum[2] += pixels[i].b;
+        sum[3] += pixels[i].a;
+    }
+
+    UnloadImage(image);
+
+    if (count == 0)
+        return WHITE;
+
+    return Color{ uint8_t(sum[0] / count), uint8_t(sum[1] / count), uint8_t(sum[2] / count), uint8_t(sum[3] / count) };
+}
+
+std::vector<Color> TerrainAlbedoBaker::Composite(const TerrainTile& tile, const Color* layerColors, int layerCount, int resolution)
+{
+    std::vector<Color> pixels(size_t(resolution) * resolution, WHITE);
+    if (tile.SplatPixels.empty() || layerCount <= 0)
+        return pixels;
+
+    int width = tile.SplatWidth;
+    int height = tile.SplatHeight;
+
+    auto texel = [&](int x, int y, float* channels)
+    {
+        const Color& c = tile.SplatPixels[size_t(y) * width + x];
+        channels[0] = c.r / 255.0f;
+        channels[1] = c.g / 255.0f;
+        channels[2] = c.b / 255.0f;
+        channels[3] = c.a / 255.0f;
+    };
+
+    for (int y = 0; y < resolution; y++)
+    {
+        for (int x = 0; x < resolution; x++)
+        {
+            // the albedo is sampled with the same UVs as the splat, so the texel centers line up in UV space
+            float u = (x + 0.5f) / resolution;
+            float v = (y + 0.5f) / resolution;
+
+            float fx = std::clamp(u * width - 0.5f, 0.0f, float(width - 1));
+            float fy = std::clamp(v * height - 0.5f, 0.0f, float(height - 1));
+
+            int ix = int(fx);
+            int iy = int(fy);
+            int ix2 = std::min(ix + 1, width - 1);
+            int iy2 = std::min(iy + 1, height - 1);
+            float tx = fx - ix;
+            float ty = fy - iy;
+
+            float c00[4], c10[4], c01[4], c11[4];
+            texel(ix, iy, c00);
+            texel(ix2, iy, c10);
+            texel(ix, iy2, c01);
+            texel(ix2, iy2, c11);
+
+            float channels[4];
+            for (int c = 0; c < 4; c++)
+            {
+                float top = c00[c] + (c10[c] - c00[c]) * tx;
+                float bottom = c01[c] + (c11[c] - c01[c]) * tx;
+                channels[c] = top + (bottom - top) * ty;
+            }
+
+            float weights[5];
+            TerrainTile::ComputeLayerWeights(channels, layerCount, weights);
+
+            float color[4] = { 0, 0, 0, 0 };
+            for (int i = 0; i < layerCount; i++)
+            {
+                color[0] += layerColors[i].r * weights[i];
+                color[1] += layerColors[i].g * weights[i];
+                color[2] += layerColors[i].b * weights[i];
+                color[3] += layerColors[i].a * weights[i];
+            }
+
+            pixels[size_t(y) * resolution + x] = Color{ uint8_t(std::min(color[0] + 0.5f, 255.0f)),
+                                                        uint8_t(std::min(color[1] + 0.5f, 255.0f)),
+                                                        uint8_t(std::min(color[2] + 0.5f, 255.0f)),
+                                                        uint8_t(std::min(color[3] + 0.5f, 255.0f)) };
+        }
+    }
+
+    return pixels;
+}
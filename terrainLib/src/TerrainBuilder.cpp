@@ -1,10 +1,14 @@
 #include "TerrainBuilder.h"
+#include "Profiler.h"
 
 #include "rlgl.h"
 #include "raymath.h"
 #include "external/glad.h"
 #include "config.h"
 
+#include <algorithm>
+#include <cmath>
+
 int IndexList = -1;
 
 TerrainLODTriangleInfo LODInfos[MaxLODLevels];
@@ -70,29 +74,91 @@ void SetupIndexes(TerrainTile& tile)
     if (IndexList >= 0)
         return;
 
-    uint32_t triangleCount = uint32_t(tile.Info.TerrainGridSize) * uint32_t(tile.Info.TerrainGridSize) * 2;
-    uint16_t* indexes = (uint16_t*)MemAlloc(sizeof(uint16_t) * (triangleCount + triangleCount / 2 + triangleCount / 4) * 3);
+    std::vector<uint16_t> indexes = TileMeshBuilder::BuildIndexList(tile.Info.TerrainGridSize, LODInfos);
+
+    IndexList = rlLoadVertexBufferElement(indexes.data(), (int)(indexes.size() * sizeof(unsigned short)), false);
+    MemoryStats::Add(MemoryStats::Category::TerrainGeometry, int64_t(indexes.size() * sizeof(unsigned short)));
+}
+
+std::vector<uint16_t> TileMeshBuilder::BuildIndexList(int gridSize, TerrainLODTriangleInfo* lodInfos)
+{
+    uint32_t triangleCount = uint32_t(gridSize) * uint32_t(gridSize) * 2;
+    std::vector<uint16_t> indexes(size_t(triangleCount + triangleCount / 2 + triangleCount / 4) * 3);
 
     size_t triangleIndex = 0;
-    LODInfos[0].IndexStart = 0;
-    BuildLODIndexList(indexes, triangleIndex, tile.Info.TerrainGridSize, 1);
-    LODInfos[0].IndexCount = triangleIndex - LODInfos[0].IndexStart;
+    for (int lod = 0; lod < MaxLODLevels; lod++)
+    {
+        lodInfos[lod].IndexStart = triangleIndex;
+        BuildLODIndexList(indexes.data(), triangleIndex, gridSize, 1 << lod);
+        lodInfos[lod].IndexCount = triangleIndex - lodInfos[lod].IndexStart;
+    }
+
+    indexes.resize(triangleIndex * 3);
+    return indexes;
+}
+
+void TileMeshBuilder::ComputeLODErrors(const TerrainTile& tile, float* errors)
+{
+    int grid = tile.Info.TerrainGridSize;
 
-    LODInfos[1].IndexStart = triangleIndex;
-    BuildLODIndexList(indexes, triangleIndex, tile.Info.TerrainGridSize, 2);
-    LODInfos[1].IndexCount = triangleIndex - LODInfos[1].IndexStart;
+    for (int lod = 0; lod < MaxLODLevels; lod++)
+    {
+        errors[lod] = 0;
+
+        int offset = 1 << lod;
+        if (lod == 0 || tile.TerrainHeightMap.empty())
+            continue;
+
+        int cells = (grid + offset - 1) / offset;
+
+        for (int y = 0; y <= grid; y++)
+        {
+            for (int x = 0; x <= grid; x++)
+            {
+                int cellX = std::min(x / offset, cells - 1);
+                int cellY = std::min(y / offset, cells - 1);
 
-    LODInfos[2].IndexStart = triangleIndex;
-    BuildLODIndexList(indexes, triangleIndex, tile.Info.TerrainGridSize, 4);
-    LODInfos[2].IndexCount = triangleIndex - LODInfos[2].IndexStart;
+                int x1 = cellX * offset;
+                int y1 = cellY * offset;
+                int x2 = x1 + offset;
+                int y2 = y1 + offset;
 
-    LODInfos[3].IndexStart = triangleIndex;
-    BuildLODIndexList(indexes, triangleIndex, tile.Info.TerrainGridSize, 8);
-    LODInfos[3].IndexCount = triangleIndex - LODInfos[3].IndexStart;
+                float u = float(x - x1) / offset;
+                float v = float(y - y1) / offset;
 
-    IndexList = rlLoadVertexBufferElement(indexes, (int)(triangleIndex * 3 * sizeof(unsigned short)), false);
+                float p = tile.GetLocalHeight(x1, y1);
+                float a = tile.GetLocalHeight(x2, y1);
+                float b = tile.GetLocalHeight(x1, y2);
+                float c = tile.GetLocalHeight(x2, y2);
 
-    MemFree(indexes);
+                // the same alternating diagonals as BuildLODIndexList
+                bool flip = ((cellY * (cells + 1) + cellX) & 1) != 0;
+
+                float z = 0;
+                if (flip)
+                    z = (u >= v) ? p + (a - p) * (u - v) + (c - p) * v : p + (c - p) * u + (b - p) * (v - u);
+                else
+                    z = (u + v <= 1) ? p + (a - p) * u + (b - p) * v : c + (b - c) * (1 - u) + (a - c) * (1 - v);
+
+                errors[lod] = std::max(errors[lod], fabsf(z - tile.GetLocalHeight(x, y)));
+            }
+        }
+    }
+}
+
+void FillVertexColors(const TerrainTile& tile, uint8_t* colors, uint32_t vertCount)
+{
+    bool hasOcclusion = tile.VertexOcclusion.size() == vertCount;
+
+    for (uint32_t i = 0; i < vertCount; i++)
+    {
+        uint8_t value = hasOcclusion ? tile.VertexOcclusion[i] : 255;
+
+        colors[(i * 4) + 0] = value;
+        colors[(i * 4) + 1] = value;
+        colors[(i * 4) + 2] = value;
+        colors[(i * 4) + 3] = 255;
+    }
 }
 
 std::vector<Vector3> TileMeshBuilder::GetSiblingNormals(TerrainTile& tile, int16_t h, int16_t v)
@@ -143,8 +209,11 @@ Vector3 TileMeshBuilder::ComputeNormalForLocation(TerrainTile& tile, int16_t h,
 
 void TileMeshBuilder::Build(TerrainTile& tile)
 {
+    PROFILE_SCOPE("TileMeshBuilder::Build");
+
     // upload the buffers
     tile.VboId = (unsigned int*)MemAlloc(MAX_MESH_VERTEX_BUFFERS * sizeof(unsigned int));
+    MemoryStats::Add(MemoryStats::Category::RaylibHeap, MAX_MESH_VERTEX_BUFFERS * sizeof(unsigned int));
 
     tile.VaoId = 0;        // Vertex Array Object
     tile.VboId[0] = 0;     // Vertex buffer: positions
@@ -168,6 +237,10 @@ void TileMeshBuilder::Build(TerrainTile& tile)
 
     uint8_t* colors = (uint8_t*)MemAlloc(vertCount * 4);
 
+    // positions, normals, both uv sets and colors, alive until the upload is done
+    int64_t scratchBytes = int64_t(vertCount) * ((3 + 3 + 2 + 2) * sizeof(float) + 4);
+    MemoryStats::Add(MemoryStats::Category::RaylibHeap, scratchBytes);
+
     float vertexScale = tile.Info.TerrainTileSize / tile.Info.TerrainGridSize;
     float uv2Scale = tile.Info.TerrainTileSize / (tile.Info.TerrainGridSize * 4);
 
@@ -194,15 +267,12 @@ void TileMeshBuilder::Build(TerrainTile& tile)
             textureCord2s[(vertIndex * 2) + 0] = x * uv2Scale;
             textureCord2s[(vertIndex * 2) + 1] = y * uv2Scale;
 
-            colors[(vertIndex * 4) + 0] = 255;
-            colors[(vertIndex * 4) + 1] = 255;
-            colors[(vertIndex * 4) + 2] = 255;
-            colors[(vertIndex * 4) + 3] = 255;
-
             vertIndex++;
         }
     }
 
+    FillVertexColors(tile, colors, vertCount);
+
     tile.VaoId = rlLoadVertexArray();
     rlEnableVertexArray(tile.VaoId);
 
@@ -247,9 +317,30 @@ void TileMeshBuilder::Build(TerrainTile& tile)
 
     rlDisableVertexArray();
 
+    tile.GeometryBytes = scratchBytes;
+    MemoryStats::Add(MemoryStats::Category::TerrainGeometry, tile.GeometryBytes);
+
+    MemoryStats::Remove(MemoryStats::Category::RaylibHeap, scratchBytes);
     MemFree(colors);
     MemFree(textureCord2s);
     MemFree(textureCords);
     MemFree(normals);
     MemFree(verts);
-}
\ No newline at end of file
+}
+
+void TileMeshBuilder::UpdateColors(TerrainTile& tile)
+{
+    if (tile.VboId == nullptr || tile.VboId[3] == 0)
+        return;
+
+    uint32_t vertCount = uint32_t(tile.Info.TerrainGridSize + 1) * uint32_t(tile.Info.TerrainGridSize + 1);
+
+    uint8_t* colors = (uint8_t*)MemAlloc(vertCount * 4);
+    MemoryStats::Add(MemoryStats::Category::RaylibHeap, vertCount * 4);
+    FillVertexColors(tile, colors, vertCount);
+
+    rlUpdateVertexBuffer(tile.VboId[3], colors, vertCount * 4, 0);
+
+    MemoryStats::Remove(MemoryStats::Category::RaylibHeap, vertCount * 4);
+    MemFree(colors);
+}
@@ -0,0 +1,225 @@
+#include "TerrainCulling.h"
+
+#include "rlgl.h"
+#include "raymath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    Vector4 TransformPoint(const Matrix& m, float x, float y, float z)
+    {
+        return Vector4{ m.m0 * x + m.m4 * y + m.m8 * z + m.m12,
+                        m.m1 * x + m.m5 * y + m.m9 * z + m.m13,
+                        m.m2 * x + m.m6 * y + m.m10 * z + m.m14,
+                        m.m3 * x + m.m7 * y + m.m11 * z + m.m15 };
+    }
+
+    bool InFrontOfNear(const Vector4& clip)
+    {
+        return clip.z >= -clip.w && clip.w > 0;
+    }
+}
+
+void TerrainFrustum::Extract(const Matrix& m)
+{
+    // rows of the clip matrix, raylib stores columns in m0..m3
+    Vector4 row0 = { m.m0, m.m4, m.m8, m.m12 };
+    Vector4 row1 = { m.m1, m.m5, m.m9, m.m13 };
+    Vector4 row2 = { m.m2, m.m6, m.m10, m.m14 };
+    Vector4 row3 = { m.m3, m.m7, m.m11, m.m15 };
+
+    auto combine = [](const Vector4& a, const Vector4& b, float sign)
+    {
+        Vector4 plane = { a.x + b.x * sign, a.y + b.y * sign, a.z + b.z * sign, a.w + b.w * sign };
+        float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0)
+        {
+            plane.x /= length;
+            plane.y /= length;
+            plane.z /= length;
+            plane.w /= length;
+        }
+        return plane;
+    };
+
+    Planes[0] = combine(row3, row0, 1);
+    Planes[1] = combine(row3, row0, -1);
+    Planes[2] = combine(row3, row1, 1);
+    Planes[3] = combine(row3, row1, -1);
+    Planes[4] = combine(row3, row2, 1);
+    Planes[5] = combine(row3, row2, -1);
+}
+
+void TerrainFrustum::ExtractFromCurrent()
+{
+    Extract(MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+}
+
+bool TerrainFrustum::IsBoxVisible(const BoundingBox& box) const
+{
+    for (const auto& plane : Planes)
+    {
+        // the corner furthest along the plane normal
+        float x = plane.x >= 0 ? box.max.x : box.min.x;
+        float y = plane.y >= 0 ? box.max.y : box.min.y;
+        float z = plane.z >= 0 ? box.max.z : box.min.z;
+
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0)
+            return false;
+    }
+
+    return true;
+}
+
+void TerrainHorizonCuller::Begin(const Matrix& viewProjection)
+{
+    ViewProjection = viewProjection;
+
+    // below the bottom of the screen, nothing is hidden yet
+    Horizon.assign(std::max(Resolution, 1), -2.0f);
+
+    OccludedCount = 0;
+    ProcessedCount = 0;
+}
+
+void TerrainHorizonCuller::BeginFromCurrent()
+{
+    Begin(MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+}
+
+bool TerrainHorizonCuller::IsOccluded(const BoundingBox& bounds) const
+{
+    if (Horizon.empty())
+        return false;
+
+    float minX = 2;
+    float maxX = -2;
+    float maxY = -2;
+
+    for (int i = 0; i < 8; i++)
+    {
+        Vector4 clip = TransformPoint(ViewProjection,
+            (i & 1) ? bounds.max.x : bounds.min.x,
+            (i & 2) ? bounds.max.y : bounds.min.y,
+            (i & 4) ? bounds.max.z : bounds.min.z);
+
+        // crosses the near plane, the projection can't be trusted
+        if (!InFrontOfNear(clip))
+            return false;
+
+        float x = clip.x / clip.w;
+        float y = clip.y / clip.w;
+
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+
+    // off to the side is the frustum's job
+    if (maxX < -1 || minX > 1)
+        return false;
+
+    int columns = int(Horizon.size());
+    int first = std::clamp(int(floorf((minX + 1) * 0.5f * columns)), 0, columns - 1);
+    int last = std::clamp(int(floorf((maxX + 1) * 0.5f * columns)), 0, columns - 1);
+
+    for (int c = first; c <= last; c++)
+    {
+        if (maxY >= Horizon[c])
+            return false;
+    }
+
+    return true;
+}
+
+void TerrainHorizonCuller::AddOccluder(const BoundingBox& bounds)
+{
+    if (Horizon.empty())
+        return;
+
+    // the terrain is solid under its lowest point, so the footprint at min z hides everything behind and below it
+    float z = bounds.min.z;
+    Vector4 corners[4] = { TransformPoint(ViewProjection, bounds.min.x, bounds.min.y, z),
+                           TransformPoint(ViewProjection, bounds.max.x, bounds.min.y, z),
+                           TransformPoint(ViewProjection, bounds.max.x, bounds.max.y, z),
+                           TransformPoint(ViewProjection, bounds.min.x, bounds.max.y, z) };
+
+    // clip against the near plane, a quad gains at most one vertex
+    Vector2 polygon[5];
+    int count = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        const Vector4& a = corners[i];
+        const Vector4& b = corners[(i + 1) % 4];
+
+        float da = a.z + a.w;
+        float db = b.z + b.w;
+
+        if (da >= 0 && a.w > 0)
+            polygon[count++] = Vector2{ a.x / a.w, a.y / a.w };
+
+        if ((da >= 0) != (db >= 0))
+        {
+            float t = da / (da - db);
+            Vector4 p = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+            if (p.w > 0 && count < 5)
+                polygon[count++] = Vector2{ p.x / p.w, p.y / p.w };
+        }
+    }
+
+    if (count < 3)
+        return;
+
+    float minX = polygon[0].x;
+    float maxX = polygon[0].x;
+    for (int i = 1; i < count; i++)
+    {
+        minX = std::min(minX, polygon[i].x);
+        maxX = std::max(maxX, polygon[i].x);
+    }
+
+    // top edge of the projected footprint at x
+    auto upperAt = [&](float x)
+    {
+        float top = -2;
+        for (int i = 0; i < count; i++)
+        {
+            const Vector2& a = polygon[i];
+            const Vector2& b = polygon[(i + 1) % count];
+            if (x < std::min(a.x, b.x) || x > std::max(a.x, b.x))
+                continue;
+
+            float y = (b.x == a.x) ? std::max(a.y, b.y) : a.y + (b.y - a.y) * ((x - a.x) / (b.x - a.x));
+            top = std::max(top, y);
+        }
+        return top;
+    };
+
+    // only columns the footprint spans completely, the top edge is concave so its lowest point is at a column edge
+    int columns = int(Horizon.size());
+    float columnWidth = 2.0f / columns;
+    int first = std::max(int(ceilf((minX + 1) / columnWidth)), 0);
+    int last = std::min(int(floorf((maxX + 1) / columnWidth)) - 1, columns - 1);
+
+    for (int c = first; c <= last; c++)
+    {
+        float covered = std::min(upperAt(c * columnWidth - 1), upperAt((c + 1) * columnWidth - 1));
+        Horizon[c] = std::max(Horizon[c], covered);
+    }
+}
+
+bool TerrainHorizonCuller::Process(const BoundingBox& bounds)
+{
+    ProcessedCount++;
+
+    if (IsOccluded(bounds))
+    {
+        OccludedCount++;
+        return false;
+    }
+
+    AddOccluder(bounds);
+    return true;
+}
@@ -0,0 +1,70 @@
+#include "TerrainDrawOrder.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TerrainDrawOrder::Update(const std::vector<BoundingBox>& bounds, const Vector3& viewPos)
+{
+    bool reset = Order.size() != bounds.size();
+
+    Distances.resize(bounds.size());
+    Rings.resize(bounds.size());
+
+    float ringSize = std::max(RingSize, 0.001f);
+
+    for (size_t i = 0; i < bounds.size(); i++)
+    {
+        float dx = std::max({ bounds[i].min.x - viewPos.x, 0.0f, viewPos.x - bounds[i].max.x });
+        float dy = std::max({ bounds[i].min.y - viewPos.y, 0.0f, viewPos.y - bounds[i].max.y });
+
+        Distances[i] = sqrtf(dx * dx + dy * dy);
+        Rings[i] = int(Distances[i] / ringSize);
+    }
+
+    auto nearer = [this](size_t a, size_t b) { return Distances[a] < Distances[b]; };
+
+    if (reset)
+    {
+        Order.resize(bounds.size());
+        for (size_t i = 0; i < Order.size(); i++)
+            Order[i] = i;
+
+        std::sort(Order.begin(), Order.end(), nearer);
+        return;
+    }
+
+    // last frame's order is almost sorted, insertion sort only moves the few tiles that crossed
+    for (size_t i = 1; i < Order.size(); i++)
+    {
+        size_t tile = Order[i];
+        size_t j = i;
+        while (j > 0 && nearer(tile, Order[j - 1]))
+        {
+            Order[j] = Order[j - 1];
+            j--;
+        }
+        Order[j] = tile;
+    }
+}
+
+void TerrainDrawOrder::SortBatches(std::vector<size_t>& tiles, const std::vector<uint64_t>& batchKeys) const
+{
+    // batches are numbered by their nearest tile overall, giving every ring the same batch order
+    std::vector<uint64_t> seen;
+    BatchIndices.resize(batchKeys.size());
+    for (size_t tile : tiles)
+    {
+        auto itr = std::find(seen.begin(), seen.end(), batchKeys[tile]);
+        BatchIndices[tile] = uint32_t(itr - seen.begin());
+        if (itr == seen.end())
+            seen.push_back(batchKeys[tile]);
+    }
+
+    // stable, so each batch keeps the front to back order it came in with
+    std::stable_sort(tiles.begin(), tiles.end(), [this](size_t a, size_t b)
+        {
+            if (Rings[a] != Rings[b])
+                return Rings[a] < Rings[b];
+            return BatchIndices[a] < BatchIndices[b];
+        });
+}
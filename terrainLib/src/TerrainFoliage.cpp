@@ -0,0 +1,425 @@
+#include "TerrainFoliage.h"
+#include "TerrainJobs.h"
+#include "TerrainCulling.h"
+#include "TerrainRandom.h"
+#include "Profiler.h"
+
+#include "rlgl.h"
+#include "raymath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int PoissonAttempts = 20;
+
+    // Bridson's poisson disk sampling over a square
+    std::vector<Vector2> PoissonDisk(float size, float radius, TerrainRandom& random)
+    {
+        std::vector<Vector2> points;
+        if (radius <= 0 || size <= 0)
+            return points;
+
+        float cellSize = radius / sqrtf(2);
+        int gridSize = int(ceilf(size / cellSize));
+        std::vector<int> grid(size_t(gridSize) * gridSize, -1);
+
+        auto gridIndex = [&](const Vector2& p)
+        {
+            int gx = std::min(int(p.x / cellSize), gridSize - 1);
+            int gy = std::min(int(p.y / cellSize), gridSize - 1);
+            return size_t(gy) * gridSize + gx;
+        };
+
+        auto isFree = [&](const Vector2& p)
+        {
+            int gx = int(p.x / cellSize);
+            int gy = int(p.y / cellSize);
+            for (int y = std::max(0, gy - 2); y <= std::min(gridSize - 1, gy + 2); y++)
+            {
+                for (int x = std::max(0, gx - 2); x <= std::min(gridSize - 1, gx + 2); x++)
+                {
+                    int index = grid[size_t(y) * gridSize + x];
+                    if (index < 0)
+                        continue;
+
+                    float dx = points[index].x - p.x;
+                    float dy = points[index].y - p.y;
+                    if (dx * dx + dy * dy < radius * radius)
+                        return false;
+                }
+            }
+            return true;
+        };
+
+        std::vector<int> active;
+
+        Vector2 first = { random.NextFloat() * size, random.NextFloat() * size };
+        points.push_back(first);
+        grid[gridIndex(first)] = 0;
+        active.push_back(0);
+
+        while (!active.empty())
+        {
+            uint32_t activeIndex = random.NextIndex(uint32_t(active.size()));
+            Vector2 center = points[active[activeIndex]];
+
+            bool found = false;
+            for (int i = 0; i < PoissonAttempts; i++)
+            {
+                float angle = random.NextFloat() * 2 * PI;
+                float distance = radius * (1 + random.NextFloat());
+                Vector2 candidate = { center.x + cosf(angle) * distance, center.y + sinf(angle) * distance };
+
+                if (candidate.x < 0 || candidate.y < 0 || candidate.x >= size || candidate.y >= size || !isFree(candidate))
+                    continue;
+
+                grid[gridIndex(candidate)] = int(points.size());
+                active.push_back(int(points.size()));
+                points.push_back(candidate);
+                found = true;
+                break;
+            }
+
+            if (!found)
+            {
+                active[activeIndex] = active.back();
+                active.pop_back();
+            }
+        }
+
+        return points;
+    }
+
+    float GetSlope(const TerrainTile& tile, float x, float y)
+    {
+        float step = tile.Info.TerrainTileSize / tile.Info.TerrainGridSize;
+
+        float dzdx = (tile.GetHeightAt(x + step, y) - tile.GetHeightAt(x - step, y)) / (2 * step);
+        float dzdy = (tile.GetHeightAt(x, y + step) - tile.GetHeightAt(x, y - step)) / (2 * step);
+
+        return 1.0f - 1.0f / sqrtf(1 + dzdx * dzdx + dzdy * dzdy);
+    }
+
+    float GetTypeScale(const TerrainFoliageType& type, uint8_t seed)
+    {
+        return type.MinScale + (type.MaxScale - type.MinScale) * ((seed & 0x0F) / 15.0f);
+    }
+
+    // from the nearest point of the box, zero inside it
+    float GetDistanceSqr(const BoundingBox& box, const Vector3& point)
+    {
+        Vector3 nearest = { std::clamp(point.x, box.min.x, box.max.x), std::clamp(point.y, box.min.y, box.max.y), std::clamp(point.z, box.min.z, box.max.z) };
+        return Vector3DistanceSqr(nearest, point);
+    }
+}
+
+TerrainFoliageSystem::~TerrainFoliageSystem()
+{
+    PendingPlacements.clear();
+}
+
+TerrainFoliageSystem::TileFoliage TerrainFoliageSystem::Place(const TerrainTile& tile, const std::vector<TerrainFoliageType>& types, uint64_t seed, int cellsPerTile)
+{
+    PROFILE_SCOPE("TerrainFoliageSystem::Place");
+
+    TileFoliage result;
+    result.Origin = tile.Origin;
+    result.SplatRevision = tile.SplatRevision;
+    result.HeightRevision = tile.HeightRevision;
+    result.MinZ = tile.MinHeight;
+    result.RangeZ = std::max(tile.MaxHeight - tile.MinHeight, 0.001f);
+
+    float tallest = 0;
+    for (const auto& type : types)
+        tallest = std::max(tallest, type.Height * type.MaxScale);
+
+    result.Bounds = tile.GetBounds();
+    result.Bounds.max.z += tallest;
+
+    float tileSize = tile.Info.TerrainTileSize;
+
+    for (size_t typeIndex = 0; typeIndex < types.size() && typeIndex < 256; typeIndex++)
+    {
+        const auto& type = types[typeIndex];
+
+        TerrainRandom random(TerrainRandom::TileSeed(tile.Origin, seed + typeIndex));
+
+        for (const auto& point : PoissonDisk(tileSize, type.Spacing, random))
+        {
+            float weight = tile.GetSplatWeightAt(point.x, point.y, type.SplatChannel);
+            float keep = random.NextFloat();
+            uint8_t instanceSeed = uint8_t(random.Next());
+
+            if (weight < type.MinWeight || keep >= weight)
+                continue;
+
+            if (GetSlope(tile, point.x, point.y) > type.MaxSlope)
+                continue;
+
+            float z = tile.GetHeightAt(point.x, point.y);
+
+            TerrainFoliageInstance instance;
+            instance.X = uint16_t(std::clamp(point.x / tileSize, 0.0f, 1.0f) * 65535);
+            instance.Y = uint16_t(std::clamp(point.y / tileSize, 0.0f, 1.0f) * 65535);
+            instance.Z = uint16_t(std::clamp((z - result.MinZ) / result.RangeZ, 0.0f, 1.0f) * 65535);
+            instance.Type = uint8_t(typeIndex);
+            instance.Seed = instanceSeed;
+            result.Instances.push_back(instance);
+        }
+    }
+
+    result.Instances.shrink_to_fit();
+
+    // sorted by cell and by type inside each, so a cell hands every type one contiguous range
+    int cells = std::max(1, cellsPerTile);
+    auto getCell = [cells](const TerrainFoliageInstance& instance)
+    {
+        int x = std::min(int(instance.X) * cells / 65536, cells - 1);
+        int y = std::min(int(instance.Y) * cells / 65536, cells - 1);
+        return size_t(y) * cells + x;
+    };
+
+    std::stable_sort(result.Instances.begin(), result.Instances.end(), [&getCell](const TerrainFoliageInstance& a, const TerrainFoliageInstance& b)
+        {
+            size_t cellA = getCell(a);
+            size_t cellB = getCell(b);
+            return cellA != cellB ? cellA < cellB : a.Type < b.Type;
+        });
+
+    float cellSize = tileSize / cells;
+    result.Cells.resize(size_t(cells) * cells);
+
+    size_t index = 0;
+    for (size_t cellIndex = 0; cellIndex < result.Cells.size(); cellIndex++)
+    {
+        Cell& cell = result.Cells[cellIndex];
+        cell.First = index;
+        cell.TypeStarts.assign(std::min(types.size(), size_t(256)) + 1, 0);
+
+        float x = (tile.Origin.X * cells + float(cellIndex % cells)) * cellSize;
+        float y = (tile.Origin.Y * cells + float(cellIndex / cells)) * cellSize;
+        cell.Bounds = BoundingBox{ Vector3{ x, y, result.Bounds.max.z }, Vector3{ x + cellSize, y + cellSize, result.Bounds.min.z } };
+
+        for (; index < result.Instances.size() && getCell(result.Instances[index]) == cellIndex; index++)
+        {
+            const auto& instance = result.Instances[index];
+            cell.TypeStarts[instance.Type + 1]++;
+
+            float z = result.MinZ + (instance.Z / 65535.0f) * result.RangeZ;
+            cell.Bounds.min.z = std::min(cell.Bounds.min.z, z);
+            cell.Bounds.max.z = std::max(cell.Bounds.max.z, z + types[instance.Type].Height * GetTypeScale(types[instance.Type], instance.Seed));
+        }
+
+        for (size_t type = 1; type < cell.TypeStarts.size(); type++)
+            cell.TypeStarts[type] += cell.TypeStarts[type - 1];
+    }
+
+    return result;
+}
+
+TerrainFoliageSystem::TileFoliage& TerrainFoliageSystem::GetTileFoliage(const TerrainPosition& origin)
+{
+    for (auto& tileFoliage : Tiles)
+    {
+        if (tileFoliage.Origin == origin)
+            return tileFoliage;
+    }
+
+    auto& tileFoliage = Tiles.emplace_back();
+    tileFoliage.Origin = origin;
+    return tileFoliage;
+}
+
+void TerrainFoliageSystem::Update(const std::vector<TerrainTile>& tiles)
+{
+    for (size_t i = 0; i < PendingPlacements.size();)
+    {
+        if (PendingPlacements[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            i++;
+            continue;
+        }
+
+        TileFoliage result = PendingPlacements[i].get();
+        PendingPlacements.erase(PendingPlacements.begin() + i);
+
+        GetTileFoliage(result.Origin) = std::move(result);
+    }
+
+    for (const auto& tile : tiles)
+    {
+        TileSize = tile.Info.TerrainTileSize;
+
+        auto& tileFoliage = GetTileFoliage(tile.Origin);
+        if (tileFoliage.Pending || (tileFoliage.SplatRevision == tile.SplatRevision && tileFoliage.HeightRevision == tile.HeightRevision))
+            continue;
+
+        if (tile.SplatPixels.empty() || tile.TerrainHeightMap.empty())
+        {
+            tileFoliage.Instances.clear();
+            tileFoliage.Cells.clear();
+            tileFoliage.SplatRevision = tile.SplatRevision;
+            tileFoliage.HeightRevision = tile.HeightRevision;
+            continue;
+        }
+
+        tileFoliage.Pending = true;
+
+        PendingPlacements.push_back(TerrainJobQueue::Get().Submit(
+            [snapshot = std::make_shared<const TerrainTileSnapshot>(tile), types = Types, seed = Seed, cellsPerTile = CellsPerTile]()
+            {
+                return Place(snapshot->Tile, types, seed, cellsPerTile);
+            }));
+    }
+
+    // tiles that went away take their instances with them
+    for (size_t i = 0; i < Tiles.size();)
+    {
+        const TerrainPosition& origin = Tiles[i].Origin;
+        if (std::any_of(tiles.begin(), tiles.end(), [&origin](const TerrainTile& tile) { return tile.Origin == origin; }))
+            i++;
+        else
+            Tiles.erase(Tiles.begin() + i);
+    }
+}
+
+Vector3 TerrainFoliageSystem::GetInstancePosition(const TileFoliage& tile, const TerrainFoliageInstance& instance, float tileSize) const
+{
+    return Vector3{ (tile.Origin.X + instance.X / 65535.0f) * tileSize,
+                    (tile.Origin.Y + instance.Y / 65535.0f) * tileSize,
+                    tile.MinZ + (instance.Z / 65535.0f) * tile.RangeZ };
+}
+
+float TerrainFoliageSystem::GetInstanceScale(const TerrainFoliageInstance& instance) const
+{
+    return GetTypeScale(Types[instance.Type], instance.Seed);
+}
+
+Matrix TerrainFoliageSystem::GetInstanceTransform(const TileFoliage& tile, const TerrainFoliageInstance& instance, float tileSize) const
+{
+    Vector3 pos = GetInstancePosition(tile, instance, tileSize);
+    float scale = GetInstanceScale(instance);
+    float rotation = ((instance.Seed >> 4) / 16.0f) * 2 * PI;
+
+    Matrix transform = MatrixMultiply(Types[instance.Type].MeshTransform, MatrixScale(scale, scale, scale));
+    transform = MatrixMultiply(transform, MatrixRotateZ(rotation));
+    return MatrixMultiply(transform, MatrixTranslate(pos.x, pos.y, pos.z));
+}
+
+void TerrainFoliageSystem::Draw(const Camera3D& camera)
+{
+    DrawnMeshes = 0;
+    DrawnImpostors = 0;
+
+    if (Types.empty() || TileSize <= 0)
+        return;
+
+    TerrainFrustum frustum;
+    frustum.ExtractFromCurrent();
+
+    NearTransforms.resize(Types.size());
+    FarPositions.resize(Types.size());
+    for (size_t i = 0; i < Types.size(); i++)
+    {
+        NearTransforms[i].clear();
+        FarPositions[i].clear();
+    }
+
+    float nearSqr = ImpostorDistance * ImpostorDistance;
+    float maxSqr = MaxDistance * MaxDistance;
+
+    // a little past the impostor distance, so a cell on the edge does not rebuild its transforms every frame
+    float keepSqr = nearSqr * 1.5f;
+
+    for (auto& tileFoliage : Tiles)
+    {
+        bool tileVisible = !tileFoliage.Instances.empty() && frustum.IsBoxVisible(tileFoliage.Bounds);
+
+        for (auto& cell : tileFoliage.Cells)
+        {
+            size_t count = cell.TypeStarts.empty() ? 0 : cell.TypeStarts.back();
+            if (count == 0)
+                continue;
+
+            float distanceSqr = GetDistanceSqr(cell.Bounds, camera.position);
+            if (distanceSqr > keepSqr && !cell.Transforms.empty())
+            {
+                cell.Transforms.clear();
+                cell.Transforms.shrink_to_fit();
+            }
+
+            if (!tileVisible || distanceSqr > maxSqr || !frustum.IsBoxVisible(cell.Bounds))
+                continue;
+
+            size_t typeCount = std::min(Types.size(), cell.TypeStarts.size() - 1);
+            const TerrainFoliageInstance* instances = &tileFoliage.Instances[cell.First];
+
+            if (distanceSqr < nearSqr)
+            {
+                if (cell.Transforms.empty())
+                {
+                    cell.Transforms.reserve(count);
+                    for (size_t i = 0; i < count; i++)
+                        cell.Transforms.push_back(instances[i].Type < Types.size() ? GetInstanceTransform(tileFoliage, instances[i], TileSize) : MatrixIdentity());
+                }
+
+                for (size_t type = 0; type < typeCount; type++)
+                    NearTransforms[type].insert(NearTransforms[type].end(), cell.Transforms.begin() + cell.TypeStarts[type], cell.Transforms.begin() + cell.TypeStarts[type + 1]);
+            }
+            else
+            {
+                for (size_t type = 0; type < typeCount; type++)
+                {
+                    for (size_t i = cell.TypeStarts[type]; i < cell.TypeStarts[type + 1]; i++)
+                    {
+                        Vector3 pos = GetInstancePosition(tileFoliage, instances[i], TileSize);
+                        FarPositions[type].push_back(Vector4{ pos.x, pos.y, pos.z, GetInstanceScale(instances[i]) });
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < Types.size(); i++)
+    {
+        const auto& type = Types[i];
+
+        if (!NearTransforms[i].empty() && type.InstanceMesh.vaoId != 0)
+        {
+            DrawMeshInstanced(type.InstanceMesh, type.InstanceMaterial, NearTransforms[i].data(), int(NearTransforms[i].size()));
+            DrawnMeshes += NearTransforms[i].size();
+        }
+
+        if (FarPositions[i].empty() || type.Impostor.id == 0)
+            continue;
+
+        // every card shares one texture, so rlgl batches them into a few draw calls
+        Rectangle source = { 0, 0, float(type.Impostor.width), float(type.Impostor.height) };
+        for (const auto& card : FarPositions[i])
+        {
+            Vector2 size = { type.ImpostorSize.x * card.w, type.ImpostorSize.y * card.w };
+            Vector3 center = { card.x, card.y, card.z + size.y * 0.5f };
+            DrawBillboardPro(camera, type.Impostor, source, center, Vector3{ 0,0,1 }, size, Vector2{ size.x * 0.5f, size.y * 0.5f }, 0, WHITE);
+        }
+        DrawnImpostors += FarPositions[i].size();
+    }
+
+    rlDrawRenderBatchActive();
+}
+
+void TerrainFoliageSystem::Clear()
+{
+    PendingPlacements.clear();
+    Tiles.clear();
+}
+
+size_t TerrainFoliageSystem::GetInstanceCount() const
+{
+    size_t count = 0;
+    for (const auto& tileFoliage : Tiles)
+        count += tileFoliage.Instances.size();
+
+    return count;
+}
@@ -0,0 +1,317 @@
+#include "TerrainGrass.h"
+#include "TerrainJobs.h"
+#include "TerrainRandom.h"
+#include "Profiler.h"
+
+#include "rlgl.h"
+#include "raymath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // two crossed tapered blades, unit sized, z is up
+    constexpr float BladeVerts[] =
+    {
+        -0.5f, 0, 0,    0.5f, 0, 0,     0.35f, 0, 0.5f,
+        -0.5f, 0, 0,    0.35f, 0, 0.5f, -0.35f, 0, 0.5f,
+        -0.35f, 0, 0.5f, 0.35f, 0, 0.5f, 0, 0, 1,
+
+        0, -0.5f, 0,    0, 0.5f, 0,     0, 0.35f, 0.5f,
+        0, -0.5f, 0,    0, 0.35f, 0.5f, 0, -0.35f, 0.5f,
+        0, -0.35f, 0.5f, 0, 0.35f, 0.5f, 0, 0, 1,
+    };
+
+    void ColorToFloats(Color color, float* values)
+    {
+        values[0] = color.r / 255.0f;
+        values[1] = color.g / 255.0f;
+        values[2] = color.b / 255.0f;
+        values[3] = color.a / 255.0f;
+    }
+}
+
+TerrainGrassSystem::~TerrainGrassSystem()
+{
+    // pending jobs own their inputs, dropping the futures only drops their results
+    PendingScatters.clear();
+}
+
+void TerrainGrassSystem::SetShader(Shader shader)
+{
+    GrassShader = shader;
+
+    InstanceAttribLoc = GetShaderLocationAttrib(shader, "instanceData");
+    TimeLoc = GetShaderLocation(shader, "time");
+    BladeSizeLoc = GetShaderLocation(shader, "bladeSize");
+    BaseColorLoc = GetShaderLocation(shader, "baseColor");
+    TipColorLoc = GetShaderLocation(shader, "tipColor");
+
+    if (BladeVbo == 0)
+    {
+        BladeVertexCount = int(sizeof(BladeVerts) / (sizeof(float) * 3));
+        BladeVbo = rlLoadVertexBuffer(BladeVerts, sizeof(BladeVerts), false);
+        MemoryStats::Add(MemoryStats::Category::Vegetation, sizeof(BladeVerts));
+    }
+}
+
+TerrainGrassSystem::ScatterResult TerrainGrassSystem::Scatter(const TerrainTile& tile, const TerrainGrassSettings& settings)
+{
+    PROFILE_SCOPE("TerrainGrassSystem::Scatter");
+
+    ScatterResult result;
+    result.Origin = tile.Origin;
+    result.SplatRevision = tile.SplatRevision;
+    result.HeightRevision = tile.HeightRevision;
+
+    int cellsPerTile = std::max(1, settings.CellsPerTile);
+    float tileSize = tile.Info.TerrainTileSize;
+    float cellSize = tileSize / cellsPerTile;
+
+    size_t candidates = size_t(settings.Density * cellSize * cellSize);
+
+    result.Cells.resize(size_t(cellsPerTile) * cellsPerTile);
+
+    for (int cy = 0; cy < cellsPerTile; cy++)
+    {
+        for (int cx = 0; cx < cellsPerTile; cx++)
+        {
+            Cell& cell = result.Cells[size_t(cy) * cellsPerTile + cx];
+
+            float localX = cx * cellSize;
+            float localY = cy * cellSize;
+            float worldX = tile.Origin.X * tileSize + localX;
+            float worldY = tile.Origin.Y * tileSize + localY;
+
+            cell.Center = Vector3{ worldX + cellSize * 0.5f, worldY + cellSize * 0.5f, tile.GetHeightAt(localX + cellSize * 0.5f, localY + cellSize * 0.5f) };
+
+            TerrainRandom random(TerrainRandom::TileSeed(tile.Origin, settings.Seed) + uint64_t(cy * cellsPerTile + cx));
+
+            // candidates come out in random order, so the kept list needs no shuffle for ring thinning
+            for (size_t i = 0; i < candidates; i++)
+            {
+                float x = localX + random.NextFloat() * cellSize;
+                float y = localY + random.NextFloat() * cellSize;
+                float keep = random.NextFloat();
+                float seed = random.NextFloat();
+
+                float weight = tile.GetSplatWeightAt(x, y, settings.SplatChannel);
+                if (weight < settings.MinWeight || keep >= weight)
+                    continue;
+
+                cell.Instances.push_back(Vector4{ tile.Origin.X * tileSize + x, tile.Origin.Y * tileSize + y, tile.GetHeightAt(x, y), seed });
+            }
+
+            cell.InstanceCount = cell.Instances.size();
+        }
+    }
+
+    return result;
+}
+
+void TerrainGrassSystem::UploadCell(Cell& cell)
+{
+    if (cell.Instances.empty() || BladeVbo == 0 || InstanceAttribLoc < 0)
+        return;
+
+    cell.VaoId = rlLoadVertexArray();
+    rlEnableVertexArray(cell.VaoId);
+
+    rlEnableVertexBuffer(BladeVbo);
+    rlSetVertexAttribute(0, 3, RL_FLOAT, 0, 0, 0);
+    rlEnableVertexAttribute(0);
+
+    cell.InstanceVbo = rlLoadVertexBuffer(cell.Instances.data(), int(cell.Instances.size() * sizeof(Vector4)), false);
+    MemoryStats::Add(MemoryStats::Category::Vegetation, int64_t(cell.Instances.size() * sizeof(Vector4)));
+    rlSetVertexAttribute(InstanceAttribLoc, 4, RL_FLOAT, 0, 0, 0);
+    rlEnableVertexAttribute(InstanceAttribLoc);
+    rlSetVertexAttributeDivisor(InstanceAttribLoc, 1);
+
+    rlDisableVertexArray();
+
+    cell.Instances.clear();
+    cell.Instances.shrink_to_fit();
+}
+
+void TerrainGrassSystem::UnloadCell(Cell& cell)
+{
+    if (cell.VaoId != 0)
+        rlUnloadVertexArray(cell.VaoId);
+    if (cell.InstanceVbo != 0)
+    {
+        rlUnloadVertexBuffer(cell.InstanceVbo);
+        MemoryStats::Remove(MemoryStats::Category::Vegetation, int64_t(cell.InstanceCount * sizeof(Vector4)));
+    }
+
+    cell.VaoId = 0;
+    cell.InstanceVbo = 0;
+    cell.InstanceCount = 0;
+}
+
+TerrainGrassSystem::TileGrass& TerrainGrassSystem::GetTileGrass(const TerrainPosition& origin)
+{
+    for (auto& tileGrass : Tiles)
+    {
+        if (tileGrass.Origin == origin)
+            return tileGrass;
+    }
+
+    auto& tileGrass = Tiles.emplace_back();
+    tileGrass.Origin = origin;
+    return tileGrass;
+}
+
+void TerrainGrassSystem::Update(const std::vector<TerrainTile>& tiles)
+{
+    for (size_t i = 0; i < PendingScatters.size();)
+    {
+        if (PendingScatters[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            i++;
+            continue;
+        }
+
+        ScatterResult result = PendingScatters[i].get();
+        PendingScatters.erase(PendingScatters.begin() + i);
+
+        auto& tileGrass = GetTileGrass(result.Origin);
+        for (auto& cell : tileGrass.Cells)
+            UnloadCell(cell);
+
+        tileGrass.Cells = std::move(result.Cells);
+        tileGrass.SplatRevision = result.SplatRevision;
+        tileGrass.HeightRevision = result.HeightRevision;
+        tileGrass.Pending = false;
+
+        for (auto& cell : tileGrass.Cells)
+            UploadCell(cell);
+    }
+
+    for (const auto& tile : tiles)
+    {
+        auto& tileGrass = GetTileGrass(tile.Origin);
+        // blades sit on the heights they were scattered on, so a height edit re-scatters them too
+        if (tileGrass.Pending || (tileGrass.SplatRevision == tile.SplatRevision && tileGrass.HeightRevision == tile.HeightRevision))
+            continue;
+
+        if (tile.SplatPixels.empty() || tile.TerrainHeightMap.empty())
+        {
+            for (auto& cell : tileGrass.Cells)
+                UnloadCell(cell);
+            tileGrass.Cells.clear();
+            tileGrass.SplatRevision = tile.SplatRevision;
+            tileGrass.HeightRevision = tile.HeightRevision;
+            continue;
+        }
+
+        tileGrass.Pending = true;
+
+        // the job works on a snapshot so the tile can be regenerated while it runs
+        PendingScatters.push_back(TerrainJobQueue::Get().Submit([snapshot = std::make_shared<const TerrainTileSnapshot>(tile), settings = Settings]()
+            {
+                return Scatter(snapshot->Tile, settings);
+            }));
+    }
+
+    // tiles that went away take their cells with them
+    for (size_t i = 0; i < Tiles.size();)
+    {
+        const TerrainPosition& origin = Tiles[i].Origin;
+        if (std::any_of(tiles.begin(), tiles.end(), [&origin](const TerrainTile& tile) { return tile.Origin == origin; }))
+        {
+            i++;
+            continue;
+        }
+
+        for (auto& cell : Tiles[i].Cells)
+            UnloadCell(cell);
+        Tiles.erase(Tiles.begin() + i);
+    }
+}
+
+void TerrainGrassSystem::Draw(const Vector3& viewPos)
+{
+    DrawnCells = 0;
+
+    if (GrassShader.id == 0 || BladeVbo == 0)
+        return;
+
+    rlDrawRenderBatchActive();
+
+    rlEnableShader(GrassShader.id);
+
+    Matrix matViewProjection = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    rlSetUniformMatrix(GrassShader.locs[SHADER_LOC_MATRIX_MVP], matViewProjection);
+
+    float time = float(GetTime());
+    rlSetUniform(TimeLoc, &time, SHADER_UNIFORM_FLOAT, 1);
+
+    float bladeSize[2] = { Settings.BladeWidth, Settings.BladeHeight };
+    rlSetUniform(BladeSizeLoc, bladeSize, SHADER_UNIFORM_VEC2, 1);
+
+    float color[4];
+    ColorToFloats(Settings.BaseColor, color);
+    rlSetUniform(BaseColorLoc, color, SHADER_UNIFORM_VEC4, 1);
+    ColorToFloats(Settings.TipColor, color);
+    rlSetUniform(TipColorLoc, color, SHADER_UNIFORM_VEC4, 1);
+
+    rlDisableBackfaceCulling();
+
+    for (const auto& tileGrass : Tiles)
+    {
+        for (const auto& cell : tileGrass.Cells)
+        {
+            if (cell.VaoId == 0)
+                continue;
+
+            float dx = cell.Center.x - viewPos.x;
+            float dy = cell.Center.y - viewPos.y;
+            int ring = int(sqrtf(dx * dx + dy * dy) / Settings.RingSize);
+            if (ring >= Settings.RingCount)
+                continue;
+
+            int count = int(cell.InstanceCount >> ring);
+            if (count == 0)
+                continue;
+
+            rlEnableVertexArray(cell.VaoId);
+            rlDrawVertexArrayInstanced(0, BladeVertexCount, count);
+            DrawnCells++;
+        }
+    }
+
+    rlDisableVertexArray();
+    rlEnableBackfaceCulling();
+    rlDisableShader();
+}
+
+void TerrainGrassSystem::Unload()
+{
+    PendingScatters.clear();
+
+    for (auto& tileGrass : Tiles)
+    {
+        for (auto& cell : tileGrass.Cells)
+            UnloadCell(cell);
+    }
+    Tiles.clear();
+
+    if (BladeVbo != 0)
+    {
+        rlUnloadVertexBuffer(BladeVbo);
+        MemoryStats::Remove(MemoryStats::Category::Vegetation, sizeof(BladeVerts));
+    }
+    BladeVbo = 0;
+}
+
+size_t TerrainGrassSystem::GetInstanceCount() const
+{
+    size_t count = 0;
+    for (const auto& tileGrass : Tiles)
+    {
+        for (const auto& cell : tileGrass.Cells)
+            count += cell.InstanceCount;
+    }
+    return count;
+}
@@ -0,0 +1,60 @@
+#include "TerrainJobs.h"
+
+#include <algorithm>
+
+TerrainJobQueue::TerrainJobQueue(unsigned int threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    threadCount = std::max(1u, threadCount);
+    for (unsigned int i = 0; i < threadCount; i++)
+        Workers.emplace_back([this]() { Run(); });
+}
+
+TerrainJobQueue::~TerrainJobQueue()
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Stopping = true;
+    }
+    JobAdded.notify_all();
+
+    // jobs that never started are dropped, their futures report a broken promise
+    for (auto& worker : Workers)
+        worker.join();
+}
+
+TerrainJobQueue& TerrainJobQueue::Get()
+{
+    static TerrainJobQueue queue;
+    return queue;
+}
+
+void TerrainJobQueue::Push(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Jobs.push_back(std::move(job));
+    }
+    JobAdded.notify_one();
+}
+
+void TerrainJobQueue::Run()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> guard(Lock);
+            JobAdded.wait(guard, [this]() { return Stopping || !Jobs.empty(); });
+            if (Stopping)
+                return;
+
+            job = std::move(Jobs.front());
+            Jobs.pop_front();
+        }
+
+        job();
+    }
+}
@@ -0,0 +1,156 @@
+#include "TerrainNormalBaker.h"
+#include "TerrainJobs.h"
+#include "Profiler.h"
+
+#include "raymath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    float GetBorderedHeight(const std::vector<float>& heights, int grid, int x, int y)
+    {
+        // the heightmap has a one cell border on each side
+        x = std::clamp(x, -1, grid + 1);
+        y = std::clamp(y, -1, grid + 1);
+
+        return heights[(y + 1) * (grid + 3) + x + 1];
+    }
+
+    float CatmullRom(float p0, float p1, float p2, float p3, float t)
+    {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5f * ((2 * p1) + (-p0 + p2) * t + (2 * p0 - 5 * p1 + 4 * p2 - p3) * t2 + (-p0 + 3 * p1 - 3 * p2 + p3) * t3);
+    }
+
+    // bicubic so that sub quad texels get smooth slopes instead of the flat facets of the mesh
+    float SampleHeight(const std::vector<float>& heights, int grid, float fx, float fy)
+    {
+        int ix = int(std::floor(fx));
+        int iy = int(std::floor(fy));
+        float tx = fx - ix;
+        float ty = fy - iy;
+
+        float rows[4];
+        for (int r = 0; r < 4; r++)
+        {
+            int y = iy - 1 + r;
+            rows[r] = CatmullRom(GetBorderedHeight(heights, grid, ix - 1, y),
+                                 GetBorderedHeight(heights, grid, ix, y),
+                                 GetBorderedHeight(heights, grid, ix + 1, y),
+                                 GetBorderedHeight(heights, grid, ix + 2, y), tx);
+        }
+
+        return CatmullRom(rows[0], rows[1], rows[2], rows[3], ty);
+    }
+}
+
+TerrainNormalBakeResult TerrainNormalBaker::BakeImage(const std::vector<float>& heights, const TerrainInfo& info, int scale)
+{
+    PROFILE_SCOPE("TerrainNormalBaker::BakeImage");
+
+    TerrainNormalBakeResult result;
+
+    int grid = info.TerrainGridSize;
+    if (scale < 1)
+        scale = 1;
+
+    // one texel lands on every vertex, with scale - 1 texels between them
+    result.Size = grid * scale + 1;
+    result.Pixels.resize(size_t(result.Size) * result.Size * 3);
+
+    if (heights.size() < size_t(grid + 3) * (grid + 3))
+        return result;
+
+    float step = 1.0f / scale;
+    float worldStep = step * (info.TerrainTileSize / grid);
+
+    for (int y = 0; y < result.Size; y++)
+    {
+        for (int x = 0; x < result.Size; x++)
+        {
+            float fx = x * step;
+            float fy = y * step;
+
+            float dzdx = (SampleHeight(heights, grid, fx + step, fy) - SampleHeight(heights, grid, fx - step, fy)) / (2 * worldStep);
+            float dzdy = (SampleHeight(heights, grid, fx, fy + step) - SampleHeight(heights, grid, fx, fy - step)) / (2 * worldStep);
+
+            Vector3 normal = Vector3Normalize(Vector3{ -dzdx, -dzdy, 1 });
+
+            uint8_t* pixel = &result.Pixels[(size_t(y) * result.Size + x) * 3];
+            pixel[0] = uint8_t((normal.x * 0.5f + 0.5f) * 255);
+            pixel[1] = uint8_t((normal.y * 0.5f + 0.5f) * 255);
+            pixel[2] = uint8_t((normal.z * 0.5f + 0.5f) * 255);
+        }
+    }
+
+    return result;
+}
+
+void TerrainNormalBaker::Upload(TerrainTile& tile, const TerrainNormalBakeResult& result)
+{
+    tile.UnloadNormalMap();
+
+    if (result.Size == 0)
+        return;
+
+    Image image = { 0 };
+    image.data = (void*)result.Pixels.data();
+    image.width = result.Size;
+    image.height = result.Size;
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8;
+
+    tile.NormalMap = LoadTextureFromImage(image);
+    MemoryStats::AddTexture(MemoryStats::Category::TerrainTextures, tile.NormalMap);
+    SetTextureFilter(tile.NormalMap, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(tile.NormalMap, TEXTURE_WRAP_CLAMP);
+}
+
+void TerrainNormalBaker::Bake(TerrainTile& tile)
+{
+    auto result = BakeImage(tile.TerrainHeightMap, tile.Info, Scale);
+    result.Origin = tile.Origin;
+    Upload(tile, result);
+}
+
+void TerrainNormalBaker::QueueBake(const TerrainTile& tile)
+{
+    PendingBakes.push_back(TerrainJobQueue::Get().Submit(
+        [heights = tile.TerrainHeightMap, info = tile.Info, origin = tile.Origin, scale = Scale]()
+        {
+            auto result = BakeImage(heights, info, scale);
+            result.Origin = origin;
+            return result;
+        }));
+}
+
+size_t TerrainNormalBaker::Update(std::vector<TerrainTile>& tiles)
+{
+    size_t uploaded = 0;
+
+    // stop at the first unfinished bake so a re-queued tile never gets an older result last
+    while (!PendingBakes.empty())
+    {
+        auto& front = PendingBakes.front();
+        if (front.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            break;
+
+        auto result = front.get();
+        PendingBakes.erase(PendingBakes.begin());
+
+        for (auto& tile : tiles)
+        {
+            if (tile.Origin == result.Origin)
+            {
+                Upload(tile, result);
+                uploaded++;
+                break;
+            }
+        }
+    }
+
+    return uploaded;
+}
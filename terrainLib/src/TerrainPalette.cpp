@@ -0,0 +1,210 @@
+#include "TerrainPalette.h"
+
+#include "rlgl.h"
+
+#include "external/glad.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr int IndexedLayers = 4;
+
+    bool IsTextureUsable(const Texture& texture)
+    {
+        // the editor marks missing maps with -1
+        return texture.id > 0 && texture.id != (unsigned int)-1;
+    }
+}
+
+int TerrainMaterialPalette::Add(const TerrainMaterial* material)
+{
+    int index = GetIndex(material);
+    if (index >= 0)
+        return index;
+
+    if (!material || Materials.size() >= MaxPaletteMaterials)
+        return -1;
+
+    Materials.push_back(material);
+    return int(Materials.size() - 1);
+}
+
+int TerrainMaterialPalette::GetIndex(const TerrainMaterial* material) const
+{
+    auto itr = std::find(Materials.begin(), Materials.end(), material);
+    if (itr == Materials.end())
+        return -1;
+
+    return int(itr - Materials.begin());
+}
+
+void TerrainMaterialPalette::Clear()
+{
+    Materials.clear();
+    Tints.clear();
+}
+
+bool TerrainMaterialPalette::Build()
+{
+    Unload();
+
+    if (Materials.empty() || LayerSize <= 0)
+        return false;
+
+    glGenTextures(1, &TextureId);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, TextureId);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, LayerSize, LayerSize, GLsizei(Materials.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // RGBA8 layers, and about a third more for the mip chain
+    TextureBytes = int64_t(LayerSize) * LayerSize * 4 * int64_t(Materials.size()) * 4 / 3;
+    MemoryStats::Add(MemoryStats::Category::TerrainTextures, TextureBytes);
+
+    Tints.resize(Materials.size() * 4);
+
+    for (size_t i = 0; i < Materials.size(); i++)
+    {
+        const TerrainMaterial* material = Materials[i];
+
+        Image layer = { 0 };
+        if (IsTextureUsable(material->DiffuseMap))
+            layer = LoadImageFromTexture(material->DiffuseMap);
+
+        if (layer.data == nullptr)
+        {
+            layer = GenImageColor(LayerSize, LayerSize, WHITE);
+        }
+        else
+        {
+            ImageFormat(&layer, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            ImageResize(&layer, LayerSize, LayerSize);
+        }
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, GLint(i), LayerSize, LayerSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.data);
+        UnloadImage(layer);
+
+        Tints[i * 4 + 0] = material->DiffuseColor.r / 255.0f;
+        Tints[i * 4 + 1] = material->DiffuseColor.g / 255.0f;
+        Tints[i * 4 + 2] = material->DiffuseColor.b / 255.0f;
+        Tints[i * 4 + 3] = material->DiffuseColor.a / 255.0f;
+    }
+
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return true;
+}
+
+void TerrainMaterialPalette::Unload()
+{
+    if (TextureId != 0)
+    {
+        glDeleteTextures(1, &TextureId);
+        MemoryStats::Remove(MemoryStats::Category::TerrainTextures, TextureBytes);
+    }
+
+    TextureId = 0;
+    TextureBytes = 0;
+}
+
+TerrainIndexedSplat TerrainMaterialPalette::EncodeTile(const TerrainTile& tile) const
+{
+    int layerCount = std::min(int(tile.LayerMaterials.size()), 5);
+    if (layerCount == 0 || tile.SplatPixels.empty())
+        return TerrainIndexedSplat();
+
+    int paletteIndices[5] = { -1, -1, -1, -1, -1 };
+    for (int i = 0; i < layerCount; i++)
+        paletteIndices[i] = GetIndex(tile.LayerMaterials[i]);
+
+    std::vector<uint8_t> weights(tile.SplatPixels.size() * layerCount);
+    for (size_t t = 0; t < tile.SplatPixels.size(); t++)
+    {
+        const Color& texel = tile.SplatPixels[t];
+        float channels[4] = { texel.r / 255.0f, texel.g / 255.0f, texel.b / 255.0f, texel.a / 255.0f };
+
+        float layer[5];
+        TerrainTile::ComputeLayerWeights(channels, layerCount, layer);
+
+        for (int i = 0; i < layerCount; i++)
+            weights[t * layerCount + i] = uint8_t(layer[i] * 255 + 0.5f);
+    }
+
+    return EncodeWeights(weights.data(), layerCount, paletteIndices, tile.SplatWidth, tile.SplatHeight);
+}
+
+TerrainIndexedSplat TerrainMaterialPalette::EncodeWeights(const uint8_t* layerWeights, int layerCount, const int* paletteIndices, int width, int height)
+{
+    TerrainIndexedSplat result;
+    result.Width = width;
+    result.Height = height;
+
+    size_t texelCount = size_t(width) * height;
+    result.Indices.resize(texelCount);
+    result.Weights.resize(texelCount);
+
+    // falls back to the first valid layer where nothing is painted
+    int fallback = 0;
+    for (int i = 0; i < layerCount; i++)
+    {
+        if (paletteIndices[i] >= 0)
+        {
+            fallback = paletteIndices[i];
+            break;
+        }
+    }
+
+    std::vector<std::pair<int, int>> ranked(layerCount);
+
+    for (size_t t = 0; t < texelCount; t++)
+    {
+        const uint8_t* texel = layerWeights + t * layerCount;
+
+        for (int i = 0; i < layerCount; i++)
+            ranked[i] = { paletteIndices[i] >= 0 ? texel[i] : 0, i };
+
+        int kept = std::min(layerCount, IndexedLayers);
+        std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(), [](const auto& a, const auto& b)
+            {
+                return a.first > b.first || (a.first == b.first && a.second < b.second);
+            });
+
+        int total = 0;
+        for (int i = 0; i < kept; i++)
+            total += ranked[i].first;
+
+        uint8_t* indices = &result.Indices[t].r;
+        uint8_t* weights = &result.Weights[t].r;
+
+        for (int i = 0; i < IndexedLayers; i++)
+        {
+            indices[i] = uint8_t(fallback);
+            weights[i] = 0;
+        }
+
+        if (total == 0)
+        {
+            weights[0] = 255;
+            continue;
+        }
+
+        // renormalize what survives the cut, rounding leftovers go to the heaviest layer
+        int assigned = 0;
+        for (int i = 0; i < kept; i++)
+        {
+            if (ranked[i].first == 0)
+                break;
+
+            indices[i] = uint8_t(paletteIndices[ranked[i].second]);
+            weights[i] = uint8_t((ranked[i].first * 255) / total);
+            assigned += weights[i];
+        }
+        weights[0] = uint8_t(weights[0] + (255 - assigned));
+    }
+
+    return result;
+}
@@ -1,32 +1,174 @@
 #include "TerrainRender.h"
 
 #include "TerrainTile.h"
+#include "Profiler.h"
 
 #include "rlgl.h"
 #include "raymath.h"
 
 #include "external/glad.h"
 
+#include <algorithm>
+
 constexpr float WHITEF[4] = { 1,1,1,1 };
 
-TerainRenderer::TerainRenderer()
-{
-    TerrainShader = LoadShader(nullptr, nullptr);
-}
+static constexpr int SplatSlot = 5;
+static constexpr int NormalMapSlot = 6;
+static constexpr int PaletteSlot = 7;
+static constexpr int SplatWeightSlot = 8;
+static constexpr int AlbedoSlot = 9;
 
-void TerainRenderer::SetShader(Shader& shader)
+void TerainRenderer::ShaderPermutation::SetShader(Shader& shader)
 {
     TerrainShader = shader;
 
     for (int i = 0; i < 5; i++)
     {
-        MaterialTextureLocs.push_back(GetShaderLocation(shader, TextFormat("matDiffuse%d", i)));
-        MaterialTintLocs.push_back(GetShaderLocation(shader, TextFormat("matTint%d", i)));
+        MaterialTextureLocs[i] = GetShaderLocation(shader, TextFormat("matDiffuse%d", i));
+        MaterialTintLocs[i] = GetShaderLocation(shader, TextFormat("matTint%d", i));
     }
 
     MaterialCountLoc = GetShaderLocation(shader, "materialCount");
 
     SplatmapLoc = GetShaderLocation(shader, "splatmap");
+
+    IndexedSplatLoc = GetShaderLocation(shader, "indexedSplat");
+    MaterialArrayLoc = GetShaderLocation(shader, "materialArray");
+    PaletteTintLoc = GetShaderLocation(shader, "paletteTint");
+    SplatIndexLoc = GetShaderLocation(shader, "splatIndices");
+    SplatWeightLoc = GetShaderLocation(shader, "splatWeights");
+
+    FarAlbedoLoc = GetShaderLocation(shader, "farAlbedo");
+    AlbedoMapLoc = GetShaderLocation(shader, "albedoMap");
+
+    NormalMapLoc = GetShaderLocation(shader, "normalMap");
+    NormalMapTransformLoc = GetShaderLocation(shader, "normalMapTransform");
+    UseNormalMapLoc = GetShaderLocation(shader, "useNormalMap");
+
+    SelectedLoc = GetShaderLocation(shader, "selected");
+    SelectedColorLoc = GetShaderLocation(shader, "selectedColor");
+    ShowSplatLoc = GetShaderLocation(shader, "showSplat");
+    SunVectorLoc = GetShaderLocation(shader, "sunVector");
+}
+
+TerainRenderer::TerainRenderer()
+{
+    DefaultShader.TerrainShader = LoadShader(nullptr, nullptr);
+}
+
+void TerainRenderer::SetShader(Shader& shader)
+{
+    DefaultShader.SetShader(shader);
+}
+
+bool TerainRenderer::LoadShaderSource(const char* vsFileName, const char* fsFileName)
+{
+    char* vsText = LoadFileText(vsFileName);
+    char* fsText = LoadFileText(fsFileName);
+
+    bool valid = vsText != nullptr && fsText != nullptr;
+    if (valid)
+    {
+        UnloadPermutations();
+        VertexSource = vsText;
+        FragmentSource = fsText;
+    }
+
+    UnloadFileText(vsText);
+    UnloadFileText(fsText);
+
+    return valid;
+}
+
+void TerainRenderer::UnloadPermutations()
+{
+    for (auto& [key, permutation] : Permutations)
+        UnloadShader(permutation.TerrainShader);
+
+    Permutations.clear();
+    FailedPermutations.clear();
+}
+
+uint32_t TerainRenderer::GetPermutationKey(uint32_t layerMask, uint32_t flags, bool normalMap, bool indexed)
+{
+    return layerMask | ((flags & 0x0F) << 5) | (normalMap ? 0x200 : 0) | (indexed ? 0x400 : 0);
+}
+
+TerainRenderer::TileDrawState TerainRenderer::GetDrawState(const TerrainTile& tile, uint32_t flags) const
+{
+    TileDrawState state;
+
+    state.FarAlbedo = (flags & TerrainDrawFarAlbedo) && tile.AlbedoMap.id > 0 && !(flags & TerrainDrawShowSplat);
+    state.Flags = state.FarAlbedo ? flags : (flags & ~TerrainDrawFarAlbedo);
+
+    state.Indexed = !state.FarAlbedo && Palette != nullptr && Palette->GetTextureId() != 0 && tile.SplatIndexMap.id > 0;
+
+    // the palette or the composite replace the per tile layer list entirely
+    state.MaterialCount = (state.Indexed || state.FarAlbedo) ? 0 : std::min(int(tile.LayerMaterials.size()), 5);
+
+    // layers the splat never touches are not bound and, with permutations, not even compiled in
+    state.LayerMask = tile.ActiveLayerMask & ((1u << state.MaterialCount) - 1);
+    state.NormalMap = tile.NormalMap.id > 0;
+
+    return state;
+}
+
+TerainRenderer::ShaderPermutation& TerainRenderer::GetPermutation(uint32_t layerMask, uint32_t flags, bool normalMap, bool indexed)
+{
+    uint32_t key = GetPermutationKey(layerMask, flags, normalMap, indexed);
+
+    auto itr = Permutations.find(key);
+    if (itr != Permutations.end())
+        return itr->second;
+
+    if (FailedPermutations.count(key) != 0)
+        return DefaultShader;
+
+    std::string defines = TextFormat("#define TERRAIN_PERMUTATION\n#define LAYER_MASK %u\n#define SELECTED %d\n#define SHOW_SPLAT %d\n#define USE_NORMAL_MAP %d\n#define INDEXED_SPLAT %d\n#define FAR_ALBEDO %d\n",
+        layerMask,
+        (flags & TerrainDrawSelected) ? 1 : 0,
+        (flags & TerrainDrawShowSplat) ? 1 : 0,
+        normalMap ? 1 : 0,
+        indexed ? 1 : 0,
+        (flags & TerrainDrawFarAlbedo) ? 1 : 0);
+
+    // defines have to come after the #version line
+    std::string fragment = FragmentSource;
+    size_t insertPos = 0;
+    if (fragment.rfind("#version", 0) == 0)
+        insertPos = fragment.find('\n') + 1;
+    fragment.insert(insertPos, defines);
+
+    Shader shader = LoadShaderFromMemory(VertexSource.c_str(), fragment.c_str());
+
+    // raylib hands back its default shader when compiling fails, that must not stand in for the permutation
+    if (shader.id == rlGetShaderIdDefault())
+    {
+        TraceLog(LOG_WARNING, "TERRAIN: shader permutation %u failed to compile, drawing with the default shader. Defines:\n%s", key, defines.c_str());
+        FailedPermutations.insert(key);
+        return DefaultShader;
+    }
+
+    auto& permutation = Permutations[key];
+    permutation.SetShader(shader);
+    return permutation;
+}
+
+uint64_t TerainRenderer::GetBatchKey(const TerrainTile& tile, uint32_t flags) const
+{
+    TileDrawState state = GetDrawState(tile, flags);
+
+    // the same permutation key Draw picks its shader with, so a batch never switches shaders
+    uint64_t key = (1469598103934665603ull ^ GetPermutationKey(state.LayerMask, state.Flags, state.NormalMap, state.Indexed)) * 1099511628211ull;
+
+    // palette and far albedo tiles bind no layer textures, they only differ in their own splat or composite
+    for (int i = 0; i < state.MaterialCount; i++)
+    {
+        if (state.LayerMask & (1u << i))
+            key = (key ^ uint64_t(uintptr_t(tile.LayerMaterials[i]))) * 1099511628211ull;
+    }
+
+    return key;
 }
 
 // Draw vertex array elements
@@ -54,11 +196,25 @@ void SetShaderValueTextureSlot(Shader shader, int locIndex, Texture2D texture, i
 }
 
 
-void TerainRenderer::Draw(TerrainTile& tile, size_t lod)
+void TerainRenderer::Draw(TerrainTile& tile, size_t lod, uint32_t flags)
 {
-    rlEnableShader(TerrainShader.id);
-    rlSetUniform(TerrainShader.locs[SHADER_LOC_COLOR_DIFFUSE], WHITEF, SHADER_UNIFORM_VEC4, 1);
-    rlSetUniform(TerrainShader.locs[SHADER_LOC_COLOR_SPECULAR], WHITEF, SHADER_UNIFORM_VEC4, 1);
+    PROFILE_SCOPE("TerainRenderer::Draw");
+
+    TileDrawState state = GetDrawState(tile, flags);
+    flags = state.Flags;
+
+    bool farAlbedo = state.FarAlbedo;
+    bool indexed = state.Indexed;
+    int matCount = state.MaterialCount;
+    uint32_t layerMask = state.LayerMask;
+    bool useNormalMap = state.NormalMap;
+
+    ShaderPermutation& permutation = FragmentSource.empty() ? DefaultShader : GetPermutation(layerMask, flags, useNormalMap, indexed);
+    Shader& terrainShader = permutation.TerrainShader;
+
+    rlEnableShader(terrainShader.id);
+    rlSetUniform(terrainShader.locs[SHADER_LOC_COLOR_DIFFUSE], WHITEF, SHADER_UNIFORM_VEC4, 1);
+    rlSetUniform(terrainShader.locs[SHADER_LOC_COLOR_SPECULAR], WHITEF, SHADER_UNIFORM_VEC4, 1);
 
     Matrix transform = MatrixTranslate(tile.Origin.X * tile.Info.TerrainTileSize, tile.Origin.Y * tile.Info.TerrainTileSize, 0);
 
@@ -68,14 +224,14 @@ void TerainRenderer::Draw(TerrainTile& tile, size_t lod)
     Matrix matProjection = rlGetMatrixProjection();
 
     // Upload view and projection matrices (if locations available)
-    if (TerrainShader.locs[SHADER_LOC_MATRIX_VIEW] != -1)
-        rlSetUniformMatrix(TerrainShader.locs[SHADER_LOC_MATRIX_VIEW], matView);
-    if (TerrainShader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1)
-        rlSetUniformMatrix(TerrainShader.locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
+    if (terrainShader.locs[SHADER_LOC_MATRIX_VIEW] != -1)
+        rlSetUniformMatrix(terrainShader.locs[SHADER_LOC_MATRIX_VIEW], matView);
+    if (terrainShader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1)
+        rlSetUniformMatrix(terrainShader.locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
 
     // Model transformation matrix is send to shader uniform location: SHADER_LOC_MATRIX_MODEL
-    if (TerrainShader.locs[SHADER_LOC_MATRIX_MODEL] != -1)
-        rlSetUniformMatrix(TerrainShader.locs[SHADER_LOC_MATRIX_MODEL], transform);
+    if (terrainShader.locs[SHADER_LOC_MATRIX_MODEL] != -1)
+        rlSetUniformMatrix(terrainShader.locs[SHADER_LOC_MATRIX_MODEL], transform);
 
     // Accumulate several model transformations:
     //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
@@ -86,34 +242,100 @@ void TerainRenderer::Draw(TerrainTile& tile, size_t lod)
     matModelView = MatrixMultiply(matModel, matView);
 
     // Upload model normal matrix (if locations available)
-    if (TerrainShader.locs[SHADER_LOC_MATRIX_NORMAL] != -1)
-        rlSetUniformMatrix(TerrainShader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
+    if (terrainShader.locs[SHADER_LOC_MATRIX_NORMAL] != -1)
+        rlSetUniformMatrix(terrainShader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
 
    
     // Select current shader texture slot
-    for (int i = 0; i < tile.LayerMaterials.size(); i++)
+    for (int i = 0; i < matCount; i++)
     {
+        if ((layerMask & (1u << i)) == 0)
+            continue;
+
         rlActiveTextureSlot(i);
 
         rlEnableTexture(tile.LayerMaterials[i]->DiffuseMap.id);
-        rlSetUniform(MaterialTextureLocs[i], &i, SHADER_UNIFORM_INT, 1);
+        rlSetUniform(permutation.MaterialTextureLocs[i], &i, SHADER_UNIFORM_INT, 1);
 
         float colors[4] = { float(tile.LayerMaterials[i]->DiffuseColor.r / 255.0f),
                             float(tile.LayerMaterials[i]->DiffuseColor.g / 255.0f),
                             float(tile.LayerMaterials[i]->DiffuseColor.b / 255.0f),
                             float(tile.LayerMaterials[i]->DiffuseColor.a / 255.0f) };
 
-        rlSetUniform(MaterialTintLocs[i], colors, SHADER_UNIFORM_VEC4, 1);
+        rlSetUniform(permutation.MaterialTintLocs[i], colors, SHADER_UNIFORM_VEC4, 1);
     }
 
-    int maskSlot = int(tile.LayerMaterials.size());
+    int maskSlot = SplatSlot;
     rlActiveTextureSlot(maskSlot);
 
     rlEnableTexture(tile.Splatmap.id);
-    rlSetUniform(SplatmapLoc, &maskSlot, SHADER_UNIFORM_INT, 1);
+    rlSetUniform(permutation.SplatmapLoc, &maskSlot, SHADER_UNIFORM_INT, 1);
+
+    rlSetUniform(permutation.MaterialCountLoc, &matCount, SHADER_UNIFORM_INT, 1);
 
-    int matCount = int(tile.LayerMaterials.size());
-    rlSetUniform(MaterialCountLoc, &matCount, SHADER_UNIFORM_INT, 1);
+    // array and 2D samplers may not share a unit, so these always point at their own slots
+    int paletteSlot = PaletteSlot;
+    rlSetUniform(permutation.MaterialArrayLoc, &paletteSlot, SHADER_UNIFORM_INT, 1);
+    int weightSlot = SplatWeightSlot;
+    rlSetUniform(permutation.SplatWeightLoc, &weightSlot, SHADER_UNIFORM_INT, 1);
+
+    int albedoSlot = AlbedoSlot;
+    rlSetUniform(permutation.AlbedoMapLoc, &albedoSlot, SHADER_UNIFORM_INT, 1);
+
+    int farAlbedoFlag = farAlbedo ? 1 : 0;
+    rlSetUniform(permutation.FarAlbedoLoc, &farAlbedoFlag, SHADER_UNIFORM_INT, 1);
+
+    if (farAlbedo)
+    {
+        rlActiveTextureSlot(albedoSlot);
+        rlEnableTexture(tile.AlbedoMap.id);
+    }
+
+    int indexedFlag = indexed ? 1 : 0;
+    rlSetUniform(permutation.IndexedSplatLoc, &indexedFlag, SHADER_UNIFORM_INT, 1);
+
+    if (indexed)
+    {
+        // the same array serves every tile, only the two splat textures change
+        rlActiveTextureSlot(paletteSlot);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, Palette->GetTextureId());
+        rlSetUniform(permutation.PaletteTintLoc, Palette->GetTints(), SHADER_UNIFORM_VEC4, int(Palette->GetCount()));
+
+        rlActiveTextureSlot(maskSlot);
+        rlEnableTexture(tile.SplatIndexMap.id);
+        rlSetUniform(permutation.SplatIndexLoc, &maskSlot, SHADER_UNIFORM_INT, 1);
+
+        rlActiveTextureSlot(weightSlot);
+        rlEnableTexture(tile.SplatWeightMap.id);
+    }
+
+    rlSetUniform(permutation.SunVectorLoc, SunVector, SHADER_UNIFORM_VEC3, 1);
+
+    float selectedColor[4] = { SelectedColor.r / 255.0f, SelectedColor.g / 255.0f, SelectedColor.b / 255.0f, SelectedColor.a / 255.0f };
+    rlSetUniform(permutation.SelectedColorLoc, selectedColor, SHADER_UNIFORM_VEC4, 1);
+
+    // only the runtime shader has these as uniforms, permutations bake them in
+    int selected = (flags & TerrainDrawSelected) ? 1 : 0;
+    rlSetUniform(permutation.SelectedLoc, &selected, SHADER_UNIFORM_INT, 1);
+    int showSplat = (flags & TerrainDrawShowSplat) ? 1 : 0;
+    rlSetUniform(permutation.ShowSplatLoc, &showSplat, SHADER_UNIFORM_INT, 1);
+    int normalMapFlag = useNormalMap ? 1 : 0;
+    rlSetUniform(permutation.UseNormalMapLoc, &normalMapFlag, SHADER_UNIFORM_INT, 1);
+
+    if (useNormalMap)
+    {
+        int normalSlot = NormalMapSlot;
+        rlActiveTextureSlot(normalSlot);
+
+        rlEnableTexture(tile.NormalMap.id);
+        rlSetUniform(permutation.NormalMapLoc, &normalSlot, SHADER_UNIFORM_INT, 1);
+
+        // the mesh UVs step 1/(grid+1) per vertex, remap them onto the texel centers of the baked map
+        float grid = float(tile.Info.TerrainGridSize);
+        float size = float(tile.NormalMap.width);
+        float normalTransform[2] = { (grid + 1) * (size - 1) / (grid * size), 0.5f / size };
+        rlSetUniform(permutation.NormalMapTransformLoc, normalTransform, SHADER_UNIFORM_VEC2, 1);
+    }
 
     // bind vao
     rlEnableVertexArray(tile.VaoId);
@@ -121,7 +343,7 @@ void TerainRenderer::Draw(TerrainTile& tile, size_t lod)
     Matrix matModelViewProjection = MatrixMultiply(matModelView, matProjection);
 
     // Send combined model-view-projection matrix to shader
-    rlSetUniformMatrix(TerrainShader.locs[SHADER_LOC_MATRIX_MVP], matModelViewProjection);
+    rlSetUniformMatrix(terrainShader.locs[SHADER_LOC_MATRIX_MVP], matModelViewProjection);
 
     // Draw mesh
     rlDrawVertexArrayElements((int)tile.LODs[lod].IndexStart * 3, (int)tile.LODs[lod].IndexCount * 3, 0);
@@ -1,9 +1,12 @@
 #include "TerrainTile.h"
+#include "TerrainPalette.h"
 
 #include "raylib.h"
 #include "rlgl.h"
 #include "config.h"
 
+#include <algorithm>
+
 TerrainTile::TerrainTile(TerrainInfo& info)
     : Info(info)
 {
@@ -14,6 +17,23 @@ TerrainTile::~TerrainTile()
 {
 }
 
+TerrainTileSnapshot::TerrainTileSnapshot(const TerrainTile& source)
+    : Info(source.Info)
+    , Tile(Info)
+{
+    Tile.Origin = source.Origin;
+
+    Tile.TerrainHeightMap = source.TerrainHeightMap;
+    Tile.MinHeight = source.MinHeight;
+    Tile.MaxHeight = source.MaxHeight;
+    Tile.HeightRevision = source.HeightRevision;
+
+    Tile.SplatPixels = source.SplatPixels;
+    Tile.SplatWidth = source.SplatWidth;
+    Tile.SplatHeight = source.SplatHeight;
+    Tile.SplatRevision = source.SplatRevision;
+}
+
 void TerrainTile::SetHeightsFromImage(Image& image)
 {
     TerrainHeightMap.resize((Info.TerrainGridSize + 3) * (Info.TerrainGridSize + 3));
@@ -30,12 +50,117 @@ void TerrainTile::SetHeightsFromImage(Image& image)
             TerrainHeightMap[index] = z;
         }
     }
+
+    if (!TerrainHeightMap.empty())
+    {
+        auto range = std::minmax_element(TerrainHeightMap.begin(), TerrainHeightMap.end());
+        MinHeight = *range.first;
+        MaxHeight = *range.second;
+    }
+    HeightRevision++;
+
+    UpdateMemoryUsage();
+}
+
+void TerrainTile::SetSplatFromImage(Image& image)
+{
+    Splatmap = LoadTextureFromImage(image);
+    MemoryStats::AddTexture(MemoryStats::Category::TerrainTextures, Splatmap);
+
+    Color* colors = LoadImageColors(image);
+    SplatPixels.assign(colors, colors + (image.width * image.height));
+    UnloadImageColors(colors);
+
+    SplatWidth = image.width;
+    SplatHeight = image.height;
+    SplatRevision++;
+
+    ActiveLayerMask = ComputeActiveLayerMask(SplatPixels);
+
+    UpdateMemoryUsage();
+}
+
+void TerrainTile::SetIndexedSplat(const TerrainIndexedSplat& splat)
+{
+    MemoryStats::RemoveTexture(MemoryStats::Category::TerrainTextures, SplatIndexMap);
+    MemoryStats::RemoveTexture(MemoryStats::Category::TerrainTextures, SplatWeightMap);
+
+    if (SplatIndexMap.id > 0)
+        UnloadTexture(SplatIndexMap);
+    if (SplatWeightMap.id > 0)
+        UnloadTexture(SplatWeightMap);
+
+    SplatIndexMap = { 0 };
+    SplatWeightMap = { 0 };
+
+    if (splat.Indices.empty())
+        return;
+
+    // indices can't be blended, and the weights have to stay with their indices
+    Image image = { (void*)splat.Indices.data(), splat.Width, splat.Height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    SplatIndexMap = LoadTextureFromImage(image);
+    SetTextureFilter(SplatIndexMap, TEXTURE_FILTER_POINT);
+    SetTextureWrap(SplatIndexMap, TEXTURE_WRAP_CLAMP);
+
+    image.data = (void*)splat.Weights.data();
+    SplatWeightMap = LoadTextureFromImage(image);
+    SetTextureFilter(SplatWeightMap, TEXTURE_FILTER_POINT);
+    SetTextureWrap(SplatWeightMap, TEXTURE_WRAP_CLAMP);
+
+    MemoryStats::AddTexture(MemoryStats::Category::TerrainTextures, SplatIndexMap);
+    MemoryStats::AddTexture(MemoryStats::Category::TerrainTextures, SplatWeightMap);
+}
+
+uint8_t TerrainTile::ComputeActiveLayerMask(const std::vector<Color>& splat)
+{
+    if (splat.empty())
+        return 0x1F;
+
+    uint8_t mask = 0;
+
+    // the base layer only disappears if one channel covers every texel, anything less can show through the filtering
+    uint8_t fullChannels = 0x0F;
+
+    for (const auto& texel : splat)
+    {
+        const uint8_t* channels = &texel.r;
+        for (int c = 0; c < 4; c++)
+        {
+            if (channels[c] > 0)
+                mask |= uint8_t(0x02 << c);
+
+            if (channels[c] < 255)
+                fullChannels &= uint8_t(~(0x01 << c));
+        }
+    }
+
+    if (fullChannels == 0)
+        mask |= 0x01;
+
+    return mask;
+}
+
+void TerrainTile::ComputeLayerWeights(const float* channels, int layerCount, float* weights)
+{
+    // base, then r, g, b, a each blended over everything before it
+    for (int i = 0; i < layerCount; i++)
+        weights[i] = i == 0 ? 1.0f : 0.0f;
+
+    for (int c = 0; c + 1 < layerCount && c < 4; c++)
+    {
+        for (int j = 0; j <= c; j++)
+            weights[j] *= 1 - channels[c];
+        weights[c + 1] = channels[c];
+    }
 }
 
 void TerrainTile::AddMaterial(const TerrainMaterial* material)
 {
     if (material)
+    {
         LayerMaterials.push_back(material);
+        UpdateMemoryUsage();
+    }
 }
 
 float TerrainTile::GetLocalHeight(int x, int y) const
@@ -44,6 +169,61 @@ float TerrainTile::GetLocalHeight(int x, int y) const
     return TerrainHeightMap[index];
 }
 
+BoundingBox TerrainTile::GetBounds() const
+{
+    float x = Origin.X * Info.TerrainTileSize;
+    float y = Origin.Y * Info.TerrainTileSize;
+
+    return BoundingBox{ Vector3{ x, y, MinHeight }, Vector3{ x + Info.TerrainTileSize, y + Info.TerrainTileSize, MaxHeight } };
+}
+
+float TerrainTile::GetHeightAt(float x, float y) const
+{
+    float vertexScale = Info.TerrainTileSize / Info.TerrainGridSize;
+    float fx = std::clamp(x / vertexScale, 0.0f, float(Info.TerrainGridSize));
+    float fy = std::clamp(y / vertexScale, 0.0f, float(Info.TerrainGridSize));
+
+    int ix = std::min(int(fx), Info.TerrainGridSize - 1);
+    int iy = std::min(int(fy), Info.TerrainGridSize - 1);
+    float tx = fx - ix;
+    float ty = fy - iy;
+
+    float h0 = GetLocalHeight(ix, iy) + (GetLocalHeight(ix + 1, iy) - GetLocalHeight(ix, iy)) * tx;
+    float h1 = GetLocalHeight(ix, iy + 1) + (GetLocalHeight(ix + 1, iy + 1) - GetLocalHeight(ix, iy + 1)) * tx;
+    return h0 + (h1 - h0) * ty;
+}
+
+float TerrainTile::GetSplatWeightAt(float x, float y, int channel) const
+{
+    if (SplatPixels.empty())
+        return 0;
+
+    // match the shader, which samples the splat with the mesh UVs of x / (grid + 1)
+    float vertexScale = Info.TerrainTileSize / Info.TerrainGridSize;
+    float u = (x / vertexScale) / (Info.TerrainGridSize + 1);
+    float v = (y / vertexScale) / (Info.TerrainGridSize + 1);
+
+    float fx = std::clamp(u * SplatWidth - 0.5f, 0.0f, float(SplatWidth - 1));
+    float fy = std::clamp(v * SplatHeight - 0.5f, 0.0f, float(SplatHeight - 1));
+
+    int ix = int(fx);
+    int iy = int(fy);
+    int ix2 = std::min(ix + 1, SplatWidth - 1);
+    int iy2 = std::min(iy + 1, SplatHeight - 1);
+    float tx = fx - ix;
+    float ty = fy - iy;
+
+    auto texel = [&](int px, int py)
+    {
+        const uint8_t* c = &SplatPixels[size_t(py) * SplatWidth + px].r;
+        return c[channel] / 255.0f;
+    };
+
+    float w0 = texel(ix, iy) + (texel(ix2, iy) - texel(ix, iy)) * tx;
+    float w1 = texel(ix, iy2) + (texel(ix2, iy2) - texel(ix, iy2)) * tx;
+    return w0 + (w1 - w0) * ty;
+}
+
 void TerrainTile::UnloadGeometry()
 {
     rlUnloadVertexArray(VaoId);
@@ -57,17 +237,60 @@ void TerrainTile::UnloadGeometry()
         }
             
     }
+    if (VboId != nullptr)
+        MemoryStats::Remove(MemoryStats::Category::RaylibHeap, MAX_MESH_VERTEX_BUFFERS * sizeof(unsigned int));
     MemFree(VboId);
+    if (GeometryBytes > 0)
+        MemoryStats::Remove(MemoryStats::Category::TerrainGeometry, GeometryBytes);
 
     VaoId = -1;
     VboId = nullptr;
+    GeometryBytes = 0;
 
     TerrainHeightMap.clear();
+    HeightRevision++;
+    VertexOcclusion.clear();
+
+    UnloadNormalMap();
+    UpdateMemoryUsage();
 }
 
 void TerrainTile::UnloadSplats()
 {
+    MemoryStats::RemoveTexture(MemoryStats::Category::TerrainTextures, Splatmap);
     UnloadTexture(Splatmap);
     LayerMaterials.clear();
     Splatmap.id = -1;
-}
\ No newline at end of file
+
+    SplatPixels.clear();
+    SplatWidth = 0;
+    SplatHeight = 0;
+    SplatRevision++;
+    ActiveLayerMask = 0x1F;
+
+    SetIndexedSplat(TerrainIndexedSplat());
+
+    MemoryStats::RemoveTexture(MemoryStats::Category::TerrainTextures, AlbedoMap);
+    if (AlbedoMap.id > 0)
+        UnloadTexture(AlbedoMap);
+    AlbedoMap = { 0 };
+
+    UpdateMemoryUsage();
+}
+
+void TerrainTile::UnloadNormalMap()
+{
+    MemoryStats::RemoveTexture(MemoryStats::Category::TerrainTextures, NormalMap);
+    if (NormalMap.id > 0)
+        UnloadTexture(NormalMap);
+
+    NormalMap = { 0 };
+}
+
+void TerrainTile::UpdateMemoryUsage()
+{
+    DataBytes.Set(int64_t(TerrainHeightMap.capacity() * sizeof(float)
+        + VertexOcclusion.capacity() * sizeof(uint8_t)
+        + SplatPixels.capacity() * sizeof(Color)
+        + LayerMaterials.capacity() * sizeof(const TerrainMaterial*)));
+}
@@ -0,0 +1,371 @@
+#include "raylib.h"
+#include "rlgl.h"
+
+#include "TerrainTile.h"
+#include "TerrainBuilder.h"
+#include "TerrainDrawOrder.h"
+#include "TerrainNormalBaker.h"
+#include "TerrainRender.h"
+#include "MemoryStats.h"
+
+#include "external/glad.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Headless timings for the CPU side of the terrain pipeline, nothing here needs a window or GL context.
+// The one exception is --fill, which opens a hidden window and times drawing the tiles in different orders.
+// Run it with LIBGL_ALWAYS_SOFTWARE=1 to get Mesa's software rasterizer, where the frame time follows fill rate.
+// usage: terrain_bench [--tiles N] [--grid N] [--normal-scale N] [--lod-error] [--fill FRAMES]
+
+using Clock = std::chrono::steady_clock;
+
+struct StageResult
+{
+	const char* Name = nullptr;
+	size_t Count = 0;
+	// what one unit of work is, and how many of those each iteration does
+	const char* Unit = "samples";
+	double UnitsPerIteration = 0;
+	double Milliseconds = 0;
+};
+
+double ElapsedMS(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct FillResult
+{
+	const char* Name = nullptr;
+	double Milliseconds = 0;
+};
+
+static constexpr int FillWidth = 1280;
+static constexpr int FillHeight = 720;
+
+// draws every tile at full detail from a low camera on the far edge looking back across the grid,
+// so the tile order is back to front and the ring order is what the editor submits
+std::vector<FillResult> RunFillCapture(std::vector<TerrainTile>& tiles, const TerrainInfo& info, int side, int frames)
+{
+	Image layers[3] =
+	{
+		GenImageChecked(128, 128, 32, 32, DARKGREEN, GREEN),
+		GenImageChecked(128, 128, 32, 32, DARKBROWN, BROWN),
+		GenImageChecked(128, 128, 16, 16, GRAY, LIGHTGRAY),
+	};
+
+	TerrainMaterial materials[3];
+	for (int i = 0; i < 3; i++)
+	{
+		materials[i].DiffuseMap = LoadTextureFromImage(layers[i]);
+		UnloadImage(layers[i]);
+	}
+
+	int splatSize = info.TerrainGridSize / 2 + 1;
+	Image splat = GenImageChecked(splatSize, splatSize, 4, 4, Color{ 255,0,0,0 }, Color{ 0,255,0,0 });
+
+	TileMeshBuilder builder;
+	std::vector<BoundingBox> bounds;
+	for (auto& tile : tiles)
+	{
+		tile.SetSplatFromImage(splat);
+		for (auto& material : materials)
+			tile.LayerMaterials.push_back(&material);
+
+		builder.Build(tile);
+		bounds.push_back(tile.GetBounds());
+	}
+	UnloadImage(splat);
+
+	TerainRenderer renderer;
+	if (!renderer.LoadShaderSource("resources/shaders/terrain.vs", "resources/shaders/terrain.fs"))
+	{
+		Shader shader = LoadShader(nullptr, nullptr);
+		renderer.SetShader(shader);
+	}
+
+	float extent = side * info.TerrainTileSize;
+
+	Camera3D camera = { 0 };
+	camera.position = Vector3{ extent * 0.5f, extent + info.TerrainTileSize * 0.25f, info.TerrainMaxZ + 10 };
+	camera.target = Vector3{ extent * 0.5f, 0, info.TerrainMinZ };
+	camera.up = Vector3{ 0, 0, 1 };
+	camera.fovy = 45;
+	camera.projection = CAMERA_PERSPECTIVE;
+
+	TerrainDrawOrder drawOrder;
+	drawOrder.RingSize = info.TerrainTileSize * 2;
+	drawOrder.Update(bounds, camera.position);
+
+	std::vector<uint64_t> batchKeys;
+	for (auto& tile : tiles)
+		batchKeys.push_back(renderer.GetBatchKey(tile));
+
+	std::vector<size_t> tileOrder;
+	for (size_t i = 0; i < tiles.size(); i++)
+		tileOrder.push_back(i);
+
+	std::vector<size_t> ringOrder = drawOrder.GetOrder();
+	drawOrder.SortBatches(ringOrder, batchKeys);
+
+	std::vector<size_t> backToFront(drawOrder.GetOrder().rbegin(), drawOrder.GetOrder().rend());
+
+	RenderTexture2D target = LoadRenderTexture(FillWidth, FillHeight);
+	rlSetClipPlanes(0.1f, 5000.0f);
+
+	auto drawFrames = [&](const std::vector<size_t>& order, int count)
+	{
+		for (int frame = 0; frame < count; frame++)
+		{
+			BeginTextureMode(target);
+			ClearBackground(BLACK);
+			BeginMode3D(camera);
+			for (size_t i : order)
+				renderer.Draw(tiles[i], 0);
+			EndMode3D();
+			EndTextureMode();
+		}
+
+		// the driver queues the draws, only a finish says when the pixels are done
+		glFinish();
+	};
+
+	std::vector<FillResult> results;
+	std::pair<const char*, const std::vector<size_t>*> orders[] = { { "tile_order", &tileOrder }, { "back_to_front", &backToFront }, { "ring_order", &ringOrder } };
+	for (auto& [name, order] : orders)
+	{
+		drawFrames(*order, 2);
+
+		auto start = Clock::now();
+		drawFrames(*order, frames);
+
+		FillResult result;
+		result.Name = name;
+		result.Milliseconds = ElapsedMS(start) / frames;
+		results.push_back(result);
+	}
+
+	UnloadRenderTexture(target);
+	renderer.UnloadPermutations();
+	for (auto& tile : tiles)
+	{
+		tile.UnloadGeometry();
+		tile.UnloadSplats();
+	}
+	for (auto& material : materials)
+		UnloadTexture(material.DiffuseMap);
+
+	return results;
+}
+
+void PrintStage(const StageResult& stage, bool last)
+{
+	double seconds = stage.Milliseconds / 1000.0;
+	double perSecond = seconds > 0 ? stage.Count / seconds : 0;
+
+	printf("    \"%s\": { \"count\": %zu, \"total_ms\": %.3f, \"per_item_ms\": %.4f, \"items_per_sec\": %.1f, \"%s_per_sec\": %.1f }%s\n",
+		stage.Name,
+		stage.Count,
+		stage.Milliseconds,
+		stage.Count > 0 ? stage.Milliseconds / stage.Count : 0.0,
+		perSecond,
+		stage.Unit,
+		perSecond * stage.UnitsPerIteration,
+		last ? "" : ",");
+}
+
+int main(int argc, char* argv[])
+{
+	int tileCount = 16;
+	int gridSize = 128;
+	int normalScale = 2;
+	bool lodError = false;
+	int fillFrames = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--tiles") == 0 && i + 1 < argc)
+			tileCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc)
+			gridSize = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--normal-scale") == 0 && i + 1 < argc)
+			normalScale = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--lod-error") == 0)
+			lodError = true;
+		else if (strcmp(argv[i], "--fill") == 0 && i + 1 < argc)
+			fillFrames = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "unknown argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	// 16 bit indices and 4 LODs, each halving the grid
+	int lodStep = 1 << (MaxLODLevels - 1);
+	if (tileCount < 1 || gridSize < lodStep || gridSize > 255 || gridSize % lodStep != 0 || normalScale < 1)
+	{
+		fprintf(stderr, "tiles must be > 0, grid a multiple of %d below 256 and normal scale > 0\n", lodStep);
+		return 1;
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	if (fillFrames > 0)
+	{
+		SetConfigFlags(FLAG_WINDOW_HIDDEN);
+		InitWindow(FillWidth, FillHeight, "terrain_bench");
+	}
+
+	TerrainInfo info;
+	info.TerrainGridSize = uint8_t(gridSize);
+
+	// a row of tiles, or a square for the fill capture so the camera looks across several rows
+	int side = fillFrames > 0 ? int(ceil(sqrt(double(tileCount)))) : tileCount;
+
+	// source images are made up front, generating noise is not part of the pipeline being measured
+	int imageSize = gridSize + 3;
+	std::vector<Image> heightmaps;
+	for (int i = 0; i < tileCount; i++)
+		heightmaps.push_back(GenImagePerlinNoise(imageSize, imageSize, (i % side) * gridSize - 1, (i / side) * gridSize - 1, 2));
+
+	std::vector<TerrainTile> tiles;
+	tiles.reserve(tileCount);
+	for (int i = 0; i < tileCount; i++)
+		tiles.emplace_back(info).Origin = TerrainPosition{ i % side, i / side };
+
+	std::vector<StageResult> stages;
+	double vertsPerTile = double(gridSize + 1) * (gridSize + 1);
+
+	// height import
+	{
+		StageResult stage;
+		stage.Name = "height_import";
+		stage.Count = tileCount;
+		stage.UnitsPerIteration = double(imageSize) * imageSize;
+
+		auto start = Clock::now();
+		for (int i = 0; i < tileCount; i++)
+			tiles[i].SetHeightsFromImage(heightmaps[i]);
+		stage.Milliseconds = ElapsedMS(start);
+
+		stages.push_back(stage);
+	}
+
+	for (auto& image : heightmaps)
+		UnloadImage(image);
+
+	// normal bake
+	{
+		StageResult stage;
+		stage.Name = "normal_bake";
+		stage.Count = tileCount;
+		stage.Unit = "texels";
+		stage.UnitsPerIteration = double(gridSize * normalScale + 1) * (gridSize * normalScale + 1);
+
+		size_t checksum = 0;
+		auto start = Clock::now();
+		for (int i = 0; i < tileCount; i++)
+			checksum += TerrainNormalBaker::BakeImage(tiles[i].TerrainHeightMap, info, normalScale).Pixels.size();
+		stage.Milliseconds = ElapsedMS(start);
+
+		if (checksum == 0)
+			fprintf(stderr, "normal bake produced no pixels\n");
+
+		stages.push_back(stage);
+	}
+
+	// index build, done once per grid size in the engine, repeated per tile here to get a stable time
+	size_t indexCount = 0;
+	{
+		StageResult stage;
+		stage.Name = "index_build";
+		stage.Count = tileCount;
+		stage.Unit = "indices";
+
+		TerrainLODTriangleInfo lodInfos[MaxLODLevels];
+		auto start = Clock::now();
+		for (int i = 0; i < tileCount; i++)
+			indexCount = TileMeshBuilder::BuildIndexList(gridSize, lodInfos).size();
+		stage.Milliseconds = ElapsedMS(start);
+		stage.UnitsPerIteration = double(indexCount);
+
+		stages.push_back(stage);
+	}
+
+	float maxErrors[MaxLODLevels] = { 0 };
+	if (lodError)
+	{
+		StageResult stage;
+		stage.Name = "lod_error";
+		stage.Count = tileCount;
+		stage.Unit = "vertices";
+		stage.UnitsPerIteration = vertsPerTile * (MaxLODLevels - 1);
+
+		auto start = Clock::now();
+		for (int i = 0; i < tileCount; i++)
+		{
+			float errors[MaxLODLevels];
+			TileMeshBuilder::ComputeLODErrors(tiles[i], errors);
+			for (int lod = 0; lod < MaxLODLevels; lod++)
+				maxErrors[lod] = std::max(maxErrors[lod], errors[lod]);
+		}
+		stage.Milliseconds = ElapsedMS(start);
+
+		stages.push_back(stage);
+	}
+
+	printf("{\n");
+	printf("  \"tiles\": %d,\n", tileCount);
+	printf("  \"grid\": %d,\n", gridSize);
+	printf("  \"normal_scale\": %d,\n", normalScale);
+	printf("  \"index_count\": %zu,\n", indexCount);
+	if (lodError)
+	{
+		printf("  \"lod_max_error\": [");
+		for (int lod = 0; lod < MaxLODLevels; lod++)
+			printf(" %.4f%s", maxErrors[lod], lod + 1 < MaxLODLevels ? "," : " ],\n");
+	}
+
+	printf("  \"stages\": {\n");
+	for (size_t i = 0; i < stages.size(); i++)
+		PrintStage(stages[i], i + 1 == stages.size());
+	printf("  },\n");
+
+	if (fillFrames > 0)
+	{
+		std::vector<FillResult> fill = RunFillCapture(tiles, info, side, fillFrames);
+
+		printf("  \"fill\": {\n");
+		printf("    \"renderer\": \"%s\",\n", (const char*)glGetString(GL_RENDERER));
+		printf("    \"width\": %d, \"height\": %d, \"frames\": %d,\n", FillWidth, FillHeight, fillFrames);
+		for (size_t i = 0; i < fill.size(); i++)
+			printf("    \"%s_ms\": %.3f%s\n", fill[i].Name, fill[i].Milliseconds, i + 1 < fill.size() ? "," : "");
+		printf("  },\n");
+	}
+
+	// what the tiles hold after the run, and the high water marks during it
+	printf("  \"memory\": {\n");
+	for (size_t i = 0; i < size_t(MemoryStats::Category::Count); i++)
+	{
+		MemoryStats::Category category = MemoryStats::Category(i);
+		MemoryStats::Counter counter = MemoryStats::Get(category);
+		printf("    \"%s\": { \"bytes\": %lld, \"peak_bytes\": %lld, \"allocations\": %lld }%s\n",
+			MemoryStats::GetName(category), (long long)counter.Bytes, (long long)counter.PeakBytes, (long long)counter.Allocations,
+			i + 1 < size_t(MemoryStats::Category::Count) ? "," : "");
+	}
+	printf("  }\n");
+	printf("}\n");
+
+	if (fillFrames > 0)
+		CloseWindow();
+
+	return 0;
+}
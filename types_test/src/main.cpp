@@ -2,16 +2,844 @@
 
 #include "type_database.h"
 #include "AssetManager.h"
+#include "MemoryStats.h"
+#include "list_codec.h"
 
 #include "asset_types.h"
 #include "types/test_type.h"
 #include "types/asset.h"
 #include "types/terrain.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+
 using namespace Types;
 using namespace TypeIO;
 using namespace AssetTypes;
 
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMS(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static long GetFileSize(const char* fileName)
+{
+	FILE* fp = fopen(fileName, "rb");
+	if (!fp)
+		return 0;
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fclose(fp);
+	return size;
+}
+
+//--------------------------------------------------------------
+//   Binary round trip, one field and one list of every primitive type
+//--------------------------------------------------------------
+
+template<class T>
+static bool IsSame(const T& a, const T& b) { return memcmp(&a, &b, sizeof(T)) == 0; }
+
+static bool IsSame(const std::string& a, const std::string& b) { return a == b; }
+
+template<class T>
+static void SetSample(TypeValue& value, int fieldIndex, const T& sample)
+{
+	value.SetFieldPrimitiveValue<T>(fieldIndex, sample);
+
+	auto& list = value.GetPrimitiveListFieldValue<T>(fieldIndex + 1);
+	list.PushBack(sample);
+	list.PushBack(T());
+	list.PushBack(sample);
+}
+
+template<class T>
+static bool CheckSample(TypeValue& original, TypeValue& loaded, int fieldIndex, const char* name)
+{
+	bool same = IsSame(T(original.GetFieldPrimitiveValue<T>(fieldIndex)), T(loaded.GetFieldPrimitiveValue<T>(fieldIndex)));
+
+	const auto& originalList = original.GetPrimitiveListFieldValue<T>(fieldIndex + 1).GetValues();
+	const auto& loadedList = loaded.GetPrimitiveListFieldValue<T>(fieldIndex + 1).GetValues();
+
+	same = same && originalList.size() == loadedList.size();
+	for (size_t i = 0; same && i < originalList.size(); i++)
+		same = IsSame(T(originalList[i]), T(loadedList[i]));
+
+	if (!same)
+		printf("  %s does not round trip\n", name);
+
+	return same;
+}
+
+static bool CheckBinaryRoundTrip()
+{
+	TypeInfo* type = TypeDatabase::Get().CreateType("BinaryRoundTrip");
+	type->AddPrimitiveField<bool>("Bool", false);
+	type->AddPrimitiveListField("BoolList", PrimitiveType::Bool);
+	type->AddPrimitiveField<char>("Char", 0);
+	type->AddPrimitiveListField("CharList", PrimitiveType::Char);
+	type->AddPrimitiveField<uint8_t>("UInt8", 0);
+	type->AddPrimitiveListField("UInt8List", PrimitiveType::UInt8);
+	type->AddPrimitiveField<uint16_t>("UInt16", 0);
+	type->AddPrimitiveListField("UInt16List", PrimitiveType::UInt16);
+	type->AddPrimitiveField<int16_t>("Int16", 0);
+	type->AddPrimitiveListField("Int16List", PrimitiveType::Int16);
+	type->AddPrimitiveField<uint32_t>("UInt32", 0);
+	type->AddPrimitiveListField("UInt32List", PrimitiveType::UInt32);
+	type->AddPrimitiveField<int32_t>("Int32", 0);
+	type->AddPrimitiveListField("Int32List", PrimitiveType::Int32);
+	type->AddPrimitiveField<uint64_t>("UInt64", 0);
+	type->AddPrimitiveListField("UInt64List", PrimitiveType::UInt64);
+	type->AddPrimitiveField<int64_t>("Int64", 0);
+	type->AddPrimitiveListField("Int64List", PrimitiveType::Int64);
+	type->AddPrimitiveField<float>("Float32", 0);
+	type->AddPrimitiveListField("Float32List", PrimitiveType::Float32);
+	type->AddPrimitiveField<double>("Double64", 0);
+	type->AddPrimitiveListField("Double64List", PrimitiveType::Double64);
+	type->AddPrimitiveField<std::string>("String", "");
+	type->AddPrimitiveListField("StringList", PrimitiveType::String);
+	type->AddPrimitiveField<Vector2>("Vector2", Vector2{ 0, 0 });
+	type->AddPrimitiveListField("Vector2List", PrimitiveType::Vector2);
+	type->AddPrimitiveField<Vector3>("Vector3", Vector3{ 0, 0, 0 });
+	type->AddPrimitiveListField("Vector3List", PrimitiveType::Vector3);
+	type->AddPrimitiveField<Vector4>("Vector4", Vector4{ 0, 0, 0, 0 });
+	type->AddPrimitiveListField("Vector4List", PrimitiveType::Vector4);
+	type->AddPrimitiveField<Rectangle>("Rectangle", Rectangle{ 0, 0, 0, 0 });
+	type->AddPrimitiveListField("RectangleList", PrimitiveType::Rectangle);
+	type->AddPrimitiveField<Matrix>("Matrix", Matrix{ 0 });
+	type->AddPrimitiveListField("MatrixList", PrimitiveType::Matrix);
+	type->AddPrimitiveField<Hashes::GUID>("GUID", Hashes::GUID::Invalid());
+	type->AddPrimitiveListField("GUIDList", PrimitiveType::GUID);
+	type->AddPrimitiveField<Color>("Color", Color{ 0, 0, 0, 0 });
+	type->AddPrimitiveListField("ColorList", PrimitiveType::Color);
+
+	// values JSON can not hold exactly, and extremes of each integer range
+	TypeValue original(type);
+	SetSample<bool>(original, 0, true);
+	SetSample<char>(original, 2, 'x');
+	SetSample<uint8_t>(original, 4, 255);
+	SetSample<uint16_t>(original, 6, 65535);
+	SetSample<int16_t>(original, 8, -32768);
+	SetSample<uint32_t>(original, 10, 4294967295u);
+	SetSample<int32_t>(original, 12, -2147483647 - 1);
+	SetSample<uint64_t>(original, 14, 0xFEDCBA9876543210ull);
+	SetSample<int64_t>(original, 16, -1234567890123456789ll);
+	SetSample<float>(original, 18, 0.1f);
+	SetSample<double>(original, 20, 1.0 / 3.0);
+	SetSample<std::string>(original, 22, "round \"trip\"\n");
+	SetSample<Vector2>(original, 24, Vector2{ 1.5f, -0.001f });
+	SetSample<Vector3>(original, 26, Vector3{ 1e-7f, 2.5f, -3e7f });
+	SetSample<Vector4>(original, 28, Vector4{ 0.3f, 0.6f, 0.9f, 1.2f });
+	SetSample<Rectangle>(original, 30, Rectangle{ 10.125f, 20.25f, 640.1f, 480.2f });
+	SetSample<Matrix>(original, 32, Matrix{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16.0625f });
+	SetSample<Hashes::GUID>(original, 34, Hashes::GUID::New());
+	SetSample<Color>(original, 36, Color{ 1, 2, 3, 254 });
+
+	const char* fileName = "binary_round_trip.bin";
+	BinaryTypeWriter writer;
+	if (!writer.Write(&original, fileName))
+	{
+		printf("binary round trip: could not write %s\n", fileName);
+		return false;
+	}
+
+	TypeValue loaded;
+	TypeReader reader;
+	bool ok = reader.Read(&loaded, fileName) && loaded.GetType() == type;
+	remove(fileName);
+
+	if (ok)
+	{
+		ok &= CheckSample<bool>(original, loaded, 0, "Bool");
+		ok &= CheckSample<char>(original, loaded, 2, "Char");
+		ok &= CheckSample<uint8_t>(original, loaded, 4, "UInt8");
+		ok &= CheckSample<uint16_t>(original, loaded, 6, "UInt16");
+		ok &= CheckSample<int16_t>(original, loaded, 8, "Int16");
+		ok &= CheckSample<uint32_t>(original, loaded, 10, "UInt32");
+		ok &= CheckSample<int32_t>(original, loaded, 12, "Int32");
+		ok &= CheckSample<uint64_t>(original, loaded, 14, "UInt64");
+		ok &= CheckSample<int64_t>(original, loaded, 16, "Int64");
+		ok &= CheckSample<float>(original, loaded, 18, "Float32");
+		ok &= CheckSample<double>(original, loaded, 20, "Double64");
+		ok &= CheckSample<std::string>(original, loaded, 22, "String");
+		ok &= CheckSample<Vector2>(original, loaded, 24, "Vector2");
+		ok &= CheckSample<Vector3>(original, loaded, 26, "Vector3");
+		ok &= CheckSample<Vector4>(original, loaded, 28, "Vector4");
+		ok &= CheckSample<Rectangle>(original, loaded, 30, "Rectangle");
+		ok &= CheckSample<Matrix>(original, loaded, 32, "Matrix");
+		ok &= CheckSample<Hashes::GUID>(original, loaded, 34, "GUID");
+		ok &= CheckSample<Color>(original, loaded, 36, "Color");
+	}
+
+	printf("binary round trip: %s\n", ok ? "passed" : "FAILED");
+	return ok;
+}
+
+//--------------------------------------------------------------
+//   JSON numeric lists, packed base64 and plain arrays
+//--------------------------------------------------------------
+
+static bool CheckPackedListRoundTrip()
+{
+	TypeInfo* type = TypeDatabase::Get().CreateType("PackedListRoundTrip");
+	type->AddPrimitiveField<float>("Float32", 0);
+	type->AddPrimitiveListField("Float32List", PrimitiveType::Float32)->AddAttribute<AttributeTypes::PackedListAttribute>();
+	type->AddPrimitiveField<int64_t>("Int64", 0);
+	type->AddPrimitiveListField("Int64List", PrimitiveType::Int64)->AddAttribute<AttributeTypes::PackedListAttribute>();
+	type->AddPrimitiveField<uint8_t>("UInt8", 0);
+	type->AddPrimitiveListField("UInt8List", PrimitiveType::UInt8)->AddAttribute<AttributeTypes::PackedListAttribute>();
+	type->AddPrimitiveField<int16_t>("Int16", 0);
+	type->AddPrimitiveListField("Int16List", PrimitiveType::Int16);
+	type->AddPrimitiveField<uint64_t>("UInt64", 0);
+	type->AddPrimitiveListField("UInt64List", PrimitiveType::UInt64);
+
+	// the packed float list has to keep every bit of values that have no short decimal form
+	TypeValue original(type);
+	SetSample<float>(original, 0, 0.125f);
+	original.GetPrimitiveListFieldValue<float>(1).GetValues() = { 0.1f, 1.0f / 3.0f, -3e7f, 1e-7f };
+	SetSample<int64_t>(original, 2, -1234567890123456789ll);
+	SetSample<uint8_t>(original, 4, 255);
+	original.GetPrimitiveListFieldValue<uint8_t>(5).PushBack(7);
+	SetSample<int16_t>(original, 6, -32768);
+	SetSample<uint64_t>(original, 8, 0xFEDCBA9876543210ull);
+
+	const char* fileName = "packed_round_trip.json";
+	TypeWriter writer;
+	if (!writer.Write(&original, fileName))
+	{
+		printf("packed list round trip: could not write %s\n", fileName);
+		return false;
+	}
+
+	TypeValue loaded;
+	TypeReader reader;
+	bool ok = reader.Read(&loaded, fileName) && loaded.GetType() == type;
+	remove(fileName);
+
+	if (ok)
+	{
+		ok &= CheckSample<float>(original, loaded, 0, "Float32");
+		ok &= CheckSample<int64_t>(original, loaded, 2, "Int64");
+		ok &= CheckSample<uint8_t>(original, loaded, 4, "UInt8");
+		ok &= CheckSample<int16_t>(original, loaded, 6, "Int16");
+		ok &= CheckSample<uint64_t>(original, loaded, 8, "UInt64");
+	}
+
+	printf("packed list round trip: %s\n", ok ? "passed" : "FAILED");
+	return ok;
+}
+
+//--------------------------------------------------------------
+//   JSON reals, shortest text has to read back bit exact
+//--------------------------------------------------------------
+
+template<class T, class Bits>
+static T RandomReal(std::mt19937_64& random)
+{
+	// any finite bit pattern, so every exponent and the denormals get covered
+	while (true)
+	{
+		Bits bits = Bits(random());
+		T value;
+		memcpy(&value, &bits, sizeof(T));
+		if (std::isfinite(value))
+			return value;
+	}
+}
+
+static bool CheckRealRoundTrip(int count)
+{
+	TypeInfo* type = TypeDatabase::Get().CreateType("RealRoundTrip");
+	type->AddPrimitiveField<float>("Float32", 0);
+	type->AddPrimitiveListField("Float32List", PrimitiveType::Float32);
+	type->AddPrimitiveField<double>("Double64", 0);
+	type->AddPrimitiveListField("Double64List", PrimitiveType::Double64);
+	type->AddPrimitiveField<Vector3>("Vector3", Vector3{ 0, 0, 0 });
+	type->AddPrimitiveListField("Vector3List", PrimitiveType::Vector3);
+	type->AddPrimitiveField<Matrix>("Matrix", Matrix{ 0 });
+	type->AddPrimitiveListField("MatrixList", PrimitiveType::Matrix);
+
+	TypeValue original(type);
+	SetSample<float>(original, 0, 0.1f);
+	SetSample<double>(original, 2, 1.0 / 3.0);
+	SetSample<Vector3>(original, 4, Vector3{ -0.0f, 16777216.0f, 1e-7f });
+	SetSample<Matrix>(original, 6, Matrix{ 0.3f, std::numeric_limits<float>::max(), std::numeric_limits<float>::denorm_min(), -3e7f,
+		std::numeric_limits<float>::min(), 1.0f / 3.0f, 100.001f, 4, 5, 6, 7, 8, 9, 10, 11, 12 });
+
+	std::mt19937_64 random(44);
+	auto& floats = original.GetPrimitiveListFieldValue<float>(1).GetValues();
+	auto& doubles = original.GetPrimitiveListFieldValue<double>(3).GetValues();
+	floats.push_back(std::numeric_limits<float>::lowest());
+	doubles.push_back(std::numeric_limits<double>::denorm_min());
+	doubles.push_back(-std::numeric_limits<double>::max());
+	for (int i = 0; i < count; i++)
+	{
+		floats.push_back(RandomReal<float, uint32_t>(random));
+		doubles.push_back(RandomReal<double, uint64_t>(random));
+	}
+
+	const char* fileName = "real_round_trip.json";
+	TypeWriter writer;
+	auto start = Clock::now();
+	if (!writer.Write(&original, fileName))
+	{
+		printf("real round trip: could not write %s\n", fileName);
+		return false;
+	}
+	double writeMS = ElapsedMS(start);
+
+	TypeValue loaded;
+	TypeReader reader;
+	start = Clock::now();
+	bool ok = reader.Read(&loaded, fileName) && loaded.GetType() == type;
+	double readMS = ElapsedMS(start);
+	remove(fileName);
+
+	if (ok)
+	{
+		ok &= CheckSample<float>(original, loaded, 0, "Float32");
+		ok &= CheckSample<double>(original, loaded, 2, "Double64");
+		ok &= CheckSample<Vector3>(original, loaded, 4, "Vector3");
+		ok &= CheckSample<Matrix>(original, loaded, 6, "Matrix");
+	}
+
+	printf("real round trip: %s, %d random floats and doubles, write %.2f ms read %.2f ms\n", ok ? "passed" : "FAILED", count, writeMS, readMS);
+	return ok;
+}
+
+//--------------------------------------------------------------
+//   JSON against binary on a terrain sized asset
+//--------------------------------------------------------------
+
+static void FillBenchmarkTerrain(TerrainAsset& terrain, int tileCount, int gridSize)
+{
+	int verts = (gridSize + 1) * (gridSize + 1);
+
+	auto tiles = terrain.GetTiles();
+	for (int t = 0; t < tileCount; t++)
+	{
+		TerrainTile tile = tiles.PushBack();
+		tile.GetOrigin().SetX(t);
+
+		auto& heights = tile.GetHeightmap().GetValues();
+		heights.resize(verts);
+		for (int i = 0; i < verts; i++)
+			heights[i] = 40.0f * sinf(i * 0.013f + t) + 7.0f * cosf(i * 0.071f);
+
+		// one painted patch per layer, the rest of it unpainted like most real splats
+		TerrainSplatmap layer = tile.GetLayers().PushBack();
+		layer.SetMaterial(uint16_t(t));
+		auto& splat = layer.GetValues().GetValues();
+		splat.resize(verts);
+		float center = gridSize * (0.3f + 0.4f * ((t * 7) % 10) / 10.0f);
+		for (int i = 0; i < verts; i++)
+		{
+			float x = float(i % (gridSize + 1)) - center;
+			float y = float(i / (gridSize + 1)) - center;
+			float weight = 1.0f - sqrtf(x * x + y * y) / (gridSize * 0.25f);
+			splat[i] = uint8_t(std::clamp(weight * 2.0f, 0.0f, 1.0f) * 255.0f);
+		}
+	}
+}
+
+// largest difference between two heightmaps, infinite when they do not have the same size
+static float GetHeightError(const std::vector<float>& aHeights, const std::vector<float>& bHeights)
+{
+	if (aHeights.size() != bHeights.size())
+		return std::numeric_limits<float>::infinity();
+
+	float error = 0;
+	for (size_t i = 0; i < aHeights.size(); i++)
+		error = std::max(error, fabsf(aHeights[i] - bHeights[i]));
+	return error;
+}
+
+static void BenchmarkTerrainIO(int tileCount, int gridSize)
+{
+	TerrainAsset terrain;
+	FillBenchmarkTerrain(terrain, tileCount, gridSize);
+	auto tiles = terrain.GetTiles();
+
+	struct Result
+	{
+		const char* Name = nullptr;
+		const char* File = nullptr;
+		double WriteMS = 0;
+		double ReadMS = 0;
+		long Size = 0;
+		float HeightError = std::numeric_limits<float>::infinity();
+		ListCodecStats Codec;
+	};
+
+	Result results[4];
+	results[0].Name = "json";
+	results[0].File = "bench_terrain.json";
+	results[1].Name = "compact";
+	results[1].File = "bench_terrain_compact.json";
+	results[2].Name = "binary";
+	results[2].File = "bench_terrain.bin";
+	results[3].Name = "compressed";
+	results[3].File = "bench_terrain_compressed.bin";
+
+	for (int i = 0; i < 4; i++)
+	{
+		Result& result = results[i];
+
+		auto start = Clock::now();
+		if (i < 2)
+		{
+			TypeWriter writer;
+			writer.Compact = i == 1;
+			writer.Write(terrain.ValuePtr, result.File);
+		}
+		else
+		{
+			BinaryTypeWriter writer;
+			writer.CompressLists = i == 3;
+			writer.Write(terrain.ValuePtr, result.File);
+		}
+		result.WriteMS = ElapsedMS(start);
+		result.Size = GetFileSize(result.File);
+
+		// every tile is read up front so the formats compare like for like
+		TypeValue loaded;
+		TypeReader reader;
+		reader.DeferLazyLists = false;
+		start = Clock::now();
+		reader.Read(&loaded, result.File);
+		result.ReadMS = ElapsedMS(start);
+		result.Codec = reader.Stats;
+
+		if (loaded.GetType() == terrain.TypePtr)
+		{
+			TerrainAsset loadedTerrain(&loaded);
+			auto loadedTiles = loadedTerrain.GetTiles();
+
+			if (loadedTiles.Size() == tiles.Size())
+			{
+				result.HeightError = 0;
+				for (size_t t = 0; t < tiles.Size(); t++)
+					result.HeightError = std::max(result.HeightError, GetHeightError(loadedTiles[t].GetHeightmap().GetValues(), tiles[t].GetHeightmap().GetValues()));
+			}
+		}
+
+		remove(result.File);
+	}
+
+	printf("terrain io, %d tiles of %d grid\n", tileCount, gridSize);
+	for (const Result& result : results)
+	{
+		double megabytes = result.Size / (1024.0 * 1024.0);
+		char heights[32] = "exact";
+		if (result.HeightError != 0)
+			snprintf(heights, sizeof(heights), "differ by %.5f", result.HeightError);
+
+		printf("  %-10s %8.2f MB  write %8.2f ms (%7.1f MB/s)  read %8.2f ms (%7.1f MB/s)  heights %s\n",
+			result.Name, megabytes,
+			result.WriteMS, megabytes / (result.WriteMS / 1000.0),
+			result.ReadMS, megabytes / (result.ReadMS / 1000.0),
+			heights);
+	}
+	const ListCodecStats& codec = results[3].Codec;
+	printf("  compressed %zu lists from %.2f to %.2f MB (%.1fx), decoded at %.0f MB/s\n",
+		codec.Lists, codec.RawBytes / (1024.0 * 1024.0), codec.EncodedBytes / (1024.0 * 1024.0),
+		codec.GetRatio(), codec.GetDecodeSpeed());
+	printf("  against json, binary is %.1fx smaller and reads in %.2fx the time, compressed is %.1fx smaller and reads in %.2fx the time\n",
+		double(results[0].Size) / std::max(results[2].Size, 1l),
+		results[2].ReadMS / std::max(results[0].ReadMS, 0.001),
+		double(results[0].Size) / std::max(results[3].Size, 1l),
+		results[3].ReadMS / std::max(results[0].ReadMS, 0.001));
+}
+
+//--------------------------------------------------------------
+//   Lazily loaded terrain tiles
+//--------------------------------------------------------------
+
+static bool IsSameTile(TerrainTile a, TerrainTile b)
+{
+	if (a.GetOrigin().GetX() != b.GetOrigin().GetX() || GetHeightError(a.GetHeightmap().GetValues(), b.GetHeightmap().GetValues()) != 0)
+		return false;
+
+	if (a.GetLayers().Size() != b.GetLayers().Size())
+		return false;
+
+	for (size_t l = 0; l < a.GetLayers().Size(); l++)
+	{
+		if (a.GetLayers()[l].GetValues().GetValues() != b.GetLayers()[l].GetValues().GetValues())
+			return false;
+	}
+	return true;
+}
+
+// fills in part of an element and then gives up, the way a read past the end of a truncated file does
+class TruncatedTileSource : public TypeListSource
+{
+public:
+	bool LoadElement(size_t sourceIndex, TypeValue* value) override
+	{
+		TerrainTile(value).GetHeightmap().GetValues().push_back(1.0f);
+		return sourceIndex != 0;
+	}
+};
+
+static bool CheckLazyTiles(int tileCount, int gridSize)
+{
+	TerrainAsset terrain;
+	FillBenchmarkTerrain(terrain, tileCount, gridSize);
+	auto tiles = terrain.GetTiles();
+
+	const char* fileName = "lazy_tiles.terrain";
+	const char* resavedName = "lazy_tiles_resaved.terrain";
+	if (!terrain.Write(fileName))
+	{
+		printf("lazy tiles: could not write %s\n", fileName);
+		return false;
+	}
+
+	TypeValue eager;
+	TypeReader eagerReader;
+	eagerReader.DeferLazyLists = false;
+	auto start = Clock::now();
+	bool ok = eagerReader.Read(&eager, fileName);
+	double eagerMS = ElapsedMS(start);
+
+	int64_t nodeBytes = MemoryStats::Get(MemoryStats::Category::TypeValues).Bytes;
+	TypeValue lazy;
+	start = Clock::now();
+	ok &= TypeReader().Read(&lazy, fileName);
+	double openMS = ElapsedMS(start);
+	nodeBytes = MemoryStats::Get(MemoryStats::Category::TypeValues).Bytes - nodeBytes;
+
+	TerrainAsset lazyTerrain(&lazy);
+	auto lazyTiles = lazyTerrain.GetTiles();
+	ok &= lazyTiles.Size() == tiles.Size() && lazyTiles.ValueList.GetPendingCount() == tiles.Size();
+
+	// one tile from the middle, the rest stay in the file
+	size_t middle = tiles.Size() / 2;
+	start = Clock::now();
+	ok &= IsSameTile(lazyTiles[middle], tiles[middle]);
+	double tileMS = ElapsedMS(start);
+	ok &= lazyTiles.IsLoaded(middle) && lazyTiles.ValueList.GetPendingCount() == tiles.Size() - 1;
+
+	// removing a pending tile keeps the others pointing at the right data
+	lazyTiles.ValueList.Delete(0);
+	ok &= lazyTiles.Size() == tiles.Size() - 1 && IsSameTile(lazyTiles[lazyTiles.Size() - 1], tiles[tiles.Size() - 1]);
+
+	// saving reads whatever is still pending before the file is touched
+	ok &= lazyTerrain.Write(resavedName);
+	TypeValue resaved;
+	ok &= eagerReader.Read(&resaved, resavedName);
+	TerrainAsset resavedTerrain(&resaved);
+	auto resavedTiles = resavedTerrain.GetTiles();
+	ok &= resavedTiles.Size() == tiles.Size() - 1;
+	for (size_t t = 0; ok && t < resavedTiles.Size(); t++)
+		ok &= IsSameTile(resavedTiles[t], tiles[t + 1]);
+
+	// an element that fails to read comes back empty rather than half filled, and the list remembers it
+	TypeListValue truncated(TypeDatabase::Get().FindType(TerrainTile::TypeName));
+	truncated.SetSource(std::make_unique<TruncatedTileSource>(), 2);
+	ok &= !truncated.HasLoadFailed() && TerrainTile(&truncated.Get(1)).GetHeightmap().Size() == 1 && !truncated.HasLoadFailed();
+	ok &= TerrainTile(&truncated.Get(0)).GetHeightmap().Size() == 0 && truncated.HasLoadFailed() && truncated.GetPendingCount() == 0;
+
+	remove(fileName);
+	remove(resavedName);
+
+	printf("lazy tiles: %s, %d tiles of %d grid, full read %.2f ms, open %.2f ms (%s of nodes), one tile %.3f ms\n",
+		ok ? "passed" : "FAILED", tileCount, gridSize, eagerMS, openMS, MemoryStats::FormatBytes(nodeBytes).c_str(), tileMS);
+	return ok;
+}
+
+static bool CheckCompressedLists()
+{
+	TerrainAsset terrain;
+	auto tiles = terrain.GetTiles();
+
+	// a smooth square grid is kept exact, a ragged list holding a NaN has to be stored raw
+	auto& grid = tiles.PushBack().GetHeightmap().GetValues();
+	for (int y = 0; y < 65; y++)
+		for (int x = 0; x < 65; x++)
+			grid.push_back(sinf(x * 0.1f) * 30.0f + y * 0.5f);
+
+	auto& ragged = tiles.PushBack().GetHeightmap().GetValues();
+	for (int i = 0; i < 100; i++)
+		ragged.push_back(i == 40 ? NAN : i * 0.37f);
+
+	// bytes are always exact, noise included
+	TerrainTile splatTile = tiles.PushBack();
+	std::mt19937 random(7);
+	for (int l = 0; l < 2; l++)
+	{
+		auto& splat = splatTile.GetLayers().PushBack().GetValues().GetValues();
+		for (int i = 0; i < 4096; i++)
+			splat.push_back(l == 0 ? uint8_t(random()) : uint8_t(i < 1000 ? 255 : 0));
+	}
+
+	const char* fileName = "compressed_lists.bin";
+	BinaryTypeWriter writer;
+	writer.CompressLists = true;
+	bool ok = writer.Write(terrain.ValuePtr, fileName);
+	ok &= writer.Stats.Lists == 3;
+
+	TypeValue loaded;
+	BinaryTypeReader reader;
+	reader.DeferLazyLists = false;
+	ok &= reader.Read(&loaded, fileName) && loaded.GetType() == terrain.TypePtr;
+	remove(fileName);
+	if (!ok)
+	{
+		printf("compressed lists: FAILED to write or read\n");
+		return false;
+	}
+
+	TerrainAsset loadedTerrain(&loaded);
+	auto loadedTiles = loadedTerrain.GetTiles();
+	ok &= loadedTiles.Size() == tiles.Size() && reader.Stats.Lists == 3;
+	const auto& loadedGrid = loadedTiles[0].GetHeightmap().GetValues();
+	ok &= ok && loadedGrid.size() == grid.size() && memcmp(loadedGrid.data(), grid.data(), grid.size() * sizeof(float)) == 0;
+
+	const auto& loadedRagged = loadedTiles[1].GetHeightmap().GetValues();
+	ok &= ok && loadedRagged.size() == ragged.size() && memcmp(loadedRagged.data(), ragged.data(), ragged.size() * sizeof(float)) == 0;
+	ok &= ok && IsSameTile(loadedTiles[2], tiles[2]);
+
+	// quantizing is opt in, it stays within half a step of the list's own range
+	std::vector<uint8_t> quantizedCoded;
+	std::vector<float> quantized;
+	ok &= ListCodec::EncodeFloats(grid, 16, quantizedCoded) && ListCodec::DecodeFloats(quantizedCoded.data(), quantizedCoded.size(), quantized);
+
+	auto gridRange = std::minmax_element(grid.begin(), grid.end());
+	ok &= ok && GetHeightError(quantized, grid) <= (*gridRange.second - *gridRange.first) / 65535.0f * 0.5f + 1e-5f;
+
+	printf("compressed lists: %s, %zu lists from %zu to %zu bytes\n",
+		ok ? "passed" : "FAILED", writer.Stats.Lists, writer.Stats.RawBytes, writer.Stats.EncodedBytes);
+	return ok;
+}
+
+//--------------------------------------------------------------
+//   Opening and closing a large terrain through the asset manager, arena against heap nodes
+//--------------------------------------------------------------
+
+static void BenchmarkAssetLifetime(int tileCount, int gridSize, int passes)
+{
+	const char* fileName = "lifetime_terrain.terrain";
+	{
+		TerrainAsset terrain;
+		FillBenchmarkTerrain(terrain, tileCount, gridSize);
+		terrain.Write(fileName);
+	}
+
+	double loadMS[2] = { 0, 0 };
+	double closeMS[2] = { 0, 0 };
+	int64_t nodeBytes[2] = { 0, 0 };
+	size_t arenaBytes = 0;
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (int arena = 0; arena < 2; arena++)
+		{
+			int64_t startBytes = MemoryStats::Get(MemoryStats::Category::TypeValues).Bytes;
+
+			auto start = Clock::now();
+			auto value = std::make_unique<TypeValue>();
+			TypeReader reader;
+			reader.UseArena = arena == 1;
+			reader.DeferLazyLists = false;
+			reader.Read(value.get(), fileName);
+			if (arena == 1)
+				arenaBytes = value->GetArena()->GetReservedBytes();
+
+			auto asset = std::make_unique<TerrainAsset>(std::move(value));
+			asset->SetPath(fileName);
+			TerrainAsset* opened = asset.get();
+			AssetSystem::AssetManager::StoreAsset(fileName, std::move(asset));
+			loadMS[arena] += ElapsedMS(start);
+			nodeBytes[arena] = MemoryStats::Get(MemoryStats::Category::TypeValues).Bytes - startBytes;
+
+			start = Clock::now();
+			AssetSystem::AssetManager::CloseAsset(opened);
+			closeMS[arena] += ElapsedMS(start);
+		}
+	}
+	remove(fileName);
+
+	printf("asset lifetime, %d tiles of %d grid (%s of heap nodes, %s of arena nodes in %s of chunks)\n", tileCount, gridSize,
+		MemoryStats::FormatBytes(nodeBytes[0]).c_str(), MemoryStats::FormatBytes(nodeBytes[1]).c_str(), MemoryStats::FormatBytes(int64_t(arenaBytes)).c_str());
+	printf("  heap   load %8.2f ms  close %8.2f ms\n", loadMS[0] / passes, closeMS[0] / passes);
+	printf("  arena  load %8.2f ms  close %8.2f ms, closes %.1fx faster\n", loadMS[1] / passes, closeMS[1] / passes,
+		closeMS[0] / std::max(closeMS[1], 0.001));
+}
+
+static bool CheckEventPaths()
+{
+	TerrainAsset terrain;
+	auto tiles = terrain.GetTiles();
+	tiles.PushBack();
+	tiles.PushBack();
+	TerrainTile tile = tiles[1];
+
+	Tokens::TokenSource tokens;
+	FieldPath rootPath;
+	FieldPath tilePath;
+	terrain.ValuePtr->OnValueChanged.Add([&](const ValueChangedEvent& event) { rootPath = event.Path; }, tokens.GetToken());
+	tile.ValuePtr->OnValueChanged.Add([&](const ValueChangedEvent& event) { tilePath = event.Path; }, tokens.GetToken());
+
+	// every level is told the path from itself
+	tile.GetOrigin().SetX(5);
+	FieldPath expectedTilePath = FieldPath(FieldPath::Field(0)) + FieldPath::Field(0);
+	FieldPath expectedRootPath = FieldPath(FieldPath::Field(3)) + FieldPath::Index(1) + expectedTilePath;
+	bool ok = tilePath == expectedTilePath && rootPath == expectedRootPath;
+
+	// nothing is sent while suppressed, and the change still lands
+	rootPath = FieldPath();
+	{
+		ValueChangedEvent::SuppressScope suppress;
+		tile.GetOrigin().SetX(6);
+	}
+	ok &= rootPath.Elements.empty() && tile.GetOrigin().GetX() == 6;
+
+	// deeper than the inline elements, and put in front of itself
+	FieldPath deep;
+	for (int i = 0; i < 20; i++)
+		deep += FieldPath::Index(i);
+
+	FieldPath doubled = deep;
+	doubled.PushFront(doubled);
+	ok &= doubled.Elements.size() == 40 && deep.Elements.size() == 20;
+	for (size_t i = 0; ok && i < doubled.Elements.size(); i++)
+		ok &= doubled.Elements[i].Index == int(i % 20);
+
+	FieldPath moved = std::move(doubled);
+	ok &= moved.Elements.size() == 40 && moved.Elements.back().Index == 19;
+
+	printf("event paths: %s\n", ok ? "passed" : "FAILED");
+	return ok;
+}
+
+//--------------------------------------------------------------
+//   Field getters and setters, the path wrappers and the property grid take on every access
+//--------------------------------------------------------------
+
+static void BenchmarkFieldAccess(int iterations)
+{
+	TerrainAsset terrain;
+	TerrainInfo info = terrain.GetInfo();
+
+	// one default and one overridden field
+	info.SetGridSize(64);
+	uint64_t sum = 0;
+	auto start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+		sum += info.GetGridSize() + uint64_t(info.GetMaxZ());
+	double getNS = ElapsedMS(start) * 1e6 / (iterations * 2.0);
+
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+		info.SetTileSize(float(i));
+	double setNS = ElapsedMS(start) * 1e6 / iterations;
+
+	// the same with a listener on the root, which gets a record for every change
+	Tokens::TokenSource tokens;
+	terrain.ValuePtr->OnValueChanged.Add([&](const ValueChangedEvent& event) { sum += event.Path.Elements.size(); }, tokens.GetToken());
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+		info.SetTileSize(float(i));
+	double heardSetNS = ElapsedMS(start) * 1e6 / iterations;
+	terrain.ValuePtr->OnValueChanged.Remove(tokens.GetToken());
+
+	int valueCount = std::max(iterations / 100, 1);
+	start = Clock::now();
+	for (int i = 0; i < valueCount; i++)
+	{
+		TerrainPosition position = TypeDatabase::Get().CreateTypeValue<TerrainPosition>();
+		position.SetX(i);
+		position.SetY(-i);
+		sum += uint64_t(position.GetX() - position.GetY());
+	}
+	double createNS = ElapsedMS(start) * 1e6 / valueCount;
+
+	printf("field access: get %.1f ns, set %.1f ns (%.1f ns with a listener), new value with two fields set %.1f ns (%llu)\n",
+		getNS, setNS, heardSetNS, createNS, (unsigned long long)(sum & 0xFF));
+}
+
+//--------------------------------------------------------------
+//   A directory of terrain and material assets, mapped against buffered reads
+//--------------------------------------------------------------
+
+static void WriteBenchmarkAssets(const char* directory, int terrainCount, int materialCount)
+{
+	MakeDirectory(directory);
+
+	for (int i = 0; i < terrainCount; i++)
+	{
+		TerrainAsset terrain;
+		FillBenchmarkTerrain(terrain, 4, 128);
+		TypeWriter().Write(terrain.ValuePtr, TextFormat("%s/terrain_%d.terrain", directory, i));
+	}
+
+	for (int i = 0; i < materialCount; i++)
+	{
+		auto material = TypeDatabase::Get().CreateTypeValue<TerrainMaterialAsset>();
+		material.SetCategory(TextFormat("Category %d", i % 4));
+		TypeWriter().Write(material.ValuePtr, TextFormat("%s/material_%d.terrainMaterial", directory, i));
+	}
+}
+
+static void BenchmarkAssetLoading(const char* directory, int passes)
+{
+	FilePathList files = LoadDirectoryFilesEx(directory, ".terrain;.terrainMaterial", false);
+
+	long totalSize = 0;
+	for (unsigned int i = 0; i < files.count; i++)
+		totalSize += GetFileSize(files.paths[i]);
+
+	// pass 0 warms the file cache and is not counted, the two modes alternate after that
+	double readMS[2] = { 0, 0 };
+	int failures = 0;
+	for (int pass = 0; pass <= passes; pass++)
+	{
+		for (int mapped = 0; mapped < 2; mapped++)
+		{
+			auto start = Clock::now();
+			for (unsigned int i = 0; i < files.count; i++)
+			{
+				TypeValue value;
+				TypeReader reader;
+				reader.MapFile = mapped == 1;
+				if (!reader.Read(&value, files.paths[i]))
+					failures++;
+			}
+
+			if (pass > 0)
+				readMS[mapped] += ElapsedMS(start);
+		}
+	}
+
+	printf("asset loading, %u files (%.2f MB) from %s\n", files.count, totalSize / (1024.0 * 1024.0), directory);
+	printf("  buffered %8.2f ms  mapped %8.2f ms per pass, mapped is %.2fx faster%s\n",
+		readMS[0] / std::max(passes, 1), readMS[1] / std::max(passes, 1),
+		readMS[0] / std::max(readMS[1], 0.001),
+		failures > 0 ? ", SOME FILES FAILED TO LOAD" : "");
+
+	UnloadDirectoryFiles(files);
+}
+
+static void RemoveBenchmarkAssets(const char* directory)
+{
+	FilePathList files = LoadDirectoryFiles(directory);
+	for (unsigned int i = 0; i < files.count; i++)
+		remove(files.paths[i]);
+	UnloadDirectoryFiles(files);
+
+	remove(directory);
+}
+
 int main(int argc, char* argv[])
 {
 	AssetTypes::RegisterTypes();
@@ -22,5 +850,31 @@ int main(int argc, char* argv[])
 	auto matAsset = TypeDatabase::Get().CreateTypeValue<AssetTypes::TerrainMaterialAsset>();
 
 	auto path = matAsset.GetPath();
-	return 0;
+
+	bool ok = CheckBinaryRoundTrip();
+	ok &= CheckPackedListRoundTrip();
+	ok &= CheckRealRoundTrip(100000);
+	ok &= CheckCompressedLists();
+	ok &= CheckEventPaths();
+	BenchmarkFieldAccess(1000000);
+
+	int tileCount = argc > 1 ? atoi(argv[1]) : 16;
+	BenchmarkTerrainIO(std::max(tileCount, 1), 128);
+	ok &= CheckLazyTiles(256, 128);
+	BenchmarkAssetLifetime(256, 128, 5);
+
+	// an asset folder can be given to load, otherwise one is generated
+	if (argc > 2)
+	{
+		BenchmarkAssetLoading(argv[2], 5);
+	}
+	else
+	{
+		const char* assetDirectory = "bench_assets";
+		WriteBenchmarkAssets(assetDirectory, 8, 64);
+		BenchmarkAssetLoading(assetDirectory, 5);
+		RemoveBenchmarkAssets(assetDirectory);
+	}
+
+	return ok ? 0 : 1;
 }